@@ -0,0 +1,76 @@
+#ifndef BACKUP_CODEC_H
+#define BACKUP_CODEC_H
+
+#include <Arduino.h>
+
+// LZR: streaming run-length + LZ77 encoding for mostly-empty FRAM images.
+// Fixed memory on both sides (no heap); input and output can be fed in any
+// piece size, so FRAM is compressed while it is being read.
+//
+// Stream = sequence of tokens, lengths/distances are LEB128 varints:
+//   0x00 len  bytes[len]     literal bytes
+//   0x01 len  value          `value` repeated len times
+//   0x02 len  dist           copy len bytes from dist bytes back (may overlap)
+#define LZR_TOKEN_LITERAL       0x00
+#define LZR_TOKEN_RUN           0x01
+#define LZR_TOKEN_MATCH         0x02
+
+#define LZR_WINDOW_SIZE         1024        // Match history (bytes)
+#define LZR_LOOKAHEAD           256         // Input read ahead of the encoder position
+#define LZR_MIN_MATCH           4
+#define LZR_MAX_MATCH           LZR_LOOKAHEAD
+#define LZR_MIN_RUN             4
+#define LZR_MAX_LITERAL         128
+#define LZR_HASH_BITS           9
+
+// Pull up to len raw bytes; return 0 at end of input
+typedef size_t (*LzrSource)(uint8_t* buf, size_t len, void* ctx);
+// Consume len decoded bytes; return false to abort decoding
+typedef bool (*LzrSink)(const uint8_t* data, size_t len, void* ctx);
+
+struct LzrEncoder {
+    LzrSource source;
+    void* source_ctx;
+    uint8_t buf[LZR_WINDOW_SIZE + LZR_LOOKAHEAD];   // history | lookahead
+    size_t pos;                     // Encoder position in buf
+    size_t end;                     // Valid bytes in buf
+    uint32_t base;                  // Stream offset of buf[0]
+    uint32_t head[1 << LZR_HASH_BITS];  // Last stream offset + 1 per 3-byte hash
+    bool input_done;
+    uint8_t literal[LZR_MAX_LITERAL];
+    size_t literal_len;
+    uint8_t run_value;
+    uint32_t run_len;
+    uint8_t out[LZR_MAX_LITERAL + 32];  // Encoded tokens not yet handed out
+    size_t out_len;
+    size_t out_pos;
+    uint32_t raw_bytes;
+    uint32_t encoded_bytes;
+};
+
+struct LzrDecoder {
+    LzrSink sink;
+    void* sink_ctx;
+    uint8_t window[LZR_WINDOW_SIZE];
+    uint8_t out[64];
+    size_t out_len;
+    uint8_t state;
+    uint8_t tag;
+    uint8_t shift;
+    uint32_t value;                 // Varint being assembled
+    uint32_t len;
+    uint32_t total;                 // Bytes decoded so far
+    bool error;
+};
+
+void lzrEncoderInit(LzrEncoder& enc, LzrSource source, void* ctx);
+// Fill out with up to cap encoded bytes; returns 0 once the stream is complete
+size_t lzrEncodeRead(LzrEncoder& enc, uint8_t* out, size_t cap);
+
+void lzrDecoderInit(LzrDecoder& dec, LzrSink sink, void* ctx);
+// Feed encoded bytes; false on a malformed stream or sink failure
+bool lzrDecodeWrite(LzrDecoder& dec, const uint8_t* data, size_t len);
+// Flush output; false if the stream ended in the middle of a token
+bool lzrDecodeFinish(LzrDecoder& dec);
+
+#endif // BACKUP_CODEC_H
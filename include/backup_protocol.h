@@ -0,0 +1,69 @@
+#ifndef BACKUP_PROTOCOL_H
+#define BACKUP_PROTOCOL_H
+
+#include <Arduino.h>
+#include "fram_programmer.h"
+
+// Binary framed backup stream (device -> host)
+//
+// Frame:   SYNC0 SYNC1 | type(1) | seq(2 LE) | len(2 LE) | payload(len) | crc32(4 LE)
+//          CRC-32 covers type, seq, len and payload.
+// Frames:  seq 0 = 'H' header, seq 1..n = 'D' data, seq n+1 = 'E' end.
+//
+// Header payload: "FRBK" | version(1) | encoding(1) | start addr(2 LE) |
+//                 image size(4 LE) | max payload(2 LE) | window(1)
+// End payload:    payload bytes sent(4 LE) | image bytes(4 LE) | SHA-256 of image(32)
+//
+// Flow control (host -> device, 3 bytes each), go-back-N over a window of frames:
+//   'A' seq(2 LE)  - cumulative ack, every frame up to seq received intact
+//   'N' seq(2 LE)  - resend everything from seq
+//   'X' 0 0        - abort
+// Unacknowledged frames are resent after BACKUP_ACK_TIMEOUT_MS.
+#define BACKUP_FRAME_SYNC0          0xA5
+#define BACKUP_FRAME_SYNC1          0x5A
+#define BACKUP_FRAME_HEADER         'H'
+#define BACKUP_FRAME_DATA           'D'
+#define BACKUP_FRAME_END            'E'
+#define BACKUP_FRAME_PAYLOAD        2048        // Max payload bytes per frame
+#define BACKUP_FRAME_OVERHEAD       11          // sync + type + seq + len + crc
+#define BACKUP_WINDOW               4           // Frames in flight before waiting for an ack
+#define BACKUP_ACK_TIMEOUT_MS       1000
+#define BACKUP_MAX_RETRIES          5
+#define BACKUP_PROTOCOL_VERSION     1
+#define BACKUP_MAGIC                "FRBK"
+
+// Payload encodings announced in the header
+#define BACKUP_ENCODING_RAW         0
+#define BACKUP_ENCODING_LZR         1           // Data frames carry one LZR stream (backup_codec.h)
+
+// Stream FRAM [start, start + size) as a framed binary backup.
+// Prints a text summary (throughput, retransmits) once the host has acked the end frame.
+bool sendFramedBackup(uint16_t start, size_t size, uint8_t encoding);
+
+// Text variant of the LZR encoding: BACKUP_START / SIZE: / ENCODING:LZR /
+// ZDATA:<hex> lines / BACKUP_END, followed by the compression ratio.
+bool sendCompressedHexBackup(uint16_t start, size_t size);
+
+// Incremental backup: the host supplies the per-block digests of a previous
+// backup and only blocks whose digest changed are sent (as ADDR:/DATA: lines).
+// Digest = first BACKUP_INC_DIGEST_SIZE bytes of SHA-256 over the block.
+#define BACKUP_INC_DIGEST_SIZE      8
+#define BACKUP_INC_MIN_BLOCK        64
+#define BACKUP_INC_MAX_BLOCK        4096
+#define BACKUP_INC_DEFAULT_BLOCK    256
+#define BACKUP_INC_MAX_BLOCKS       (FRAM_SIZE / BACKUP_INC_MIN_BLOCK)
+
+struct BlockManifest {
+    size_t block_size;
+    size_t block_count;
+    uint8_t digests[BACKUP_INC_MAX_BLOCKS][BACKUP_INC_DIGEST_SIZE];
+    bool present[BACKUP_INC_MAX_BLOCKS];
+};
+
+bool initManifest(BlockManifest& manifest, size_t block_size);
+// Accepts "BLOCK_SIZE:<n>" and "DIGEST:<index hex>:<digest hex>" lines from a previous backup
+bool parseManifestLine(const String& line, BlockManifest& manifest);
+// Emits the new manifest (DIGEST: lines for every block) plus the changed blocks
+bool sendIncrementalBackup(const BlockManifest& previous);
+
+#endif // BACKUP_PROTOCOL_H
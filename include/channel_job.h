@@ -0,0 +1,42 @@
+#ifndef CHANNEL_JOB_H
+#define CHANNEL_JOB_H
+
+#include <Arduino.h>
+#include "fram_programmer.h"
+#include "credential_record.h"
+#include "fram_bus.h"
+
+// One dual-channel operation on one chip, independent of the bus behind it.
+// runChannelPair() runs channel 0 on the calling core and channel 1 on core 1.
+#define DUAL_CHANNEL_COUNT      2
+
+enum DualOperation {
+    DUAL_PROGRAM,
+    DUAL_BACKUP,
+    DUAL_VERIFY
+};
+
+struct ChannelResult {
+    bool present;
+    bool ok;
+    unsigned long elapsed_us;
+    uint32_t crc;                   // Image CRC32 (backup only)
+};
+
+// Everything one channel needs to run independently on its core
+struct ChannelJob {
+    FramBus* bus;
+    DualOperation op;
+    const DeviceCredentials* record;    // DUAL_PROGRAM input
+    CredentialRecord* staging;          // Work record, kept off the (small) core 1 stack
+    uint8_t* image;                     // FRAM_SIZE bytes, filled by DUAL_BACKUP
+    ChannelResult* result;
+};
+
+void runChannelJob(void* arg);                  // A Core1Job taking a ChannelJob*
+
+// Run jobs[0] here and jobs[1] on core 1 at the same time.
+// Returns total wall-clock time in microseconds.
+unsigned long runChannelPair(ChannelJob* jobs);
+
+#endif // CHANNEL_JOB_H
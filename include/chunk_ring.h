@@ -0,0 +1,48 @@
+#ifndef CHUNK_RING_H
+#define CHUNK_RING_H
+
+#include <Arduino.h>
+#include <atomic>
+
+// Lock-free single-producer/single-consumer ring of chunk buffers for bulk
+// transfers split across the two cores: one core owns the FRAM bus, the other
+// encodes/decodes the serial stream. Each index is written by one side only.
+#define RING_SLOTS              8
+#define RING_SLOT_SIZE          512
+
+struct RingSlot {
+    uint8_t data[RING_SLOT_SIZE];
+    uint16_t addr;
+    uint16_t len;
+};
+
+struct RingStats {
+    uint32_t chunks;
+    uint32_t occupancy_sum;         // Filled slots seen by the consumer, summed per chunk
+    uint8_t occupancy_max;
+    uint32_t producer_wait_us;      // Ring full: the consumer is the bottleneck
+    uint32_t consumer_wait_us;      // Ring empty: the producer is the bottleneck
+};
+
+struct ChunkRing {
+    RingSlot slots[RING_SLOTS];
+    std::atomic<uint32_t> head;     // Slots published by the producer
+    std::atomic<uint32_t> tail;     // Slots released by the consumer
+    std::atomic<bool> closed;       // Producer has published its last slot
+    RingStats stats;
+};
+
+void ringInit(ChunkRing& ring);
+
+// Producer side: claim a free slot (waits while the ring is full), then publish it
+RingSlot* ringBeginWrite(ChunkRing& ring);
+void ringCommitWrite(ChunkRing& ring);
+void ringClose(ChunkRing& ring);
+
+// Consumer side: next filled slot (waits while empty); nullptr once closed and drained
+RingSlot* ringBeginRead(ChunkRing& ring);
+void ringCommitRead(ChunkRing& ring);
+
+void printRingStats(const ChunkRing& ring, const char* producer, const char* consumer);
+
+#endif // CHUNK_RING_H
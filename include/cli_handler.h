@@ -4,41 +4,47 @@
 #include <Arduino.h>
 #include "fram_programmer.h"
 
-// CLI Commands
-enum CLICommand {
-    CMD_HELP,
-    CMD_DETECT,
-    CMD_INFO,
-    CMD_BACKUP,
-    CMD_RESTORE,
-    CMD_PROGRAM,
-    CMD_VERIFY,
-    CMD_CONFIG,
-    CMD_TEST,
-    CMD_UNKNOWN
-};
+struct RestoreStream;
 
 // CLI Handler functions
 void initCLI();
 void handleCLI();
-CLICommand parseCommand(const String& input);
-void executeCommand(CLICommand cmd, const String& args);
-
-// Command implementations
-void cmdHelp();
-void cmdDetect();
-void cmdInfo();
-void cmdBackup();
-void cmdRestore();
-void cmdProgram();
-void cmdVerify();
-void cmdConfig();
-void cmdTest();
+
+// Command implementations (registered in command_registry.cpp)
+void cmdHelp(const String& args);
+void cmdDetect(const String& args);
+void cmdInfo(const String& args);
+void cmdBackup(const String& args);
+void cmdIncrementalBackup(const String& block_arg);
+void cmdRestore(const String& args);
+void cmdProgram(const String& args);
+void cmdVerify(const String& args);
+void cmdConfig(const String& args);
+void cmdTest(const String& args);
+void cmdFill(const String& args);
+void cmdWipe(const String& args);
+void cmdGang(const String& args);
+void cmdDual(const String& args);
+void cmdLine(const String& args);
+void cmdMerkle(const String& args);
+void cmdScrub(const String& args);
+void cmdMigrate(const String& args);
+void cmdRekey(const String& args);
+void cmdProfile(const String& args);
+void cmdPart(const String& args);
+void cmdInput(const String& args);
+void cmdMem(const String& args);
+void cmdLogLevel(const String& args);
 
 // Input handling
-bool parseJSONCredentials(const String& json, DeviceCredentials& creds);
 bool parseTextCredentials(DeviceCredentials& creds);
-String readSerialLine();
+size_t readCredentialBatch(DeviceCredentials* records, size_t max_records);
+String readSerialLine(bool echo = true);
+const char* readInputText(bool echo = true);
+bool readInputLine(String& line, bool echo = true);
+String getArgument(const String& input, int index);
+bool parseNumberArgument(const String& arg, unsigned long* value);
+bool parseHexPattern(const String& arg, uint8_t* pattern, size_t* pattern_len);
 void printPrompt();
 
 // Output formatting
@@ -48,8 +54,11 @@ void printWarning(const String& message);
 void printInfo(const String& message);
 void printHexDump(const uint8_t* data, size_t length);
 
+// Self-tests
+bool testBackupCodec();
+
 // Backup/Restore helpers
 bool sendBackupData();
-bool receiveRestoreData(uint8_t* buffer, size_t expected_size);
+bool receiveRestoreData(RestoreStream& stream);
 
 #endif // CLI_HANDLER_H
\ No newline at end of file
@@ -0,0 +1,43 @@
+#ifndef COMMAND_ARENA_H
+#define COMMAND_ARENA_H
+
+#include <Arduino.h>
+#include <new>
+#include <type_traits>
+
+// Per-command bump arena. Commands take their working objects (credential
+// batches, scratch records) from a static block instead of the stack or heap;
+// runCommandLine() resets it when the command returns, zeroing what was used
+// so no plaintext outlives the command. Objects must be trivially
+// destructible because nothing is destroyed individually.
+#define COMMAND_ARENA_SIZE      24576       // Line mode's 32-record batch plus scratch
+
+void* arenaAlloc(size_t size, size_t align);
+void arenaReset();
+size_t arenaUsed();
+size_t arenaPeak();                 // Highest use by any command since boot
+
+// Default-constructed array of count objects; nullptr (with an error) if it does not fit
+template <typename T>
+T* arenaNew(size_t count = 1) {
+    static_assert(std::is_trivially_destructible<T>::value, "Arena objects are never destroyed");
+    T* items = static_cast<T*>(arenaAlloc(sizeof(T) * count, alignof(T)));
+    if (items) {
+        for (size_t i = 0; i < count; i++) {
+            new (&items[i]) T();
+        }
+    }
+    return items;
+}
+
+// Heap figures from the allocator: bytes in use now, and the high-water mark
+// (how far the heap has ever grown; it never shrinks)
+struct HeapStats {
+    size_t used;
+    size_t high_water;
+};
+
+HeapStats heapStats();
+void printHeapStats(const char* label);
+
+#endif // COMMAND_ARENA_H
@@ -0,0 +1,41 @@
+#ifndef COMMAND_REGISTRY_H
+#define COMMAND_REGISTRY_H
+
+#include <Arduino.h>
+
+// Command registry: one constexpr table row per command gives its name,
+// alias, handler, accepted --options and flags. Lookup compares the command
+// word in place (no String copies). Options are parsed once per line into a
+// fixed buffer; the handler gets only the positional words, so existing
+// getArgument() indexes are unchanged, and reads options with cliOption().
+//
+//   program --name DOLEWKA_001 --ssid Net --password "my pass" --admin a --token t --yes
+//
+// Values may be quoted ("..." with \" and \\ escapes) or written --opt=value.
+// Commands flagged CMD_FLAG_CONFIRM also accept --yes, which answers their
+// YES prompt; prompts for anything not given on the line still appear.
+#define CLI_MAX_OPTIONS         8
+#define CMD_FLAG_CONFIRM        0x01        // Asks for YES unless --yes is given
+
+typedef void (*CommandHandler)(const String& args);
+
+struct CommandSpec {
+    const char* name;
+    const char* alias;              // "" if none
+    CommandHandler handler;
+    const char* options;            // Space separated; "name=" takes a value
+    uint8_t flags;
+    const char* help;               // One line for 'help'
+};
+
+void runCommandLine(const String& input);   // Look up, parse options, dispatch
+const CommandSpec* findCommand(const char* input);
+void printCommandList();
+void printCommandEcho(const String& input);  // The line as typed, secret option values as ***
+
+// Valid while a handler runs
+const char* cliOption(const char* name);    // Value, "" for a flag, nullptr if absent
+bool cliYes();                              // --yes given
+bool readConfirmation(bool accept_short);   // --yes, or a typed YES (yes/y if accept_short)
+
+#endif // COMMAND_REGISTRY_H
@@ -0,0 +1,46 @@
+#ifndef CONSOLE_OUT_H
+#define CONSOLE_OUT_H
+
+#include <Arduino.h>
+
+// Buffered console output. Every print goes into a RAM buffer and reaches
+// Serial in large writes, so a hex line or a debug dump is one or a few USB
+// packets instead of one CDC transfer per print call. Core 0 collects up to
+// eight full packets and sends them when the buffer fills, when the firmware
+// looks for input again (serial_line), when text has waited CONSOLE_HOLD_MS,
+// or on flush(). Core 1 (gang and dual jobs) has its own buffer that is sent
+// at the end of each line.
+#define CONSOLE_PACKET_SIZE     64          // USB full-speed bulk packet
+#define CONSOLE_BUFFER_SIZE     (8 * CONSOLE_PACKET_SIZE)
+#define CONSOLE_LINE_SIZE       160         // Core 1 line buffer
+#define CONSOLE_HOLD_MS         20          // Longest buffered text waits before the next print sends it
+
+struct ConsoleStats {
+    uint32_t bytes;                 // Bytes handed to Serial
+    uint32_t writes;                // Serial.write calls
+    uint32_t write_us;              // Time spent inside Serial.write
+};
+
+class ConsoleOut : public Print {
+public:
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* data, size_t len) override;
+    using Print::write;
+    void flush() override;          // Hand everything buffered to Serial now
+    
+    // Formatted straight into the buffer; output longer than the buffer is cut
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+    
+    // Direct formatting: reserve() returns room for len bytes in the buffer
+    // (sending what is there first if needed), commit() adds what was used.
+    // nullptr if len exceeds the buffer; use write() then.
+    char* reserve(size_t len);
+    void commit(size_t len);
+};
+
+extern ConsoleOut Console;
+
+ConsoleStats consoleStats();
+void printConsoleStats(const ConsoleStats& before, unsigned long elapsed_us);    // Output since 'before'
+
+#endif // CONSOLE_OUT_H
@@ -0,0 +1,15 @@
+#ifndef CORE1_WORKER_H
+#define CORE1_WORKER_H
+
+#include <Arduino.h>
+
+// Minimal job runner for the RP2350's second core (arduino-pico setup1/loop1).
+// Core 0 submits one job at a time; core 1 runs it to completion.
+// Jobs must not use Wire/Serial state that core 0 is using at the same time.
+typedef void (*Core1Job)(void* arg);
+
+bool core1Submit(Core1Job job, void* arg);     // false if a job is still running
+bool core1Busy();
+void core1Wait();                              // Block until the current job finishes
+
+#endif // CORE1_WORKER_H
@@ -0,0 +1,13 @@
+#ifndef CRC32_H
+#define CRC32_H
+
+#include <Arduino.h>
+
+#define CRC32_SIZE 4
+
+// CRC-32 (IEEE 802.3, reflected polynomial 0xEDB88320), zlib-compatible.
+// Start with crc = 0 and feed data in any number of pieces.
+uint32_t crc32Update(uint32_t crc, const uint8_t* data, size_t len);
+uint32_t crc32(const uint8_t* data, size_t len);
+
+#endif // CRC32_H
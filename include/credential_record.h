@@ -0,0 +1,116 @@
+#ifndef CREDENTIAL_RECORD_H
+#define CREDENTIAL_RECORD_H
+
+#include <Arduino.h>
+#include "fram_programmer.h"
+#include "fram_view.h"
+
+// Stored credential formats. Both start with magic + version at FRAM_CREDENTIALS_ADDR.
+//   v1: fixed FRAMCredentials layout, 16-bit sum checksum, every field padded
+//       to its maximum, admin hash encrypted as 64 hex characters.
+//   v2: CredentialRecordHeader followed by typed entries (type, LE16 length,
+//       value), CRC32 over header and entries, admin hash encrypted as the raw
+//       32 bytes, and only header.length bytes are written.
+#define CRED_V1_USED_SIZE       512         // v1 bytes before the unused expansion area
+#define CRED_TLV_HEADER_SIZE    3           // type + LE16 length
+
+#define CRED_TLV_DEVICE_NAME    0x01        // Plain text, no terminator
+#define CRED_TLV_IV             0x02
+#define CRED_TLV_WIFI_SSID      0x03        // AES-256-CBC ciphertext, PKCS7 padded
+#define CRED_TLV_WIFI_PASSWORD  0x04
+#define CRED_TLV_ADMIN_HASH     0x05        // Ciphertext of the raw SHA-256
+#define CRED_TLV_VPS_TOKEN      0x06
+#define CRED_TLV_PROFILE_NAME   0x07        // Plain text, profile slots only (profile_store.h)
+#define CRED_TLV_KDF_SALT       0x08        // Plain, optional: extra key-derivation input set by rekey
+
+#define CRED_KDF_SALT_SIZE      8
+
+// Ciphertext size of an n-byte plaintext (PKCS7 always adds at least one byte)
+#define CRED_CIPHER_SIZE(n)     (((n) / AES_BLOCK_SIZE + 1) * AES_BLOCK_SIZE)
+
+struct __attribute__((packed)) CredentialRecordHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t length;                // Bytes of entries after the header
+    uint32_t crc;                   // CRC32 of magic, version, length and the entries
+};
+
+// Field handles for both stored layouts (fram_view.h)
+using CredV1Magic       = FRAM_FIELD(FRAMCredentials, magic);
+using CredV1Version     = FRAM_FIELD(FRAMCredentials, version);
+using CredV1DeviceName  = FRAM_FIELD(FRAMCredentials, device_name);
+using CredV1Iv          = FRAM_FIELD(FRAMCredentials, iv);
+using CredV1Checksum    = FRAM_FIELD(FRAMCredentials, checksum);
+using CredV2Magic       = FRAM_FIELD(CredentialRecordHeader, magic);
+using CredV2Version     = FRAM_FIELD(CredentialRecordHeader, version);
+using CredV2Length      = FRAM_FIELD(CredentialRecordHeader, length);
+using CredV2Crc         = FRAM_FIELD(CredentialRecordHeader, crc);
+
+static_assert(sizeof(FRAMCredentials) == FRAM_CREDENTIALS_SIZE, "v1 layout must fill the credentials section");
+static_assert(CredV1DeviceName::offset == 8 && CredV1Iv::offset == 40 && CredV1Checksum::offset == 496,
+              "v1 on-chip layout is fixed");
+static_assert(offsetof(FRAMCredentials, expansion) == CRED_V1_USED_SIZE, "v1 used size out of date");
+static_assert(sizeof(CredentialRecordHeader) == 12, "v2 header layout is fixed");
+static_assert(CredV1Magic::offset == CredV2Magic::offset && CredV1Magic::size == CredV2Magic::size &&
+              CredV1Version::offset == CredV2Version::offset && CredV1Version::size == CredV2Version::size,
+              "Both versions must start with magic and version so readers can branch on them");
+
+// What a presence check needs, read without fetching the record
+struct CredentialStatus {
+    uint16_t version;               // 0 if no credentials
+    uint16_t size;                  // Stored record bytes
+    char device_name[MAX_DEVICE_NAME_LEN + 1];
+    uint16_t bus_bytes;             // Bytes read to find this out
+};
+
+// Largest record encryptCredentials() can produce (565 bytes)
+#define CRED_V2_MAX_SIZE        (sizeof(CredentialRecordHeader) + 6 * CRED_TLV_HEADER_SIZE + \
+                                 MAX_DEVICE_NAME_LEN + AES_IV_SIZE + \
+                                 CRED_CIPHER_SIZE(MAX_WIFI_SSID_LEN) + \
+                                 CRED_CIPHER_SIZE(MAX_WIFI_PASSWORD_LEN) + \
+                                 CRED_CIPHER_SIZE(SHA256_HASH_SIZE) + \
+                                 CRED_CIPHER_SIZE(MAX_VPS_TOKEN_LEN))
+
+// Location of a field inside CredentialRecord::raw (offsets keep records copyable)
+struct CredentialField {
+    uint16_t offset;
+    uint16_t len;
+};
+
+// A record as stored in FRAM plus where each field lives in it, for either version
+struct CredentialRecord {
+    uint16_t version;               // 0 if raw[] does not hold a valid record
+    uint16_t size;                  // Bytes of raw[] that are stored in FRAM
+    uint8_t raw[FRAM_CREDENTIALS_SIZE];
+    char device_name[MAX_DEVICE_NAME_LEN + 1];
+    CredentialField iv;
+    CredentialField wifi_ssid;
+    CredentialField wifi_password;
+    CredentialField admin_hash;
+    CredentialField vps_token;
+    CredentialField profile_name;   // len 0 when absent
+    CredentialField kdf_salt;       // len 0 when absent (key from the fixed salt only)
+    bool admin_hash_hex;            // v1 keeps the hash as lowercase hex text
+};
+
+// Build a v2 record: begin, add entries, finish (writes the header and parses).
+// Entries may be appended to a finished record; finish it again afterwards.
+void credentialRecordBegin(CredentialRecord& rec);
+bool credentialRecordAdd(CredentialRecord& rec, uint8_t type, const uint8_t* data, size_t len);
+bool credentialRecordFinish(CredentialRecord& rec);
+
+// Bytes worth reading for a record that starts with this header: the v1 used
+// area, the v2 header plus its entries, or only the header if unrecognised
+size_t credentialRecordReadSize(const CredentialRecordHeader& header);
+// Locate the fields of the record in raw[]; false (version 0) if malformed
+bool parseCredentialRecord(CredentialRecord& rec);
+// v1 checksum or v2 CRC32; stored/computed are reported for diagnostics
+bool checkCredentialRecord(const CredentialRecord& rec, uint32_t* stored, uint32_t* computed);
+// Recompute the v1 checksum or v2 CRC32 after raw[] was changed in place
+bool updateCredentialRecordCheck(CredentialRecord& rec);
+
+inline const uint8_t* credentialField(const CredentialRecord& rec, const CredentialField& field) {
+    return &rec.raw[field.offset];
+}
+
+#endif // CREDENTIAL_RECORD_H
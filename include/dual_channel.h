@@ -0,0 +1,26 @@
+#ifndef DUAL_CHANNEL_H
+#define DUAL_CHANNEL_H
+
+#include <Arduino.h>
+#include "fram_programmer.h"
+#include "channel_job.h"
+
+// Dual-channel mode: channel 0 is Wire (SDA_PIN/SCL_PIN) driven by core 0,
+// channel 1 is Wire1 (SDA1_PIN/SCL1_PIN) driven by core 1. Each channel has
+// its own FRAM driver and bus, so the two chips are handled fully in parallel.
+// The jobs themselves (channel_job.h) only see a FramBus.
+
+bool initDualChannel();
+const FRAMDevice& getChannelDevice(uint8_t channel);
+
+// Run op on both channels concurrently and fill results[].
+// records[] is used by DUAL_PROGRAM (one record per channel).
+// Returns total wall-clock time in microseconds.
+unsigned long runDualChannel(DualOperation op, const DeviceCredentials* records,
+                             ChannelResult* results);
+
+// Stream the images captured by the last DUAL_BACKUP in the backup hex format
+void printDualBackup(const ChannelResult* results);
+void printDualReport(DualOperation op, const ChannelResult* results, unsigned long wall_us);
+
+#endif // DUAL_CHANNEL_H
@@ -3,33 +3,59 @@
 
 #include <Arduino.h>
 #include "fram_programmer.h"
+#include "credential_record.h"
 
 #define SHA256_HASH_SIZE    32          // 256 bits
 
 // Encryption functions
-bool generateEncryptionKey(const String& device_name, uint8_t* key);
+bool generateEncryptionKey(const char* device_name, size_t name_len, uint8_t* key,
+                           const uint8_t* kdf_salt = nullptr, size_t kdf_salt_len = 0);
 bool generateRandomIV(uint8_t* iv);
 bool encryptData(const uint8_t* plaintext, size_t plaintext_len, 
                  const uint8_t* key, const uint8_t* iv,
                  uint8_t* ciphertext, size_t* ciphertext_len);
 bool decryptData(const uint8_t* ciphertext, size_t ciphertext_len,
                  const uint8_t* key, const uint8_t* iv,
-                 uint8_t* plaintext, size_t* plaintext_len);
+                 uint8_t* plaintext, size_t* plaintext_len,
+                 bool exact_length = false);     // true: padding must end the last block
 
 // Utility functions
-bool sha256Hash(const String& input, uint8_t* hash);
 bool sha256Hash(const uint8_t* data, size_t len, uint8_t* hash);
 size_t addPKCS7Padding(uint8_t* data, size_t data_len, size_t block_size);
 size_t removePKCS7Padding(const uint8_t* data, size_t data_len);
 
 // High-level credential encryption
-bool encryptCredentials(const DeviceCredentials& creds, FRAMCredentials& fram_creds);
-bool decryptCredentials(const FRAMCredentials& fram_creds, DeviceCredentials& creds);
+bool encryptCredentials(const DeviceCredentials& creds, CredentialRecord& rec);   // Builds a v2 record
+bool decryptCredentials(const CredentialRecord& rec, DeviceCredentials& creds);   // v1 or v2
+bool migrateCredentials(const CredentialRecord& v1, CredentialRecord& v2);
+bool rekeyCredentials(CredentialRecord& rec, bool rotate_salt);   // New IV (and v2 salt), in place
+
+// Field-level decryption: one field at a time, straight into a caller buffer
+enum CredentialFieldId {
+    CRED_FIELD_WIFI_SSID,
+    CRED_FIELD_WIFI_PASSWORD,
+    CRED_FIELD_ADMIN_HASH,              // v1: 64 hex characters, v2: raw 32-byte digest
+    CRED_FIELD_VPS_TOKEN
+};
+
+bool credentialKey(const CredentialRecord& rec, uint8_t* key);     // Derived from the stored device name
+bool decryptCredentialField(const CredentialRecord& rec, const uint8_t* key, CredentialFieldId id,
+                            uint8_t* out, size_t* out_len);    // *out_len: capacity in, plaintext length out (no terminator)
+bool fastVerifyCredentials(const CredentialRecord& rec);       // Key check: decrypts one block of padding
 
 // Validation functions
-bool validateDeviceName(const String& name);
-bool validateWiFiSSID(const String& ssid);
-bool validateWiFiPassword(const String& password);
-bool validateVPSToken(const String& token);
+bool validateCredentials(const DeviceCredentials& creds);     // All fields below
+bool validateDeviceName(const char* name, size_t len);
+bool validateWiFiSSID(const char* ssid, size_t len);
+bool validateWiFiPassword(const char* password, size_t len);
+bool validateAdminPassword(const char* password, size_t len);
+bool validateVPSToken(const char* token, size_t len);
+
+// Fixed-capacity fields: text that overflowed reads as one character too long
+template <size_t N> bool validateDeviceName(const FixedString<N>& s) { return validateDeviceName(s.c_str(), s.inputLength()); }
+template <size_t N> bool validateWiFiSSID(const FixedString<N>& s) { return validateWiFiSSID(s.c_str(), s.inputLength()); }
+template <size_t N> bool validateWiFiPassword(const FixedString<N>& s) { return validateWiFiPassword(s.c_str(), s.inputLength()); }
+template <size_t N> bool validateAdminPassword(const FixedString<N>& s) { return validateAdminPassword(s.c_str(), s.inputLength()); }
+template <size_t N> bool validateVPSToken(const FixedString<N>& s) { return validateVPSToken(s.c_str(), s.inputLength()); }
 
 #endif // ENCRYPTION_H
\ No newline at end of file
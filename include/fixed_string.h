@@ -0,0 +1,79 @@
+#ifndef FIXED_STRING_H
+#define FIXED_STRING_H
+
+#include <Arduino.h>
+#include <string.h>
+
+// Fixed-capacity string for credential fields: N characters plus a terminator
+// held inline, so a DeviceCredentials never touches the heap. Text longer than
+// N is cut at N and remembered as overflowed; validators see inputLength() =
+// N + 1 for it and reject it, so a truncated value can never be programmed.
+template <size_t N>
+class FixedString {
+public:
+    FixedString() : len_(0), overflow_(false) {
+        buf_[0] = '\0';
+    }
+    
+    FixedString(const char* text) : FixedString() {
+        assign(text);
+    }
+    
+    FixedString& operator=(const char* text) {
+        assign(text);
+        return *this;
+    }
+    
+    // Returns false (and keeps the first N characters) if text does not fit
+    bool assign(const char* text, size_t len) {
+        overflow_ = len > N;
+        len_ = overflow_ ? N : len;
+        if (len_ > 0) {
+            memcpy(buf_, text, len_);
+        }
+        buf_[len_] = '\0';
+        return !overflow_;
+    }
+    
+    bool assign(const char* text) {
+        return assign(text, text ? strlen(text) : 0);
+    }
+    
+    void clear() {
+        len_ = 0;
+        overflow_ = false;
+        buf_[0] = '\0';
+    }
+    
+    const char* c_str() const { return buf_; }
+    size_t length() const { return len_; }
+    bool overflowed() const { return overflow_; }
+    size_t inputLength() const { return overflow_ ? N + 1 : len_; }
+    static constexpr size_t capacity() { return N; }
+    char charAt(size_t i) const { return i < len_ ? buf_[i] : '\0'; }
+    
+    bool equals(const char* text, size_t len) const {
+        return len == len_ && memcmp(buf_, text, len) == 0;
+    }
+    
+    template <size_t M>
+    bool operator==(const FixedString<M>& other) const {
+        return equals(other.c_str(), other.length());
+    }
+    
+    template <size_t M>
+    bool operator!=(const FixedString<M>& other) const {
+        return !(*this == other);
+    }
+    
+    bool operator==(const char* text) const {
+        return equals(text, strlen(text));
+    }
+
+private:
+    char buf_[N + 1];
+    uint16_t len_;
+    bool overflow_;
+};
+
+#endif // FIXED_STRING_H
@@ -0,0 +1,17 @@
+#ifndef FRAM_BUS_H
+#define FRAM_BUS_H
+
+#include <Arduino.h>
+
+// Byte access to one FRAM chip, whatever it hangs off. The dual-channel jobs
+// (channel_job.h) only talk to this: the firmware implements it over an
+// Adafruit driver on Wire/Wire1, the native tests over an array in RAM.
+class FramBus {
+public:
+    virtual ~FramBus() {}
+    virtual bool begin() = 0;       // Probe and bind the chip; false if none answers
+    virtual bool read(uint16_t addr, uint8_t* data, size_t len) = 0;
+    virtual bool write(uint16_t addr, const uint8_t* data, size_t len) = 0;
+};
+
+#endif // FRAM_BUS_H
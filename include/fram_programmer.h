@@ -2,27 +2,46 @@
 #define FRAM_PROGRAMMER_H
 
 #include <Arduino.h>
+#include "fixed_string.h"
 
 // Forward declaration instead of full include for IntelliSense
 class Adafruit_FRAM_I2C;
+class TwoWire;
+struct CredentialRecord;
+struct CredentialStatus;
 
 // FRAM Configuration
 #define FRAM_I2C_ADDR           0x50
+#define FRAM_I2C_ADDR_FIRST     0x50        // A2/A1/A0 strapping range
+#define FRAM_I2C_ADDR_LAST      0x57
+#define FRAM_MAX_DEVICES        8
+#define FRAM_I2C_CLOCK          100000      // Default bus speed
+#define FRAM_I2C_BULK_CLOCK     400000      // Bus speed for bulk streaming (FRAM parts support 1 MHz)
+#define FRAM_SIZE               32768       // 32KB (MB85RC256V / FM24 class)
 #define FRAM_CREDENTIALS_ADDR   0x0018      // Start address for credentials (24 bytes offset)
 #define FRAM_CREDENTIALS_SIZE   1024        // Size of credentials section
 
 // FRAM Structure Constants
 #define FRAM_MAGIC_NUMBER       0x43524544  // "CRED" in hex
-#define FRAM_DATA_VERSION       0x0001      // Version 1
+#define FRAM_DATA_VERSION       0x0001      // Version 1: fixed FRAMCredentials layout
+#define FRAM_DATA_VERSION_V2    0x0002      // Version 2: TLV record (credential_record.h)
+
+// Bulk transfer settings
+#define FRAM_BULK_CHUNK_SIZE    256         // Bytes per I2C write/read transaction in bulk ops
+#define FRAM_FILL_MAX_PATTERN   16          // Longest repeating fill pattern
+#define FRAM_WIPE_PASSES        3           // Overwrite passes for secure wipe
 
 // Pin definitions for Beetle RP2350
 #define SDA_PIN                 4
 #define SCL_PIN                 5
+#define SDA1_PIN                2           // Second I2C controller (Wire1) for dual-channel mode
+#define SCL1_PIN                3
 
 // Input validation limits
 #define MAX_DEVICE_NAME_LEN     31
 #define MAX_WIFI_SSID_LEN       63
 #define MAX_WIFI_PASSWORD_LEN   127
+#define MAX_ADMIN_PASSWORD_LEN  127         // Hashed, never stored; bounds JSON input
 #define MAX_VPS_TOKEN_LEN       255
 
 // Encryption constants
@@ -51,29 +70,50 @@ struct __attribute__((packed)) FRAMCredentials {
     uint8_t  expansion[512];               // 512 bytes (512-1023) = 1024 total
 };
 
-// Input data structure
+// Input data structure: fixed-capacity fields, no heap
 struct DeviceCredentials {
-    String device_name;
-    String wifi_ssid;
-    String wifi_password;
-    String admin_password;
-    String vps_token;
+    FixedString<MAX_DEVICE_NAME_LEN> device_name;
+    FixedString<MAX_WIFI_SSID_LEN> wifi_ssid;
+    FixedString<MAX_WIFI_PASSWORD_LEN> wifi_password;
+    FixedString<MAX_ADMIN_PASSWORD_LEN> admin_password;    // After decryption: the 64-char hex hash
+    FixedString<MAX_VPS_TOKEN_LEN> vps_token;
+};
+
+// One FRAM chip: driver instance bound to a bus and address
+struct FRAMDevice {
+    Adafruit_FRAM_I2C* fram;
+    TwoWire* wire;
+    uint8_t i2c_addr;
 };
 
 // Function declarations
 bool initFRAM();
 bool detectFRAM();
+bool detectFRAM(const FRAMDevice& dev);
+uint8_t discoverFRAMDevices(FRAMDevice* devices, uint8_t max_devices);
 bool backupFRAM();
-bool restoreFRAM(const uint8_t* backup_data, size_t data_size);
+void printBackupChunk(uint16_t addr, const uint8_t* data, size_t len);
+bool fillFRAM(uint16_t addr, size_t len, const uint8_t* pattern, size_t pattern_len);
+bool wipeFRAM(uint16_t addr, size_t len);
+bool crcFRAM(uint16_t addr, size_t len, uint32_t* crc);
 bool programCredentials(const DeviceCredentials& creds);
 bool verifyCredentials();
-bool readCredentialsSection(FRAMCredentials& creds);
-bool writeCredentialsSection(const FRAMCredentials& creds);
+bool verifyCredentials(const FRAMDevice& dev);
+bool verifyCredentials(CredentialRecord& rec);                           // Leaves the record read in rec
+bool verifyCredentials(const FRAMDevice& dev, CredentialRecord& rec);
+bool migrateCredentialsSection();
+bool rekeyCredentialsSection(bool rotate_salt);
+bool readCredentialStatus(const FRAMDevice& dev, CredentialStatus& status);
+bool readCredentialsSection(CredentialRecord& rec);
+bool readCredentialsSection(const FRAMDevice& dev, CredentialRecord& rec);
+bool writeCredentialsSection(const CredentialRecord& rec);
+bool writeCredentialsSection(const FRAMDevice& dev, const CredentialRecord& rec);
 void printFRAMInfo();
-void printCredentialsInfo(const FRAMCredentials& creds);
+void printCredentialsInfo(const CredentialRecord& rec);
 uint16_t calculateChecksum(const uint8_t* data, size_t size);
 
 // Global FRAM object declaration
 extern Adafruit_FRAM_I2C fram;
+extern const FRAMDevice defaultFRAM;     // fram on Wire at FRAM_I2C_ADDR
 
 #endif // FRAM_PROGRAMMER_H
\ No newline at end of file
@@ -0,0 +1,56 @@
+#ifndef FRAM_SCRUB_H
+#define FRAM_SCRUB_H
+
+#include <Arduino.h>
+#include "fram_programmer.h"
+
+// Background scrubber: a CRC32 per region is kept in an index stored in FRAM,
+// and regions are re-read a slice at a time from loop() while the CLI is idle.
+// Every write path on the default chip must call scrubNoteWrite() (ideally
+// before the write) so the written regions are re-baselined instead of being
+// reported as corrupted.
+//
+// The index belongs to the chip it is stored on: chips are swapped between
+// commands, so the header (with a random per-chip salt) is re-read before a
+// region is judged and before anything is written back, and the index of
+// whichever chip is present is loaded when it differs from the RAM copy.
+#define SCRUB_INDEX_ADDR        0x7C00      // Index location (end of FRAM, not scrubbed itself)
+#define SCRUB_INDEX_MAGIC       0x42524353  // "SCRB"
+#define SCRUB_INDEX_VERSION     2
+#define SCRUB_CRC_STALE         0xFFFFFFFF  // Region written since its CRC was taken; adopted on the next pass
+#define SCRUB_REGION_SIZE       512
+#define SCRUB_REGION_COUNT      (SCRUB_INDEX_ADDR / SCRUB_REGION_SIZE)
+#define SCRUB_SLICE_BYTES       64          // Read per slice (~1.5 ms at 400 kHz)
+#define SCRUB_SLICE_INTERVAL_MS 10          // Minimum spacing between slices
+#define SCRUB_MAX_MISMATCHES    8
+#define SCRUB_FLAG_ENABLED      0x01
+
+struct ScrubIndexHeader {
+    uint32_t magic;
+    uint8_t version;
+    uint8_t flags;
+    uint16_t region_size;
+    uint16_t region_count;
+    uint16_t reserved;
+    uint32_t salt;                  // Random per index build; tells chips apart
+    uint32_t table_crc;             // CRC32 of the region CRC table that follows
+} __attribute__((packed));
+
+struct ScrubMismatch {
+    uint16_t region;
+    uint32_t expected_crc;
+    uint32_t actual_crc;
+    unsigned long first_seen_ms;
+    unsigned long last_seen_ms;
+    uint32_t count;
+};
+
+void initScrub();                   // Load the index (after initFRAM)
+void scrubSlice();                  // Called from loop()
+void scrubNoteWrite(uint16_t addr, size_t len);     // Marks the regions stale in the chip's index
+
+bool scrubEnable(bool enable);
+bool scrubRebuild();                // Re-baseline every region and clear the mismatch log
+void printScrubStatus();
+
+#endif // FRAM_SCRUB_H
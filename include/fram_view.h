@@ -0,0 +1,95 @@
+#ifndef FRAM_VIEW_H
+#define FRAM_VIEW_H
+
+#include <Arduino.h>
+#include <stddef.h>
+#include <type_traits>
+#include "fram_programmer.h"
+
+// Typed access to single fields of a packed struct stored in FRAM. Offsets and
+// sizes are fixed at compile time from offsetof/sizeof, so an access moves only
+// the bytes of that field (or of a span of adjacent fields) over I2C:
+//
+//   FramView<FRAMCredentials> view(defaultFRAM, FRAM_CREDENTIALS_ADDR);
+//   uint32_t magic;
+//   view.read<CredV1Magic>(magic);             // 4 bytes instead of 1024
+
+bool framViewRead(const FRAMDevice& dev, uint16_t addr, uint8_t* data, size_t len);
+bool framViewWrite(const FRAMDevice& dev, uint16_t addr, const uint8_t* data, size_t len);
+
+template <typename S, typename F, size_t Offset>
+struct FramField {
+    using Struct = S;
+    using Type = F;
+    static constexpr size_t offset = Offset;
+    static constexpr size_t size = sizeof(F);
+    
+    static_assert(Offset + sizeof(F) <= sizeof(S), "Field lies outside its struct");
+    static_assert(std::is_trivially_copyable<F>::value, "Field must be plain bytes");
+};
+
+// A member pointer cannot give a constant offset, so the handle is built from offsetof
+#define FRAM_FIELD(S, member) FramField<S, decltype(S::member), offsetof(S, member)>
+
+// Adjacent fields First..Last, read in one transaction
+template <typename First, typename Last>
+struct FramSpan {
+    using Struct = typename First::Struct;
+    static constexpr size_t offset = First::offset;
+    static constexpr size_t size = Last::offset + Last::size - First::offset;
+    
+    static_assert(std::is_same<Struct, typename Last::Struct>::value, "Span fields from different structs");
+    static_assert(First::offset <= Last::offset, "Span fields out of order");
+    
+    // Copy one field out of a buffer holding this span
+    template <typename Field>
+    static void get(const uint8_t* buffer, typename Field::Type& out) {
+        static_assert(std::is_same<Struct, typename Field::Struct>::value, "Field from another struct");
+        static_assert(Field::offset >= offset && Field::offset + Field::size <= offset + size,
+                      "Field outside the span");
+        memcpy(&out, buffer + (Field::offset - offset), Field::size);
+    }
+};
+
+template <typename T>
+class FramView {
+public:
+    FramView(const FRAMDevice& dev, uint16_t base) : dev_(dev), base_(base) {
+        static_assert(std::is_trivially_copyable<T>::value, "FRAM structs must be plain bytes");
+    }
+    
+    template <typename Field>
+    bool read(typename Field::Type& out) const {
+        checkStruct<Field>();
+        return framViewRead(dev_, base_ + Field::offset, (uint8_t*)&out, Field::size);
+    }
+    
+    template <typename Field>
+    bool write(const typename Field::Type& value) const {
+        checkStruct<Field>();
+        return framViewWrite(dev_, base_ + Field::offset, (const uint8_t*)&value, Field::size);
+    }
+    
+    template <typename Span>
+    bool readSpan(uint8_t (&buffer)[Span::size]) const {
+        checkStruct<Span>();
+        return framViewRead(dev_, base_ + Span::offset, buffer, Span::size);
+    }
+    
+    bool readAll(T& out) const {
+        return framViewRead(dev_, base_, (uint8_t*)&out, sizeof(T));
+    }
+    
+    uint16_t address() const { return base_; }
+    
+private:
+    template <typename Field>
+    static constexpr void checkStruct() {
+        static_assert(std::is_same<T, typename Field::Struct>::value, "Field belongs to another struct");
+    }
+    
+    const FRAMDevice& dev_;
+    uint16_t base_;
+};
+
+#endif // FRAM_VIEW_H
@@ -0,0 +1,25 @@
+#ifndef GANG_PROGRAMMER_H
+#define GANG_PROGRAMMER_H
+
+#include <Arduino.h>
+#include "fram_programmer.h"
+
+// Per-chip outcome of a gang programming run
+struct GangResult {
+    uint8_t i2c_addr;
+    bool encrypted;
+    bool written;
+    bool verified;
+    unsigned long encrypt_us;       // Key derivation + encryption (core 1)
+    unsigned long write_us;         // Write, read-back and verify (core 0)
+};
+
+// Program records[i] into devices[i] for i < count.
+// Key derivation and encryption for chip i+1 run on core 1 while chip i
+// is being written on core 0. Returns the number of chips that verified.
+uint8_t programGang(const FRAMDevice* devices, const DeviceCredentials* records,
+                    uint8_t count, GangResult* results, unsigned long* total_us);
+void printGangReport(const DeviceCredentials* records, const GangResult* results,
+                     uint8_t count, unsigned long total_us);
+
+#endif // GANG_PROGRAMMER_H
@@ -0,0 +1,34 @@
+#ifndef HEX_CODEC_H
+#define HEX_CODEC_H
+
+#include <Arduino.h>
+
+// Shared hex codec for dumps, backup lines and restore parsing.
+// Encoding copies one precomputed two-character entry per byte, straight into
+// the console output buffer; decoding validates and converts eight
+// characters (four bytes) per step, falling back per character only to
+// locate an error.
+#define HEX_LINE_MAX_BYTES      128         // Largest line printHexLine builds in one buffer
+
+// Uppercase hex of len bytes into out, each byte followed by separator if non-zero.
+// Writes 2 (or 3) chars per byte plus a NUL; returns the characters written.
+size_t hexEncode(const uint8_t* data, size_t len, char* out, char separator = '\0');
+
+// Decode hex_len characters (either case) into out. On failure returns false
+// with *error_pos = index of the offending character (hex_len for odd length,
+// the first character that does not fit when cap is exceeded).
+bool hexDecode(const char* hex, size_t hex_len, uint8_t* out, size_t cap,
+               size_t* out_len, size_t* error_pos);
+
+// Hex number field such as an ADDR: value: at least one digit, nothing else,
+// at most eight digits. Unlike strtoul, empty or partly valid text fails.
+bool hexParseNumber(const char* hex, size_t hex_len, uint32_t* value);
+
+// Console helpers
+void printHex(const uint8_t* data, size_t len, char separator = '\0');
+void printHexLine(const char* prefix, const uint8_t* data, size_t len);    // prefix + hex + newline
+
+// Self-test: round trip, error positions and a timing comparison against per-byte formatting
+bool testHexCodec();
+
+#endif // HEX_CODEC_H
@@ -0,0 +1,42 @@
+#ifndef JSON_INGEST_H
+#define JSON_INGEST_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "fram_programmer.h"
+
+// JSON credential ingestion. A record is parsed straight from the console ring
+// into a static document, through a filter that keeps only the five credential
+// keys, so memory is bounded by the field limits whatever the host sends.
+// Values are validated where they lie in the document and copied once into
+// DeviceCredentials. Several records may follow each other (JSON lines).
+#define JSON_INGEST_MAX_BYTES   2048        // Longest record accepted, unknown keys included
+#define JSON_INGEST_EOL_WAIT_MS 50          // Wait for the end of line after the closing brace
+
+// Five members with their keys (copied from the stream) and values at their limits
+#define JSON_INGEST_DOC_SIZE    (JSON_OBJECT_SIZE(5) + \
+                                 sizeof("device_name") + sizeof("wifi_ssid") + \
+                                 sizeof("wifi_password") + sizeof("admin_password") + \
+                                 sizeof("vps_token") + \
+                                 MAX_DEVICE_NAME_LEN + MAX_WIFI_SSID_LEN + MAX_WIFI_PASSWORD_LEN + \
+                                 MAX_ADMIN_PASSWORD_LEN + MAX_VPS_TOKEN_LEN + 5)
+
+enum JsonIngestResult {
+    JSON_INGEST_OK,
+    JSON_INGEST_END,                // 'END' line (only when allowed)
+    JSON_INGEST_TIMEOUT,            // Input went idle before the record was complete
+    JSON_INGEST_INVALID             // Bad JSON, missing or invalid field; line discarded
+};
+
+struct JsonIngestStats {
+    unsigned long elapsed_us;       // First byte of the record to validated copy
+    size_t bytes;                   // Record bytes read
+    size_t doc_used;                // Document memory used by the record
+};
+
+JsonIngestResult readJSONCredentials(DeviceCredentials& creds, bool allow_end, JsonIngestStats* stats);
+bool parseJSONCredentials(const char* json, size_t len, DeviceCredentials& creds, JsonIngestStats* stats);
+void printJSONIngestStats(const JsonIngestStats& stats, size_t records);
+bool testJSONIngest();
+
+#endif // JSON_INGEST_H
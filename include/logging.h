@@ -0,0 +1,79 @@
+#ifndef LOGGING_H
+#define LOGGING_H
+
+#include <Arduino.h>
+#include "console_out.h"
+
+// Leveled diagnostics. CORE_DEBUG_LEVEL (platformio.ini build_flags) is the
+// most verbose level built into the firmware, numbered like the ESP32 core:
+// 0 none, 1 error, 2 warn, 3 info, 4 debug, 5 verbose. Log sites above it
+// expand to nothing, format strings and arguments included. Sites that are
+// compiled in also check the runtime level (`loglevel`), which can be lowered
+// and raised again up to the compiled level.
+#define LOG_LEVEL_NONE          0
+#define LOG_LEVEL_ERROR         1
+#define LOG_LEVEL_WARN          2
+#define LOG_LEVEL_INFO          3
+#define LOG_LEVEL_DEBUG         4
+#define LOG_LEVEL_VERBOSE       5           // Key material and decrypted values
+
+#ifndef CORE_DEBUG_LEVEL
+#define CORE_DEBUG_LEVEL        LOG_LEVEL_INFO
+#endif
+#define LOG_COMPILED_LEVEL      CORE_DEBUG_LEVEL
+
+extern uint8_t log_runtime_level;
+
+// Whether a site at 'level' prints now; a constant false above the compiled
+// level, so guarded blocks (loops over bytes) are dropped by the compiler too
+#define LOG_ENABLED(level)      ((level) <= LOG_COMPILED_LEVEL && (level) <= log_runtime_level)
+
+// printf-style line with a tag; one buffered console write per site
+#define LOG_LINE(level, tag, format, ...) \
+    do { if (LOG_ENABLED(level)) Console.printf(tag format "\r\n", ##__VA_ARGS__); } while (0)
+
+#if LOG_COMPILED_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_E(format, ...)      LOG_LINE(LOG_LEVEL_ERROR, "ERROR: ", format, ##__VA_ARGS__)
+#else
+#define LOG_E(format, ...)      do {} while (0)
+#endif
+
+#if LOG_COMPILED_LEVEL >= LOG_LEVEL_WARN
+#define LOG_W(format, ...)      LOG_LINE(LOG_LEVEL_WARN, "WARNING: ", format, ##__VA_ARGS__)
+#else
+#define LOG_W(format, ...)      do {} while (0)
+#endif
+
+#if LOG_COMPILED_LEVEL >= LOG_LEVEL_INFO
+#define LOG_I(format, ...)      LOG_LINE(LOG_LEVEL_INFO, "", format, ##__VA_ARGS__)
+#else
+#define LOG_I(format, ...)      do {} while (0)
+#endif
+
+#if LOG_COMPILED_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_D(format, ...)      LOG_LINE(LOG_LEVEL_DEBUG, "DEBUG: ", format, ##__VA_ARGS__)
+#define LOG_HEX_D(label, data, len) \
+    do { if (LOG_ENABLED(LOG_LEVEL_DEBUG)) logHexRows("DEBUG: ", label, data, len); } while (0)
+#else
+#define LOG_D(format, ...)      do {} while (0)
+#define LOG_HEX_D(label, data, len) do {} while (0)
+#endif
+
+#if LOG_COMPILED_LEVEL >= LOG_LEVEL_VERBOSE
+#define LOG_V(format, ...)      LOG_LINE(LOG_LEVEL_VERBOSE, "VERBOSE: ", format, ##__VA_ARGS__)
+#define LOG_HEX_V(label, data, len) \
+    do { if (LOG_ENABLED(LOG_LEVEL_VERBOSE)) logHexRows("VERBOSE: ", label, data, len); } while (0)
+#else
+#define LOG_V(format, ...)      do {} while (0)
+#define LOG_HEX_V(label, data, len) do {} while (0)
+#endif
+
+// "<tag><label>" then the bytes as indented rows of 16
+void logHexRows(const char* tag, const char* label, const uint8_t* data, size_t len);
+
+uint8_t logLevel();
+uint8_t setLogLevel(uint8_t level);         // Clamped to the compiled level; returns the level set
+const char* logLevelName(uint8_t level);
+bool parseLogLevel(const char* text, uint8_t* level);   // Name or 0-5
+
+#endif // LOGGING_H
@@ -0,0 +1,41 @@
+#ifndef MERKLE_TREE_H
+#define MERKLE_TREE_H
+
+#include <Arduino.h>
+#include "fram_programmer.h"
+#include "sha256.h"
+
+// SHA-256 hash tree over an FRAM region, so a host can compare a unit against
+// a golden image by exchanging the root and then only the mismatching branches.
+//   leaf = SHA256(0x00 || data)        node = SHA256(0x01 || left || right)
+// A node without a right sibling is promoted to the next level unchanged.
+// Depth 0 is the root; depth (levels - 1) holds the leaves.
+#define MERKLE_HASH_SIZE        SHA256_HASH_SIZE
+#define MERKLE_MIN_LEAF         32
+#define MERKLE_MAX_LEAF         4096
+#define MERKLE_DEFAULT_LEAF     256
+#define MERKLE_MAX_LEAVES       256
+#define MERKLE_MAX_NODES        (2 * MERKLE_MAX_LEAVES - 1)
+#define MERKLE_MAX_LEVELS       9           // log2(MERKLE_MAX_LEAVES) + 1
+
+struct MerkleTree {
+    bool valid;
+    uint16_t start;
+    size_t size;
+    size_t leaf_size;
+    size_t leaf_count;
+    uint8_t levels;
+    size_t level_offset[MERKLE_MAX_LEVELS];    // Indexed by depth
+    size_t level_count[MERKLE_MAX_LEVELS];
+    uint8_t nodes[MERKLE_MAX_NODES][MERKLE_HASH_SIZE];
+};
+
+// Hash the region and build the tree; fails if the region needs more than MERKLE_MAX_LEAVES leaves
+bool buildMerkleTree(MerkleTree& tree, uint16_t start, size_t size, size_t leaf_size);
+const uint8_t* getMerkleNode(const MerkleTree& tree, size_t depth, size_t index);
+
+void printMerkleSummary(const MerkleTree& tree);
+// Print a node and its children; for a leaf, print its data in the backup line format
+bool printMerkleNode(const MerkleTree& tree, size_t depth, size_t index);
+
+#endif // MERKLE_TREE_H
@@ -0,0 +1,68 @@
+#ifndef PARTITION_TABLE_H
+#define PARTITION_TABLE_H
+
+#include <Arduino.h>
+#include "fram_programmer.h"
+
+// Superblock: a partition table that makes the FRAM map explicit. It is read
+// in one transaction at boot and again at the start of every bulk command
+// (backup, verify, wipe, test, part), because chips are swapped between
+// commands; those commands then touch only the partitions flagged for them.
+// Without a superblock they treat all 32 KB as in use, except that 'test'
+// skips its write test when no scratch partition is declared.
+#define PART_TABLE_ADDR         0x7E00
+#define PART_TABLE_MAGIC        0x52505553  // "SUPR"
+#define PART_TABLE_VERSION      1
+#define PART_MAX                12
+#define PART_NAME_LEN           8           // Not necessarily NUL-terminated
+
+#define PART_TYPE_SYSTEM        0x01        // Firmware bookkeeping (superblock, scrub index, probes)
+#define PART_TYPE_CREDENTIALS   0x02
+#define PART_TYPE_PROFILES      0x03
+#define PART_TYPE_SCRATCH       0x04        // May be overwritten by 'test'
+#define PART_TYPE_DATA          0x05
+
+#define PART_FLAG_BACKUP        0x01        // Included in 'backup'
+#define PART_FLAG_WIPE          0x02        // Cleared by 'wipe all'
+#define PART_FLAG_SEALED        0x04        // crc holds the contents at the last 'part seal'
+
+struct PartitionEntry {
+    char name[PART_NAME_LEN];
+    uint16_t offset;
+    uint16_t length;
+    uint8_t type;
+    uint8_t flags;
+    uint16_t reserved;
+    uint32_t crc;                   // CRC32 of the contents when sealed
+} __attribute__((packed));
+
+struct Superblock {
+    uint32_t magic;
+    uint8_t version;
+    uint8_t count;
+    uint16_t reserved;
+    uint32_t table_crc;             // CRC32 of the entries in use
+    PartitionEntry entries[PART_MAX];
+} __attribute__((packed));
+
+struct ByteRange {
+    uint16_t addr;
+    uint16_t len;
+};
+
+bool initPartitions();              // Load the superblock (after initFRAM)
+bool reloadPartitions();            // Re-read the superblock of the chip present, quietly
+bool partitionsLoaded();
+const Superblock& partitionTable();
+
+const PartitionEntry* findPartition(const char* name);
+const PartitionEntry* findPartitionByType(uint8_t type);
+// Address-ordered ranges of partitions having all `flags`; the whole FRAM if no table
+uint8_t partitionRanges(uint8_t flags, ByteRange* ranges, uint8_t max_ranges);
+
+bool writeDefaultPartitions();
+bool sealPartitions(const char* name);  // nullptr: every partition flagged for backup
+bool verifyPartitions();            // Check sealed partitions against their CRC
+void printPartitionTable();
+
+#endif // PARTITION_TABLE_H
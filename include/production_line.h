@@ -0,0 +1,27 @@
+#ifndef PRODUCTION_LINE_H
+#define PRODUCTION_LINE_H
+
+#include <Arduino.h>
+#include "fram_programmer.h"
+
+// Production-line mode: records are loaded up front, then each chip inserted
+// into the fixture is detected, programmed, verified and logged automatically.
+#define LINE_MAX_RECORDS        32
+#define LINE_MAX_UNITS          64          // Units (including failures) tracked for statistics
+#define LINE_POLL_MS            20          // Insertion/removal polling interval
+#define LINE_DEBOUNCE_POLLS     5           // Consecutive polls needed to accept a state change
+
+// Pipeline stages timed for every unit
+enum LineStage {
+    STAGE_PREPARE,                  // Key derivation + encryption (done while the fixture is empty)
+    STAGE_WRITE,                    // Credentials write + read-back
+    STAGE_VERIFY,                   // Magic/version/checksum verification
+    STAGE_HANDLING,                 // Removal of previous unit until insertion of this one
+    STAGE_CYCLE,                    // Insertion to insertion
+    STAGE_COUNT
+};
+
+// Runs until all records are programmed or the operator presses 'q'
+void runProductionLine(const DeviceCredentials* records, size_t record_count);
+
+#endif // PRODUCTION_LINE_H
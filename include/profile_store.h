@@ -0,0 +1,55 @@
+#ifndef PROFILE_STORE_H
+#define PROFILE_STORE_H
+
+#include <Arduino.h>
+#include "fram_programmer.h"
+#include "credential_record.h"
+
+// Multiple credential profiles in the free space after the credentials section.
+// A directory entry per slot is indexed by FNV-1a(profile name) with linear
+// probing, and entry i owns record slot i. A lookup is one directory read plus
+// one read of exactly the record length kept in the entry.
+#define PROFILE_DIR_ADDR        0x0420
+#define PROFILE_DIR_MAGIC       0x464F5250  // "PROF"
+#define PROFILE_DIR_VERSION     1
+#define PROFILE_SLOTS           32
+#define PROFILE_SLOT_ADDR       0x0600
+#define PROFILE_SLOT_SIZE       768         // Largest v2 record plus its profile name
+#define PROFILE_NAME_MAX        23
+
+#define PROFILE_ENTRY_EMPTY     0x00
+#define PROFILE_ENTRY_USED      0x01
+#define PROFILE_ENTRY_DELETED   0x02        // Tombstone: keeps later probe chains reachable
+
+struct ProfileDirHeader {
+    uint32_t magic;
+    uint8_t version;
+    uint8_t slots;
+    uint16_t slot_size;
+} __attribute__((packed));
+
+struct ProfileDirEntry {
+    uint32_t name_hash;
+    uint16_t length;                // Record bytes in the slot
+    uint8_t state;
+    uint8_t reserved;
+} __attribute__((packed));
+
+struct ProfileLookup {
+    int16_t index;                  // Directory entry / slot, -1 if not found
+    uint8_t probes;                 // Entries examined
+    unsigned long dir_us;           // Directory read
+    unsigned long record_us;        // Record read(s) and parse
+};
+
+uint32_t profileNameHash(const char* name);
+bool validateProfileName(const String& name);
+
+bool profileFind(const char* name, CredentialRecord& rec, ProfileLookup* lookup);
+bool profileStore(const char* name, const DeviceCredentials& creds, ProfileLookup* lookup);
+bool profileDelete(const char* name);
+
+void printProfileList();
+void runProfileBench();
+
+#endif // PROFILE_STORE_H
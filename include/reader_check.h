@@ -0,0 +1,13 @@
+#ifndef READER_CHECK_H
+#define READER_CHECK_H
+
+#include <Arduino.h>
+#include "credential_record.h"
+
+// Cross-check of the portable ESP32-side reader (lib/fram_cred_reader) against
+// the firmware's own record parser, key derivation and decryption. Any drift in
+// the format shows up here before a chip leaves the programmer.
+bool crossCheckCredentialReader(const CredentialRecord& rec);   // Both must agree on every field
+bool testCredentialReader();                                    // Built-in test 6, with boot timing
+
+#endif // READER_CHECK_H
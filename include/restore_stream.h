@@ -0,0 +1,51 @@
+#ifndef RESTORE_STREAM_H
+#define RESTORE_STREAM_H
+
+#include <Arduino.h>
+#include "backup_codec.h"
+#include "chunk_ring.h"
+
+// Streaming restore of the text backup format (ADDR:/DATA: lines, or ZDATA:
+// lines for LZR backups). Core 0 decodes lines into a chunk ring while core 1
+// drains it, writing and verifying each chunk, so FRAM writes overlap with
+// receiving the next lines over USB and only the ring is resident.
+#define RESTORE_LINE_MAX_BYTES  128         // Decoded bytes per DATA/ZDATA line
+#define RESTORE_ERROR_LOG       8           // Failed chunks reported in detail
+
+struct RestoreError {
+    uint16_t addr;                  // Chunk start
+    uint16_t len;
+    uint16_t error_addr;            // First mismatching address
+};
+
+struct RestoreStream {
+    ChunkRing ring;
+    RingSlot* filling;              // Slot being decoded into, nullptr if none
+    uint32_t next_addr;             // FRAM address of the next decoded byte
+    bool addr_invalid;              // Last ADDR: was malformed; data is dropped until the next one
+    bool compressed;
+    LzrDecoder decoder;
+    size_t expected_size;
+    size_t lines;
+    size_t bytes_received;
+    size_t line_errors;
+    bool ended;
+    unsigned long start_us;
+    unsigned long elapsed_us;
+    
+    // Written by core 1, read by core 0 once the writer job has finished
+    size_t bytes_written;
+    size_t chunks_written;
+    size_t chunk_errors;
+    RestoreError errors[RESTORE_ERROR_LOG];
+};
+
+// Starts the writer on core 1; false if core 1 is busy
+bool restoreBegin(RestoreStream& stream);
+// Parse one backup line; false if the line was malformed (already reported)
+bool restoreFeedLine(RestoreStream& stream, const String& line);
+// Write out the last chunk and wait for core 1; true if every chunk verified
+bool restoreFinish(RestoreStream& stream);
+void printRestoreReport(const RestoreStream& stream);
+
+#endif // RESTORE_STREAM_H
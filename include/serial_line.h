@@ -0,0 +1,45 @@
+#ifndef SERIAL_LINE_H
+#define SERIAL_LINE_H
+
+#include <Arduino.h>
+
+// Console input engine. Every call drains all bytes the USB CDC holds into a
+// fixed ring, so pasted input moves at link speed and lines typed while a
+// command runs (typeahead) are kept in order for the next prompt or command.
+// One line editor assembles lines from the ring for both the CLI loop and
+// interactive prompts; prompts give up after an idle timeout. Reading input
+// first sends any buffered console output (console_out.h).
+#define SERIAL_RING_SIZE            2048        // Receive ring (power of two)
+#define SERIAL_LINE_MAX             1024        // Longest line; longer lines are dropped whole
+#define SERIAL_PROMPT_TIMEOUT_MS    120000UL    // Default prompt idle timeout (0 = wait forever)
+
+enum LineResult {
+    LINE_PENDING,                   // No complete line yet
+    LINE_READY,                     // serialLineText() holds the line
+    LINE_TIMEOUT,                   // Idle timeout; the partial line was discarded
+    LINE_TOO_LONG                   // Line exceeded SERIAL_LINE_MAX and was dropped
+};
+
+struct SerialLineStats {
+    uint32_t bytes_in;
+    uint32_t lines;
+    uint32_t timeouts;
+    uint32_t too_long;
+    uint16_t ring_peak;             // Highest ring fill seen (typeahead depth)
+};
+
+void serialPump();                  // Move waiting USB bytes into the ring
+bool serialInputPending();          // Ring or USB hold unread bytes
+int serialReadByte();               // Raw byte from the ring, then USB; -1 if none
+int serialPeekByte();               // Same, without consuming it
+
+LineResult pollSerialLine(bool echo);                                   // Never blocks
+LineResult waitSerialLine(bool echo, unsigned long idle_timeout_ms);    // Blocks until a line or timeout
+const char* serialLineText();       // Valid until the next poll/wait
+size_t serialLineLength();
+
+void setSerialPromptTimeout(unsigned long timeout_ms);
+unsigned long serialPromptTimeout();
+const SerialLineStats& serialLineStats();
+
+#endif // SERIAL_LINE_H
@@ -0,0 +1,52 @@
+// ESP32 boot-time read of the credentials written by the FRAM Programmer.
+// One 12-byte header read, one read of the record, then only the SSID is decrypted;
+// prints the time each step takes.
+#include <Wire.h>
+#include <Adafruit_FRAM_I2C.h>
+#include <fram_cred_reader.h>
+
+#define FRAM_CREDENTIALS_ADDR   0x0018
+
+Adafruit_FRAM_I2C fram;
+uint8_t record[fram_cred::kMaxRecordSize];
+
+void setup() {
+    Serial.begin(115200);
+    Wire.begin();
+    if (!fram.begin(0x50)) {
+        Serial.println("FRAM not found");
+        return;
+    }
+    
+    unsigned long start = micros();
+    fram.read(FRAM_CREDENTIALS_ADDR, record, fram_cred::kV2HeaderSize);
+    uint32_t size = fram_cred::kV1Size;             // v1 and unknown: fixed layout
+    if (record[4] == fram_cred::kVersion2 && record[5] == 0) {
+        size = fram_cred::kV2HeaderSize + (record[6] | (record[7] << 8));
+        if (size > sizeof(record)) size = sizeof(record);
+    }
+    fram.read(FRAM_CREDENTIALS_ADDR + fram_cred::kV2HeaderSize, record + fram_cred::kV2HeaderSize,
+              size - fram_cred::kV2HeaderSize);
+    unsigned long read_us = micros() - start;
+    
+    start = micros();
+    fram_cred::Record rec;
+    if (!fram_cred::parse(record, size, rec) || !fram_cred::check(rec)) {
+        Serial.println("No valid credentials");
+        return;
+    }
+    fram_cred::Decryptor reader(rec);
+    char ssid[64];
+    uint32_t ssid_len = sizeof(ssid) - 1;
+    if (!reader.verifyKey() || !reader.field(fram_cred::kWifiSsid, (uint8_t*)ssid, &ssid_len)) {
+        Serial.println("Credentials do not decrypt");
+        return;
+    }
+    ssid[ssid_len] = '\0';
+    unsigned long decrypt_us = micros() - start;
+    
+    Serial.printf("SSID '%s': FRAM read %lu us, parse + key + decrypt %lu us\n", ssid, read_us, decrypt_us);
+}
+
+void loop() {
+}
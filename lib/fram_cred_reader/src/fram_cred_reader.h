@@ -0,0 +1,476 @@
+#ifndef FRAM_CRED_READER_H
+#define FRAM_CRED_READER_H
+
+// Header-only reader for the credential records this programmer writes (v1 and v2).
+// For the ESP32 side: point it at the bytes read from FRAM offset 0x0018 and decrypt
+// only the fields that are needed. Depends on <cstdint> only - no Arduino String, no
+// heap, no copies of the record. Built from the programmer's aes.cpp, sha256.cpp and
+// encryption.cpp; the programmer's `test` command checks it against them.
+//
+//   fram_cred::Record rec;
+//   if (fram_cred::parse(buf, len, rec) && fram_cred::check(rec)) {
+//       fram_cred::Decryptor dec(rec);
+//       char ssid[64]; uint32_t ssid_len = sizeof(ssid) - 1;
+//       if (dec.field(fram_cred::kWifiSsid, (uint8_t*)ssid, &ssid_len)) ssid[ssid_len] = '\0';
+//   }
+
+#include <cstdint>
+
+namespace fram_cred {
+
+constexpr uint32_t kMagic        = 0x43524544;  // "CRED"
+constexpr uint16_t kVersion1     = 0x0001;      // Fixed 1024-byte layout
+constexpr uint16_t kVersion2     = 0x0002;      // 12-byte header + TLV entries
+constexpr uint32_t kV1Size       = 512;         // v1 bytes a reader needs
+constexpr uint32_t kV2HeaderSize = 12;
+constexpr uint32_t kMaxRecordSize = 1024;       // Credentials section
+constexpr uint32_t kBlockSize    = 16;
+constexpr uint32_t kKeySize      = 32;
+constexpr uint32_t kIvSize       = 8;
+constexpr uint32_t kSaltSize     = 8;
+constexpr uint32_t kMaxNameLen   = 31;
+
+// Key material: device name + these + optional per-record salt (v2 entry 0x08)
+constexpr char kKeySalt[] = "ESP32_WATER_SYSTEM_2024_SECURE_SALT_V1";
+constexpr char kKeySeed[] = "WATER_DOLEWKA_FIXED_SEED_12345";
+
+enum Field : uint8_t {
+    kWifiSsid,
+    kWifiPassword,
+    kAdminHash,             // v1: 64 hex characters, v2: raw 32-byte SHA-256
+    kVpsToken,
+    kFieldCount
+};
+
+// A view into the caller's buffer
+struct Span {
+    const uint8_t* data;
+    uint16_t len;
+};
+
+struct Record {
+    uint16_t version;       // 0 if parse() failed
+    uint16_t size;          // Bytes of the buffer the record occupies
+    const uint8_t* base;
+    Span name;              // Not terminated
+    Span iv;
+    Span salt;              // len 0 when absent
+    Span fields[kFieldCount];
+    bool admin_hash_hex;
+};
+
+namespace detail {
+
+inline uint16_t le16(const uint8_t* p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+inline uint32_t le32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+inline uint32_t cstrLen(const char* s) {
+    uint32_t n = 0;
+    while (s[n]) n++;
+    return n;
+}
+
+// Bitwise CRC-32 (0xEDB88320); records are small enough to skip the table
+inline uint32_t crc32Update(uint32_t crc, const uint8_t* data, uint32_t len) {
+    crc = ~crc;
+    for (uint32_t i = 0; i < len; i++) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+        }
+    }
+    return ~crc;
+}
+
+class Sha256 {
+public:
+    Sha256() : blocklen_(0), bitlen_(0) {
+        static const uint32_t init[8] = { 0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+                                          0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19 };
+        for (int i = 0; i < 8; i++) state_[i] = init[i];
+    }
+
+    void update(const uint8_t* data, uint32_t len) {
+        for (uint32_t i = 0; i < len; i++) {
+            block_[blocklen_++] = data[i];
+            if (blocklen_ == 64) {
+                transform();
+                bitlen_ += 512;
+                blocklen_ = 0;
+            }
+        }
+    }
+
+    void final(uint8_t* hash) {
+        uint64_t bitlen = bitlen_ + (uint64_t)blocklen_ * 8;
+        uint32_t i = blocklen_;
+        block_[i++] = 0x80;
+        if (i > 56) {
+            while (i < 64) block_[i++] = 0;
+            transform();
+            i = 0;
+        }
+        while (i < 56) block_[i++] = 0;
+        for (int j = 7; j >= 0; j--) {
+            block_[56 + (7 - j)] = (uint8_t)(bitlen >> (j * 8));
+        }
+        transform();
+        for (int j = 0; j < 8; j++) {
+            hash[j * 4]     = (uint8_t)(state_[j] >> 24);
+            hash[j * 4 + 1] = (uint8_t)(state_[j] >> 16);
+            hash[j * 4 + 2] = (uint8_t)(state_[j] >> 8);
+            hash[j * 4 + 3] = (uint8_t)(state_[j]);
+        }
+    }
+
+private:
+    uint8_t block_[64];
+    uint32_t blocklen_;
+    uint64_t bitlen_;
+    uint32_t state_[8];
+
+    static uint32_t rotr(uint32_t x, uint32_t n) { return (x >> n) | (x << (32 - n)); }
+
+    void transform() {
+        static const uint32_t k[64] = {
+            0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+            0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+            0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+            0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+            0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+            0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+            0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+            0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+        };
+        uint32_t m[64];
+        for (int i = 0; i < 16; i++) {
+            m[i] = ((uint32_t)block_[i * 4] << 24) | ((uint32_t)block_[i * 4 + 1] << 16) |
+                   ((uint32_t)block_[i * 4 + 2] << 8) | (uint32_t)block_[i * 4 + 3];
+        }
+        for (int i = 16; i < 64; i++) {
+            uint32_t s0 = rotr(m[i - 15], 7) ^ rotr(m[i - 15], 18) ^ (m[i - 15] >> 3);
+            uint32_t s1 = rotr(m[i - 2], 17) ^ rotr(m[i - 2], 19) ^ (m[i - 2] >> 10);
+            m[i] = s1 + m[i - 7] + s0 + m[i - 16];
+        }
+
+        uint32_t s[8];
+        for (int i = 0; i < 8; i++) s[i] = state_[i];
+        for (int i = 0; i < 64; i++) {
+            uint32_t maj = (s[0] & s[1]) ^ (s[0] & s[2]) ^ (s[1] & s[2]);
+            uint32_t ch = (s[4] & s[5]) ^ (~s[4] & s[6]);
+            uint32_t sum = m[i] + k[i] + s[7] + ch + (rotr(s[4], 6) ^ rotr(s[4], 11) ^ rotr(s[4], 25));
+            uint32_t new_a = (rotr(s[0], 2) ^ rotr(s[0], 13) ^ rotr(s[0], 22)) + maj + sum;
+            uint32_t new_e = s[3] + sum;
+            s[7] = s[6]; s[6] = s[5]; s[5] = s[4]; s[4] = new_e;
+            s[3] = s[2]; s[2] = s[1]; s[1] = s[0]; s[0] = new_a;
+        }
+        for (int i = 0; i < 8; i++) state_[i] += s[i];
+    }
+};
+
+// AES-256, decryption only (the reader never encrypts)
+class Aes256Decrypt {
+public:
+    void setKey(const uint8_t* key) {
+        for (int i = 0; i < 32; i++) round_keys_[i] = key[i];
+        for (int i = 32; i < 240; i += 4) {
+            uint8_t t[4] = { round_keys_[i - 4], round_keys_[i - 3], round_keys_[i - 2], round_keys_[i - 1] };
+            if (i % 32 == 0) {
+                uint8_t first = t[0];
+                t[0] = sbox()[t[1]] ^ rcon(i / 32);
+                t[1] = sbox()[t[2]];
+                t[2] = sbox()[t[3]];
+                t[3] = sbox()[first];
+            } else if (i % 32 == 16) {
+                for (int j = 0; j < 4; j++) t[j] = sbox()[t[j]];
+            }
+            for (int j = 0; j < 4; j++) round_keys_[i + j] = round_keys_[i - 32 + j] ^ t[j];
+        }
+    }
+
+    ~Aes256Decrypt() {
+        volatile uint8_t* p = round_keys_;
+        for (int i = 0; i < 240; i++) p[i] = 0;
+    }
+
+    void decryptBlock(const uint8_t* in, uint8_t* out) const {
+        for (int i = 0; i < 16; i++) out[i] = in[i] ^ round_keys_[14 * 16 + i];
+        for (int round = 13; round >= 0; round--) {
+            invShiftRows(out);
+            for (int i = 0; i < 16; i++) out[i] = invSbox()[out[i]] ^ round_keys_[round * 16 + i];
+            if (round > 0) invMixColumns(out);
+        }
+    }
+
+private:
+    uint8_t round_keys_[240];
+
+    static uint8_t rcon(int i) {
+        static const uint8_t table[8] = { 0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40 };
+        return table[i];
+    }
+
+    static const uint8_t* sbox() {
+        static const uint8_t table[256] = {
+            0x63, 0x7C, 0x77, 0x7B, 0xF2, 0x6B, 0x6F, 0xC5, 0x30, 0x01, 0x67, 0x2B, 0xFE, 0xD7, 0xAB, 0x76,
+            0xCA, 0x82, 0xC9, 0x7D, 0xFA, 0x59, 0x47, 0xF0, 0xAD, 0xD4, 0xA2, 0xAF, 0x9C, 0xA4, 0x72, 0xC0,
+            0xB7, 0xFD, 0x93, 0x26, 0x36, 0x3F, 0xF7, 0xCC, 0x34, 0xA5, 0xE5, 0xF1, 0x71, 0xD8, 0x31, 0x15,
+            0x04, 0xC7, 0x23, 0xC3, 0x18, 0x96, 0x05, 0x9A, 0x07, 0x12, 0x80, 0xE2, 0xEB, 0x27, 0xB2, 0x75,
+            0x09, 0x83, 0x2C, 0x1A, 0x1B, 0x6E, 0x5A, 0xA0, 0x52, 0x3B, 0xD6, 0xB3, 0x29, 0xE3, 0x2F, 0x84,
+            0x53, 0xD1, 0x00, 0xED, 0x20, 0xFC, 0xB1, 0x5B, 0x6A, 0xCB, 0xBE, 0x39, 0x4A, 0x4C, 0x58, 0xCF,
+            0xD0, 0xEF, 0xAA, 0xFB, 0x43, 0x4D, 0x33, 0x85, 0x45, 0xF9, 0x02, 0x7F, 0x50, 0x3C, 0x9F, 0xA8,
+            0x51, 0xA3, 0x40, 0x8F, 0x92, 0x9D, 0x38, 0xF5, 0xBC, 0xB6, 0xDA, 0x21, 0x10, 0xFF, 0xF3, 0xD2,
+            0xCD, 0x0C, 0x13, 0xEC, 0x5F, 0x97, 0x44, 0x17, 0xC4, 0xA7, 0x7E, 0x3D, 0x64, 0x5D, 0x19, 0x73,
+            0x60, 0x81, 0x4F, 0xDC, 0x22, 0x2A, 0x90, 0x88, 0x46, 0xEE, 0xB8, 0x14, 0xDE, 0x5E, 0x0B, 0xDB,
+            0xE0, 0x32, 0x3A, 0x0A, 0x49, 0x06, 0x24, 0x5C, 0xC2, 0xD3, 0xAC, 0x62, 0x91, 0x95, 0xE4, 0x79,
+            0xE7, 0xC8, 0x37, 0x6D, 0x8D, 0xD5, 0x4E, 0xA9, 0x6C, 0x56, 0xF4, 0xEA, 0x65, 0x7A, 0xAE, 0x08,
+            0xBA, 0x78, 0x25, 0x2E, 0x1C, 0xA6, 0xB4, 0xC6, 0xE8, 0xDD, 0x74, 0x1F, 0x4B, 0xBD, 0x8B, 0x8A,
+            0x70, 0x3E, 0xB5, 0x66, 0x48, 0x03, 0xF6, 0x0E, 0x61, 0x35, 0x57, 0xB9, 0x86, 0xC1, 0x1D, 0x9E,
+            0xE1, 0xF8, 0x98, 0x11, 0x69, 0xD9, 0x8E, 0x94, 0x9B, 0x1E, 0x87, 0xE9, 0xCE, 0x55, 0x28, 0xDF,
+            0x8C, 0xA1, 0x89, 0x0D, 0xBF, 0xE6, 0x42, 0x68, 0x41, 0x99, 0x2D, 0x0F, 0xB0, 0x54, 0xBB, 0x16
+        };
+        return table;
+    }
+
+    static const uint8_t* invSbox() {
+        static const uint8_t table[256] = {
+            0x52, 0x09, 0x6A, 0xD5, 0x30, 0x36, 0xA5, 0x38, 0xBF, 0x40, 0xA3, 0x9E, 0x81, 0xF3, 0xD7, 0xFB,
+            0x7C, 0xE3, 0x39, 0x82, 0x9B, 0x2F, 0xFF, 0x87, 0x34, 0x8E, 0x43, 0x44, 0xC4, 0xDE, 0xE9, 0xCB,
+            0x54, 0x7B, 0x94, 0x32, 0xA6, 0xC2, 0x23, 0x3D, 0xEE, 0x4C, 0x95, 0x0B, 0x42, 0xFA, 0xC3, 0x4E,
+            0x08, 0x2E, 0xA1, 0x66, 0x28, 0xD9, 0x24, 0xB2, 0x76, 0x5B, 0xA2, 0x49, 0x6D, 0x8B, 0xD1, 0x25,
+            0x72, 0xF8, 0xF6, 0x64, 0x86, 0x68, 0x98, 0x16, 0xD4, 0xA4, 0x5C, 0xCC, 0x5D, 0x65, 0xB6, 0x92,
+            0x6C, 0x70, 0x48, 0x50, 0xFD, 0xED, 0xB9, 0xDA, 0x5E, 0x15, 0x46, 0x57, 0xA7, 0x8D, 0x9D, 0x84,
+            0x90, 0xD8, 0xAB, 0x00, 0x8C, 0xBC, 0xD3, 0x0A, 0xF7, 0xE4, 0x58, 0x05, 0xB8, 0xB3, 0x45, 0x06,
+            0xD0, 0x2C, 0x1E, 0x8F, 0xCA, 0x3F, 0x0F, 0x02, 0xC1, 0xAF, 0xBD, 0x03, 0x01, 0x13, 0x8A, 0x6B,
+            0x3A, 0x91, 0x11, 0x41, 0x4F, 0x67, 0xDC, 0xEA, 0x97, 0xF2, 0xCF, 0xCE, 0xF0, 0xB4, 0xE6, 0x73,
+            0x96, 0xAC, 0x74, 0x22, 0xE7, 0xAD, 0x35, 0x85, 0xE2, 0xF9, 0x37, 0xE8, 0x1C, 0x75, 0xDF, 0x6E,
+            0x47, 0xF1, 0x1A, 0x71, 0x1D, 0x29, 0xC5, 0x89, 0x6F, 0xB7, 0x62, 0x0E, 0xAA, 0x18, 0xBE, 0x1B,
+            0xFC, 0x56, 0x3E, 0x4B, 0xC6, 0xD2, 0x79, 0x20, 0x9A, 0xDB, 0xC0, 0xFE, 0x78, 0xCD, 0x5A, 0xF4,
+            0x1F, 0xDD, 0xA8, 0x33, 0x88, 0x07, 0xC7, 0x31, 0xB1, 0x12, 0x10, 0x59, 0x27, 0x80, 0xEC, 0x5F,
+            0x60, 0x51, 0x7F, 0xA9, 0x19, 0xB5, 0x4A, 0x0D, 0x2D, 0xE5, 0x7A, 0x9F, 0x93, 0xC9, 0x9C, 0xEF,
+            0xA0, 0xE0, 0x3B, 0x4D, 0xAE, 0x2A, 0xF5, 0xB0, 0xC8, 0xEB, 0xBB, 0x3C, 0x83, 0x53, 0x99, 0x61,
+            0x17, 0x2B, 0x04, 0x7E, 0xBA, 0x77, 0xD6, 0x26, 0xE1, 0x69, 0x14, 0x63, 0x55, 0x21, 0x0C, 0x7D
+        };
+        return table;
+    }
+
+    static uint8_t xtime(uint8_t a) { return (uint8_t)((a << 1) ^ ((a & 0x80) ? 0x1B : 0x00)); }
+
+    static void invShiftRows(uint8_t* s) {
+        uint8_t t = s[13]; s[13] = s[9]; s[9] = s[5]; s[5] = s[1]; s[1] = t;
+        t = s[2]; s[2] = s[10]; s[10] = t;
+        t = s[6]; s[6] = s[14]; s[14] = t;
+        t = s[7]; s[7] = s[11]; s[11] = s[15]; s[15] = s[3]; s[3] = t;
+    }
+
+    static void invMixColumns(uint8_t* s) {
+        for (int col = 0; col < 16; col += 4) {
+            uint8_t a0 = s[col], a1 = s[col + 1], a2 = s[col + 2], a3 = s[col + 3];
+            // Multiply by {0E,0B,0D,09} via doublings
+            uint8_t x0 = xtime(a0), x1 = xtime(a1), x2 = xtime(a2), x3 = xtime(a3);
+            uint8_t y0 = xtime(x0), y1 = xtime(x1), y2 = xtime(x2), y3 = xtime(x3);
+            uint8_t z0 = xtime(y0), z1 = xtime(y1), z2 = xtime(y2), z3 = xtime(y3);
+            // 09 = z ^ a, 0B = z ^ x ^ a, 0D = z ^ y ^ a, 0E = z ^ y ^ x
+            s[col]     = (z0 ^ y0 ^ x0) ^ (z1 ^ x1 ^ a1) ^ (z2 ^ y2 ^ a2) ^ (z3 ^ a3);
+            s[col + 1] = (z0 ^ a0) ^ (z1 ^ y1 ^ x1) ^ (z2 ^ x2 ^ a2) ^ (z3 ^ y3 ^ a3);
+            s[col + 2] = (z0 ^ y0 ^ a0) ^ (z1 ^ a1) ^ (z2 ^ y2 ^ x2) ^ (z3 ^ x3 ^ a3);
+            s[col + 3] = (z0 ^ x0 ^ a0) ^ (z1 ^ y1 ^ a1) ^ (z2 ^ a2) ^ (z3 ^ y3 ^ x3);
+        }
+    }
+};
+
+// Length of the PKCS7 padding that ends a block, 0 if none
+inline uint32_t blockPadding(const uint8_t* block) {
+    uint8_t pad = block[kBlockSize - 1];
+    if (pad == 0 || pad > kBlockSize) return 0;
+    for (uint32_t i = kBlockSize - pad; i < kBlockSize; i++) {
+        if (block[i] != pad) return 0;
+    }
+    return pad;
+}
+
+inline bool parseV1(const uint8_t* data, uint32_t len, Record& rec) {
+    if (len < kV1Size) return false;
+    uint16_t name_len = 0;
+    while (name_len < 32 && data[8 + name_len] != 0) name_len++;
+    if (name_len == 0 || name_len > kMaxNameLen) return false;
+
+    rec.name = { data + 8, name_len };
+    rec.iv = { data + 40, (uint16_t)kIvSize };
+    rec.salt = { nullptr, 0 };
+    rec.fields[kWifiSsid] = { data + 48, 64 };
+    rec.fields[kWifiPassword] = { data + 112, 128 };
+    rec.fields[kAdminHash] = { data + 240, 96 };
+    rec.fields[kVpsToken] = { data + 336, 160 };
+    rec.admin_hash_hex = true;
+    rec.size = (uint16_t)kV1Size;
+    return true;
+}
+
+inline bool parseV2(const uint8_t* data, uint32_t len, Record& rec) {
+    if (len < kV2HeaderSize) return false;
+    uint32_t end = kV2HeaderSize + le16(data + 6);
+    if (end > len || end > kMaxRecordSize) return false;
+
+    const Span none = { nullptr, 0 };
+    rec.name = rec.iv = rec.salt = none;
+    for (uint32_t f = 0; f < kFieldCount; f++) rec.fields[f] = none;
+    rec.admin_hash_hex = false;
+
+    for (uint32_t pos = kV2HeaderSize; pos < end; ) {
+        if (pos + 3 > end) return false;
+        uint8_t type = data[pos];
+        uint16_t entry_len = le16(data + pos + 1);
+        Span value = { data + pos + 3, entry_len };
+        pos += 3 + entry_len;
+        if (pos > end) return false;
+
+        switch (type) {
+            case 0x01: rec.name = value; break;
+            case 0x02: rec.iv = value; break;
+            case 0x03: rec.fields[kWifiSsid] = value; break;
+            case 0x04: rec.fields[kWifiPassword] = value; break;
+            case 0x05: rec.fields[kAdminHash] = value; break;
+            case 0x06: rec.fields[kVpsToken] = value; break;
+            case 0x08:
+                if (entry_len != kSaltSize) return false;
+                rec.salt = value;
+                break;
+            default: break;     // 0x07 profile name and future types
+        }
+    }
+
+    for (uint32_t f = 0; f < kFieldCount; f++) {
+        if (rec.fields[f].len == 0 || rec.fields[f].len % kBlockSize != 0) return false;
+    }
+    rec.size = (uint16_t)end;
+    return rec.name.len > 0 && rec.name.len <= kMaxNameLen && rec.iv.len == kIvSize;
+}
+
+} // namespace detail
+
+// Locate the fields of a record in data[0, len). Nothing is copied: the spans in
+// rec point into data, which must outlive it. Does not check integrity.
+inline bool parse(const uint8_t* data, uint32_t len, Record& rec) {
+    rec.version = 0;
+    rec.base = data;
+    if (len < 8 || detail::le32(data) != kMagic) return false;
+
+    uint16_t version = detail::le16(data + 4);
+    bool ok = version == kVersion1 ? detail::parseV1(data, len, rec)
+            : version == kVersion2 ? detail::parseV2(data, len, rec)
+            : false;
+    rec.version = ok ? version : 0;
+    return ok;
+}
+
+// v1: 16-bit byte sum before the checksum at 496. v2: CRC-32 of the first 8
+// header bytes and the entries, stored at header offset 8
+inline bool check(const Record& rec) {
+    const uint8_t* data = rec.base;
+    if (rec.version == kVersion1) {
+        uint16_t sum = 0;
+        for (uint32_t i = 0; i < 496; i++) sum += data[i];
+        return sum == detail::le16(data + 496);
+    }
+    if (rec.version == kVersion2) {
+        uint32_t crc = detail::crc32Update(0, data, 8);
+        crc = detail::crc32Update(crc, data + kV2HeaderSize, rec.size - kV2HeaderSize);
+        return crc == detail::le32(data + 8);
+    }
+    return false;
+}
+
+// SHA-256(device name + key salt + key seed [+ record salt])
+inline void deriveKey(const Record& rec, uint8_t* key) {
+    detail::Sha256 sha;
+    sha.update(rec.name.data, rec.name.len);
+    sha.update((const uint8_t*)kKeySalt, detail::cstrLen(kKeySalt));
+    sha.update((const uint8_t*)kKeySeed, detail::cstrLen(kKeySeed));
+    if (rec.salt.len > 0) sha.update(rec.salt.data, rec.salt.len);
+    sha.final(key);
+}
+
+// Holds the expanded key for one record and decrypts fields on demand.
+// The record's buffer must stay valid while the Decryptor is used
+class Decryptor {
+public:
+    explicit Decryptor(const Record& rec) : rec_(rec) {
+        uint8_t key[kKeySize];
+        deriveKey(rec, key);
+        aes_.setKey(key);
+        volatile uint8_t* p = key;
+        for (uint32_t i = 0; i < kKeySize; i++) p[i] = 0;
+    }
+
+    // Decrypt one field into out. *out_len: capacity in, plaintext length out.
+    // Padding is stripped before a block is copied, so out needs room only for
+    // the plaintext; no terminator is written.
+    bool field(Field id, uint8_t* out, uint32_t* out_len) const {
+        if (rec_.version == 0 || id >= kFieldCount) return false;
+        const Span& f = rec_.fields[id];
+        if (f.len == 0 || f.len % kBlockSize != 0) return false;
+        bool exact = rec_.version == kVersion2;
+
+        uint8_t chain[kBlockSize];
+        expandIv(chain);
+        uint32_t capacity = *out_len;
+        uint32_t written = 0;
+        for (uint32_t off = 0; off < f.len; off += kBlockSize) {
+            uint8_t block[kBlockSize];
+            aes_.decryptBlock(f.data + off, block);
+            for (uint32_t j = 0; j < kBlockSize; j++) {
+                block[j] ^= chain[j];
+                chain[j] = f.data[off + j];
+            }
+
+            // v2: padding ends the field. v1: it ends the first block where it is
+            // valid with data before it; the rest of the field is encrypted zeros
+            bool last = off + kBlockSize == f.len;
+            uint32_t pad = (last || !exact) ? detail::blockPadding(block) : 0;
+            if (off + kBlockSize == pad) pad = 0;
+            if (exact && last && pad == 0) return false;
+
+            uint32_t n = kBlockSize - pad;
+            if (written + n > capacity) return false;
+            for (uint32_t j = 0; j < n; j++) out[written + j] = block[j];
+            written += n;
+            if (pad > 0) {
+                *out_len = written;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Key check from one block: the admin hash has a fixed length, so the block
+    // after it is sixteen 0x10 padding bytes
+    bool verifyKey() const {
+        const Span& f = rec_.fields[kAdminHash];
+        uint32_t off = rec_.admin_hash_hex ? 64 : 32;
+        if (rec_.version == 0 || f.len < off + kBlockSize) return false;
+        if (rec_.version == kVersion2 && f.len != off + kBlockSize) return false;
+
+        uint8_t block[kBlockSize];
+        aes_.decryptBlock(f.data + off, block);
+        for (uint32_t j = 0; j < kBlockSize; j++) {
+            if ((block[j] ^ f.data[off - kBlockSize + j]) != kBlockSize) return false;
+        }
+        return true;
+    }
+
+private:
+    Record rec_;                // Spans still point into the caller's buffer
+    detail::Aes256Decrypt aes_;
+
+    // The stored 8-byte IV repeated to 16 bytes
+    void expandIv(uint8_t* full) const {
+        for (uint32_t i = 0; i < kBlockSize; i++) full[i] = rec_.iv.data[i % kIvSize];
+    }
+};
+
+} // namespace fram_cred
+
+#endif // FRAM_CRED_READER_H
@@ -0,0 +1,279 @@
+#include "backup_codec.h"
+
+// Decoder states
+enum {
+    DEC_TAG,
+    DEC_LEN,
+    DEC_DIST,
+    DEC_LITERAL,
+    DEC_RUN_VALUE
+};
+
+// ---------------------------------------------------------------------------
+// Encoder
+// ---------------------------------------------------------------------------
+
+static uint32_t hash3(const uint8_t* p) {
+    uint32_t v = ((uint32_t)p[0] << 16) | ((uint32_t)p[1] << 8) | p[2];
+    return (v * 2654435761u) >> (32 - LZR_HASH_BITS);
+}
+
+static void putVarint(LzrEncoder& enc, uint32_t value) {
+    while (value >= 0x80) {
+        enc.out[enc.out_len++] = (value & 0x7F) | 0x80;
+        value >>= 7;
+    }
+    enc.out[enc.out_len++] = value;
+}
+
+static void flushLiteral(LzrEncoder& enc) {
+    if (enc.literal_len == 0) {
+        return;
+    }
+    enc.out[enc.out_len++] = LZR_TOKEN_LITERAL;
+    putVarint(enc, enc.literal_len);
+    memcpy(&enc.out[enc.out_len], enc.literal, enc.literal_len);
+    enc.out_len += enc.literal_len;
+    enc.literal_len = 0;
+}
+
+static void flushRun(LzrEncoder& enc) {
+    if (enc.run_len == 0) {
+        return;
+    }
+    enc.out[enc.out_len++] = LZR_TOKEN_RUN;
+    putVarint(enc, enc.run_len);
+    enc.out[enc.out_len++] = enc.run_value;
+    enc.run_len = 0;
+}
+
+// Keep the lookahead full, sliding history so at most LZR_WINDOW_SIZE bytes stay behind pos
+static void refill(LzrEncoder& enc) {
+    while (!enc.input_done && enc.end - enc.pos < LZR_LOOKAHEAD) {
+        if (enc.pos > LZR_WINDOW_SIZE) {
+            size_t shift = enc.pos - LZR_WINDOW_SIZE;
+            memmove(enc.buf, &enc.buf[shift], enc.end - shift);
+            enc.pos -= shift;
+            enc.end -= shift;
+            enc.base += shift;
+        }
+        
+        size_t n = enc.source(&enc.buf[enc.end], sizeof(enc.buf) - enc.end, enc.source_ctx);
+        if (n == 0) {
+            enc.input_done = true;
+        }
+        enc.end += n;
+        enc.raw_bytes += n;
+    }
+}
+
+static void insertHash(LzrEncoder& enc, size_t at) {
+    if (enc.end - at >= 3) {
+        enc.head[hash3(&enc.buf[at])] = enc.base + at + 1;
+    }
+}
+
+// Consume input until at least one token is staged or the input is exhausted
+static void encodeStep(LzrEncoder& enc) {
+    refill(enc);
+    
+    size_t avail = enc.end - enc.pos;
+    if (avail == 0) {
+        flushRun(enc);
+        flushLiteral(enc);
+        return;
+    }
+    
+    const uint8_t* p = &enc.buf[enc.pos];
+    
+    // Extend the current run across refills
+    if (enc.run_len > 0) {
+        if (p[0] == enc.run_value) {
+            enc.run_len++;
+            enc.pos++;
+            return;
+        }
+        flushRun(enc);
+        return;
+    }
+    
+    // Start a run
+    if (avail >= LZR_MIN_RUN && p[1] == p[0] && p[2] == p[0] && p[3] == p[0]) {
+        flushLiteral(enc);
+        enc.run_value = p[0];
+        enc.run_len = LZR_MIN_RUN;
+        enc.pos += LZR_MIN_RUN;
+        return;
+    }
+    
+    // Back-reference into the history window
+    if (avail >= LZR_MIN_MATCH) {
+        uint32_t h = hash3(p);
+        uint32_t candidate = enc.head[h];
+        uint32_t here = enc.base + enc.pos;
+        enc.head[h] = here + 1;
+        
+        if (candidate > enc.base && here - (candidate - 1) <= LZR_WINDOW_SIZE) {
+            const uint8_t* c = &enc.buf[candidate - 1 - enc.base];
+            size_t max_len = min(avail, (size_t)LZR_MAX_MATCH);
+            size_t len = 0;
+            while (len < max_len && c[len] == p[len]) {
+                len++;
+            }
+            
+            if (len >= LZR_MIN_MATCH) {
+                flushLiteral(enc);
+                enc.out[enc.out_len++] = LZR_TOKEN_MATCH;
+                putVarint(enc, len);
+                putVarint(enc, here - (candidate - 1));
+                for (size_t i = 1; i < len; i++) {
+                    insertHash(enc, enc.pos + i);
+                }
+                enc.pos += len;
+                return;
+            }
+        }
+    }
+    
+    enc.literal[enc.literal_len++] = p[0];
+    enc.pos++;
+    if (enc.literal_len == LZR_MAX_LITERAL) {
+        flushLiteral(enc);
+    }
+}
+
+void lzrEncoderInit(LzrEncoder& enc, LzrSource source, void* ctx) {
+    memset(&enc, 0, sizeof(enc));
+    enc.source = source;
+    enc.source_ctx = ctx;
+}
+
+size_t lzrEncodeRead(LzrEncoder& enc, uint8_t* out, size_t cap) {
+    size_t written = 0;
+    
+    while (written < cap) {
+        if (enc.out_pos < enc.out_len) {
+            size_t n = min(cap - written, enc.out_len - enc.out_pos);
+            memcpy(&out[written], &enc.out[enc.out_pos], n);
+            enc.out_pos += n;
+            written += n;
+            continue;
+        }
+        
+        enc.out_len = 0;
+        enc.out_pos = 0;
+        
+        if (enc.input_done && enc.pos == enc.end && enc.run_len == 0 && enc.literal_len == 0) {
+            break;
+        }
+        encodeStep(enc);
+    }
+    
+    enc.encoded_bytes += written;
+    return written;
+}
+
+// ---------------------------------------------------------------------------
+// Decoder
+// ---------------------------------------------------------------------------
+
+static bool flushOutput(LzrDecoder& dec) {
+    if (dec.out_len > 0 && !dec.sink(dec.out, dec.out_len, dec.sink_ctx)) {
+        dec.error = true;
+    }
+    dec.out_len = 0;
+    return !dec.error;
+}
+
+static bool emitByte(LzrDecoder& dec, uint8_t b) {
+    dec.window[dec.total % LZR_WINDOW_SIZE] = b;
+    dec.total++;
+    dec.out[dec.out_len++] = b;
+    return dec.out_len < sizeof(dec.out) || flushOutput(dec);
+}
+
+// Accumulate one varint byte; true once the value is complete
+static bool takeVarint(LzrDecoder& dec, uint8_t c) {
+    if (dec.shift > 28) {
+        dec.error = true;
+        return false;
+    }
+    dec.value |= (uint32_t)(c & 0x7F) << dec.shift;
+    dec.shift += 7;
+    return (c & 0x80) == 0;
+}
+
+void lzrDecoderInit(LzrDecoder& dec, LzrSink sink, void* ctx) {
+    memset(&dec, 0, sizeof(dec));
+    dec.sink = sink;
+    dec.sink_ctx = ctx;
+    dec.state = DEC_TAG;
+}
+
+bool lzrDecodeWrite(LzrDecoder& dec, const uint8_t* data, size_t len) {
+    for (size_t i = 0; i < len && !dec.error; i++) {
+        uint8_t c = data[i];
+        
+        switch (dec.state) {
+            case DEC_TAG:
+                if (c > LZR_TOKEN_MATCH) {
+                    dec.error = true;
+                    break;
+                }
+                dec.tag = c;
+                dec.value = 0;
+                dec.shift = 0;
+                dec.state = DEC_LEN;
+                break;
+                
+            case DEC_LEN:
+                if (!takeVarint(dec, c)) break;
+                dec.len = dec.value;
+                dec.value = 0;
+                dec.shift = 0;
+                if (dec.len == 0) {
+                    dec.error = true;
+                } else if (dec.tag == LZR_TOKEN_LITERAL) {
+                    dec.state = DEC_LITERAL;
+                } else if (dec.tag == LZR_TOKEN_RUN) {
+                    dec.state = DEC_RUN_VALUE;
+                } else {
+                    dec.state = DEC_DIST;
+                }
+                break;
+                
+            case DEC_DIST:
+                if (!takeVarint(dec, c)) break;
+                if (dec.value == 0 || dec.value > LZR_WINDOW_SIZE || dec.value > dec.total) {
+                    dec.error = true;
+                    break;
+                }
+                // Byte by byte so overlapping copies repeat correctly
+                for (uint32_t n = 0; n < dec.len && !dec.error; n++) {
+                    emitByte(dec, dec.window[(dec.total - dec.value) % LZR_WINDOW_SIZE]);
+                }
+                dec.state = DEC_TAG;
+                break;
+                
+            case DEC_LITERAL:
+                emitByte(dec, c);
+                if (--dec.len == 0) {
+                    dec.state = DEC_TAG;
+                }
+                break;
+                
+            case DEC_RUN_VALUE:
+                for (uint32_t n = 0; n < dec.len && !dec.error; n++) {
+                    emitByte(dec, c);
+                }
+                dec.state = DEC_TAG;
+                break;
+        }
+    }
+    
+    return !dec.error;
+}
+
+bool lzrDecodeFinish(LzrDecoder& dec) {
+    return flushOutput(dec) && dec.state == DEC_TAG;
+}
@@ -0,0 +1,400 @@
+#include "backup_protocol.h"
+#include "backup_codec.h"
+#include "fram_programmer.h"
+#include "crc32.h"
+#include "hex_codec.h"
+#include "sha256.h"
+#include "serial_line.h"
+#include "console_out.h"
+#include <Wire.h>
+#include <Adafruit_FRAM_I2C.h>
+
+// Sequential FRAM reader shared by all payload encodings.
+// Hashes the raw image as it is read so the end frame can carry its digest.
+struct ImageReader {
+    uint16_t addr;
+    size_t remaining;
+    size_t bytes_read;
+    SHA256 sha;
+};
+
+// One frame kept in the window until the host acknowledges it
+struct FrameSlot {
+    uint8_t data[BACKUP_FRAME_PAYLOAD + BACKUP_FRAME_OVERHEAD];
+    size_t len;
+};
+
+// Partially received ack message
+struct AckParser {
+    uint8_t buf[3];
+    uint8_t pos;
+};
+
+static void putLE16(uint8_t* p, uint16_t v) {
+    p[0] = v & 0xFF;
+    p[1] = v >> 8;
+}
+
+static void putLE32(uint8_t* p, uint32_t v) {
+    for (int i = 0; i < 4; i++) {
+        p[i] = (v >> (i * 8)) & 0xFF;
+    }
+}
+
+static size_t readImage(ImageReader& reader, uint8_t* out, size_t cap) {
+    size_t len = min(cap, reader.remaining);
+    
+    for (size_t offset = 0; offset < len; offset += FRAM_BULK_CHUNK_SIZE) {
+        size_t chunk = min((size_t)FRAM_BULK_CHUNK_SIZE, len - offset);
+        fram.read(reader.addr + offset, out + offset, chunk);
+    }
+    
+    reader.sha.update(out, len);
+    reader.addr += len;
+    reader.remaining -= len;
+    reader.bytes_read += len;
+    return len;
+}
+
+// LzrSource adapter so the encoder pulls straight from FRAM
+static size_t imageSource(uint8_t* buf, size_t len, void* ctx) {
+    return readImage(*(ImageReader*)ctx, buf, min(len, (size_t)FRAM_BULK_CHUNK_SIZE));
+}
+
+static void printCompressionRatio(uint32_t raw_bytes, uint32_t encoded_bytes) {
+    Console.print("Compressed ");
+    Console.print(raw_bytes);
+    Console.print(" -> ");
+    Console.print(encoded_bytes);
+    Console.print(" bytes (ratio ");
+    Console.print(encoded_bytes > 0 ? (double)raw_bytes / encoded_bytes : 0.0, 1);
+    Console.println(":1)");
+}
+
+// Wrap payload (already placed at slot.data + 7) into a complete frame
+static void sealFrame(FrameSlot& slot, uint8_t type, uint16_t seq, size_t payload_len) {
+    uint8_t* p = slot.data;
+    p[0] = BACKUP_FRAME_SYNC0;
+    p[1] = BACKUP_FRAME_SYNC1;
+    p[2] = type;
+    putLE16(&p[3], seq);
+    putLE16(&p[5], (uint16_t)payload_len);
+    
+    uint32_t crc = crc32(&p[2], 5 + payload_len);
+    putLE32(&p[7 + payload_len], crc);
+    slot.len = 7 + payload_len + 4;
+}
+
+static uint8_t* slotPayload(FrameSlot& slot) {
+    return &slot.data[7];
+}
+
+// Poll for one complete ack message; returns its type or 0 if none yet
+static uint8_t pollAck(AckParser& parser, uint16_t* seq) {
+    int c;
+    while ((c = serialReadByte()) >= 0) {
+        
+        // Resynchronise on a message type byte
+        if (parser.pos == 0 && c != 'A' && c != 'N' && c != 'X') {
+            continue;
+        }
+        
+        parser.buf[parser.pos++] = c;
+        if (parser.pos == 3) {
+            parser.pos = 0;
+            *seq = parser.buf[1] | (parser.buf[2] << 8);
+            return parser.buf[0];
+        }
+    }
+    return 0;
+}
+
+bool sendFramedBackup(uint16_t start, size_t size, uint8_t encoding) {
+    if (!detectFRAM()) {
+        Console.println("ERROR: FRAM not detected");
+        return false;
+    }
+    
+    if ((size_t)start + size > FRAM_SIZE) {
+        Console.println("ERROR: Backup range outside FRAM");
+        return false;
+    }
+    
+    if (encoding != BACKUP_ENCODING_RAW && encoding != BACKUP_ENCODING_LZR) {
+        Console.println("ERROR: Unsupported backup encoding");
+        return false;
+    }
+    
+    static FrameSlot window[BACKUP_WINDOW];
+    static ImageReader reader;
+    static LzrEncoder encoder;
+    reader.addr = start;
+    reader.remaining = size;
+    reader.bytes_read = 0;
+    reader.sha.init();
+    lzrEncoderInit(encoder, imageSource, &reader);
+    
+    AckParser parser = { {0}, 0 };
+    uint16_t base = 0;              // Oldest unacknowledged frame
+    uint16_t next = 0;              // Next frame to build
+    uint16_t end_seq = 0xFFFF;      // Sequence number of the end frame once built
+    uint32_t payload_bytes = 0;
+    uint32_t retransmits = 0;
+    uint8_t retries = 0;
+    bool aborted = false;
+    
+    Console.println("BINARY_BACKUP_START");
+    Console.flush();
+    Serial.flush();
+    
+    Wire.setClock(FRAM_I2C_BULK_CLOCK);
+    unsigned long start_us = micros();
+    unsigned long last_progress = millis();
+    
+    bool done = false;
+    while (!done) {
+        // Fill the window with new frames
+        while (next - base < BACKUP_WINDOW && end_seq == 0xFFFF) {
+            FrameSlot& slot = window[next % BACKUP_WINDOW];
+            uint8_t* payload = slotPayload(slot);
+            
+            if (next == 0) {
+                memcpy(payload, BACKUP_MAGIC, 4);
+                payload[4] = BACKUP_PROTOCOL_VERSION;
+                payload[5] = encoding;
+                putLE16(&payload[6], start);
+                putLE32(&payload[8], size);
+                putLE16(&payload[12], BACKUP_FRAME_PAYLOAD);
+                payload[14] = BACKUP_WINDOW;
+                sealFrame(slot, BACKUP_FRAME_HEADER, next, 15);
+            } else {
+                size_t len = (encoding == BACKUP_ENCODING_LZR)
+                                 ? lzrEncodeRead(encoder, payload, BACKUP_FRAME_PAYLOAD)
+                                 : readImage(reader, payload, BACKUP_FRAME_PAYLOAD);
+                
+                if (len > 0) {
+                    payload_bytes += len;
+                    sealFrame(slot, BACKUP_FRAME_DATA, next, len);
+                } else {
+                    putLE32(&payload[0], payload_bytes);
+                    putLE32(&payload[4], reader.bytes_read);
+                    reader.sha.final(&payload[8]);
+                    sealFrame(slot, BACKUP_FRAME_END, next, 8 + SHA256_HASH_SIZE);
+                    end_seq = next;
+                }
+            }
+            
+            Console.write(slot.data, slot.len);
+            next++;
+        }
+        
+        // Wait for the host to move the window
+        uint16_t seq = 0;
+        uint8_t ack = pollAck(parser, &seq);
+        
+        if (ack == 'A') {
+            if ((uint16_t)(seq - base) < (uint16_t)(next - base)) {
+                base = seq + 1;
+                retries = 0;
+                last_progress = millis();
+                done = (end_seq != 0xFFFF && base == end_seq + 1);
+            }
+        } else if (ack == 'N' || (ack == 0 && millis() - last_progress > BACKUP_ACK_TIMEOUT_MS)) {
+            if (ack == 0 && ++retries > BACKUP_MAX_RETRIES) {
+                aborted = true;
+                break;
+            }
+            
+            // Go back: resend from the requested frame (or the oldest on timeout)
+            uint16_t from = base;
+            if (ack == 'N' && (uint16_t)(seq - base) < (uint16_t)(next - base)) {
+                from = seq;
+            }
+            for (uint16_t s = from; s != next; s++) {
+                FrameSlot& slot = window[s % BACKUP_WINDOW];
+                Console.write(slot.data, slot.len);
+                retransmits++;
+            }
+            last_progress = millis();
+        } else if (ack == 'X') {
+            aborted = true;
+            break;
+        }
+    }
+    
+    unsigned long elapsed_us = micros() - start_us;
+    Wire.setClock(FRAM_I2C_CLOCK);
+    
+    Console.println();
+    if (aborted) {
+        Console.println("ERROR: Binary backup aborted (host abort or ack timeout)");
+        return false;
+    }
+    
+    Console.print("Binary backup: ");
+    Console.print(reader.bytes_read);
+    Console.print(" bytes in ");
+    Console.print(elapsed_us / 1000);
+    Console.print(" ms (");
+    Console.print(elapsed_us > 0 ? (unsigned long)((uint64_t)reader.bytes_read * 1000000ULL / elapsed_us) : 0);
+    Console.print(" B/s), ");
+    Console.print(next);
+    Console.print(" frames, ");
+    Console.print(retransmits);
+    Console.println(" retransmitted");
+    
+    if (encoding == BACKUP_ENCODING_LZR) {
+        printCompressionRatio(reader.bytes_read, payload_bytes);
+    }
+    return true;
+}
+
+bool sendCompressedHexBackup(uint16_t start, size_t size) {
+    if (!detectFRAM()) {
+        Console.println("ERROR: FRAM not detected");
+        return false;
+    }
+    
+    if ((size_t)start + size > FRAM_SIZE) {
+        Console.println("ERROR: Backup range outside FRAM");
+        return false;
+    }
+    
+    static ImageReader reader;
+    static LzrEncoder encoder;
+    reader.addr = start;
+    reader.remaining = size;
+    reader.bytes_read = 0;
+    reader.sha.init();
+    lzrEncoderInit(encoder, imageSource, &reader);
+    
+    Console.println("BACKUP_START");
+    Console.print("SIZE:");
+    Console.println(size);
+    Console.println("ENCODING:LZR");
+    
+    uint8_t chunk[64];
+    size_t len;
+    while ((len = lzrEncodeRead(encoder, chunk, sizeof(chunk))) > 0) {
+        printHexLine("ZDATA:", chunk, len);
+    }
+    
+    Console.println("BACKUP_END");
+    printCompressionRatio(encoder.raw_bytes, encoder.encoded_bytes);
+    return true;
+}
+
+
+bool initManifest(BlockManifest& manifest, size_t block_size) {
+    // Power of two so blocks tile the FRAM exactly
+    if (block_size < BACKUP_INC_MIN_BLOCK || block_size > BACKUP_INC_MAX_BLOCK ||
+        (block_size & (block_size - 1)) != 0) {
+        return false;
+    }
+    
+    manifest.block_size = block_size;
+    manifest.block_count = FRAM_SIZE / block_size;
+    memset(manifest.present, 0, sizeof(manifest.present));
+    return true;
+}
+
+bool parseManifestLine(const String& line, BlockManifest& manifest) {
+    if (line.startsWith("BLOCK_SIZE:")) {
+        // A manifest taken with another block size cannot be compared
+        return (size_t)line.substring(11).toInt() == manifest.block_size;
+    }
+    
+    if (!line.startsWith("DIGEST:")) {
+        return true;    // Other lines of a pasted backup are ignored
+    }
+    
+    int sep = line.indexOf(':', 7);
+    if (sep < 0) {
+        return false;
+    }
+    
+    // A damaged index must not land on block 0's digest
+    uint32_t index;
+    if (!hexParseNumber(line.c_str() + 7, sep - 7, &index)) {
+        return false;
+    }
+    String hex = line.substring(sep + 1);
+    
+    size_t len, error_pos;
+    if (index >= manifest.block_count || hex.length() != BACKUP_INC_DIGEST_SIZE * 2 ||
+        !hexDecode(hex.c_str(), hex.length(), manifest.digests[index], BACKUP_INC_DIGEST_SIZE,
+                   &len, &error_pos)) {
+        return false;
+    }
+    
+    manifest.present[index] = true;
+    return true;
+}
+
+bool sendIncrementalBackup(const BlockManifest& previous) {
+    if (!detectFRAM()) {
+        Console.println("ERROR: FRAM not detected");
+        return false;
+    }
+    
+    static uint8_t block[BACKUP_INC_MAX_BLOCK];
+    const size_t block_size = previous.block_size;
+    size_t changed = 0;
+    
+    Console.println("BACKUP_START");
+    Console.print("SIZE:");
+    Console.println(FRAM_SIZE);
+    Console.println("MODE:INCREMENTAL");
+    Console.print("BLOCK_SIZE:");
+    Console.println(block_size);
+    
+    Wire.setClock(FRAM_I2C_BULK_CLOCK);
+    unsigned long start_us = micros();
+    
+    for (size_t index = 0; index < previous.block_count; index++) {
+        uint16_t addr = index * block_size;
+        
+        // Hash the block as it is read
+        SHA256 sha;
+        for (size_t offset = 0; offset < block_size; offset += FRAM_BULK_CHUNK_SIZE) {
+            size_t chunk = min((size_t)FRAM_BULK_CHUNK_SIZE, block_size - offset);
+            fram.read(addr + offset, &block[offset], chunk);
+            sha.update(&block[offset], chunk);
+        }
+        uint8_t digest[SHA256_HASH_SIZE];
+        sha.final(digest);
+        
+        Console.print("DIGEST:");
+        Console.print(index, HEX);
+        Console.print(":");
+        printHex(digest, BACKUP_INC_DIGEST_SIZE);
+        Console.println();
+        
+        if (previous.present[index] &&
+            memcmp(previous.digests[index], digest, BACKUP_INC_DIGEST_SIZE) == 0) {
+            continue;
+        }
+        
+        for (size_t offset = 0; offset < block_size; offset += 64) {
+            printBackupChunk(addr + offset, &block[offset], 64);
+        }
+        changed++;
+    }
+    
+    unsigned long elapsed_us = micros() - start_us;
+    Wire.setClock(FRAM_I2C_CLOCK);
+    
+    Console.println("BACKUP_END");
+    Console.print("Incremental: ");
+    Console.print(changed);
+    Console.print("/");
+    Console.print(previous.block_count);
+    Console.print(" blocks changed, ");
+    Console.print(changed * block_size);
+    Console.print(" of ");
+    Console.print(FRAM_SIZE);
+    Console.print(" bytes sent in ");
+    Console.print(elapsed_us / 1000);
+    Console.println(" ms");
+    return true;
+}
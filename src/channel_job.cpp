@@ -0,0 +1,102 @@
+#include "channel_job.h"
+#include "encryption.h"
+#include "crc32.h"
+#include "core1_worker.h"
+
+// Same steps as readCredentialsSection(): header first, then only the bytes
+// the record occupies
+static bool channelReadRecord(FramBus& bus, CredentialRecord& rec) {
+    CredentialRecordHeader header;
+    if (!bus.read(FRAM_CREDENTIALS_ADDR, (uint8_t*)&header, sizeof(header))) {
+        return false;
+    }
+    memcpy(rec.raw, &header, sizeof(header));
+    
+    size_t size = credentialRecordReadSize(header);
+    if (size > sizeof(header) &&
+        !bus.read(FRAM_CREDENTIALS_ADDR + sizeof(header), &rec.raw[sizeof(header)],
+                  size - sizeof(header))) {
+        return false;
+    }
+    
+    rec.size = size;
+    return parseCredentialRecord(rec);
+}
+
+static bool channelVerify(FramBus& bus, CredentialRecord& rec) {
+    uint32_t stored, computed;
+    return channelReadRecord(bus, rec) && checkCredentialRecord(rec, &stored, &computed);
+}
+
+static bool channelProgram(FramBus& bus, const DeviceCredentials& record, CredentialRecord& rec) {
+    if (!encryptCredentials(record, rec)) {
+        return false;
+    }
+    
+    if (!bus.write(FRAM_CREDENTIALS_ADDR, rec.raw, rec.size)) {
+        return false;
+    }
+    
+    // Read back chunk by chunk; the record stays in rec for the comparison
+    uint8_t chunk[FRAM_BULK_CHUNK_SIZE];
+    for (size_t offset = 0; offset < rec.size; offset += sizeof(chunk)) {
+        size_t len = min(sizeof(chunk), (size_t)rec.size - offset);
+        if (!bus.read(FRAM_CREDENTIALS_ADDR + offset, chunk, len) ||
+            memcmp(chunk, &rec.raw[offset], len) != 0) {
+            return false;
+        }
+    }
+    
+    return channelVerify(bus, rec);
+}
+
+static bool channelBackup(FramBus& bus, uint8_t* image, uint32_t* crc) {
+    for (size_t addr = 0; addr < FRAM_SIZE; addr += FRAM_BULK_CHUNK_SIZE) {
+        if (!bus.read(addr, &image[addr], FRAM_BULK_CHUNK_SIZE)) {
+            return false;
+        }
+    }
+    *crc = crc32(image, FRAM_SIZE);
+    return true;
+}
+
+void runChannelJob(void* arg) {
+    ChannelJob* job = (ChannelJob*)arg;
+    ChannelResult* result = job->result;
+    
+    unsigned long start = micros();
+    result->ok = false;
+    result->crc = 0;
+    
+    // Bind the chip here, on the core that owns this channel's bus
+    result->present = job->bus->begin();
+    
+    if (result->present) {
+        switch (job->op) {
+            case DUAL_PROGRAM:
+                result->ok = job->record != nullptr &&
+                             channelProgram(*job->bus, *job->record, *job->staging);
+                break;
+            case DUAL_BACKUP:
+                result->ok = channelBackup(*job->bus, job->image, &result->crc);
+                break;
+            case DUAL_VERIFY:
+                result->ok = channelVerify(*job->bus, *job->staging);
+                break;
+        }
+    }
+    
+    result->elapsed_us = micros() - start;
+}
+
+unsigned long runChannelPair(ChannelJob* jobs) {
+    unsigned long start = micros();
+    
+    // Core 1 takes channel 1 while this core works on channel 0
+    core1Wait();
+    core1Submit(runChannelJob, &jobs[1]);
+    runChannelJob(&jobs[0]);
+    core1Wait();
+    
+    return micros() - start;
+}
@@ -0,0 +1,97 @@
+#include "chunk_ring.h"
+#include "console_out.h"
+
+void ringInit(ChunkRing& ring) {
+    ring.head.store(0, std::memory_order_relaxed);
+    ring.tail.store(0, std::memory_order_relaxed);
+    ring.closed.store(false, std::memory_order_relaxed);
+    memset(&ring.stats, 0, sizeof(ring.stats));
+}
+
+RingSlot* ringBeginWrite(ChunkRing& ring) {
+    uint32_t head = ring.head.load(std::memory_order_relaxed);
+    
+    // Acquire pairs with the consumer's release so the slot is no longer being read
+    if (head - ring.tail.load(std::memory_order_acquire) == RING_SLOTS) {
+        unsigned long wait_start = micros();
+        while (head - ring.tail.load(std::memory_order_acquire) == RING_SLOTS) {
+            tight_loop_contents();
+        }
+        ring.stats.producer_wait_us += micros() - wait_start;
+    }
+    
+    return &ring.slots[head % RING_SLOTS];
+}
+
+void ringCommitWrite(ChunkRing& ring) {
+    ring.head.store(ring.head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+void ringClose(ChunkRing& ring) {
+    ring.closed.store(true, std::memory_order_release);
+}
+
+RingSlot* ringBeginRead(ChunkRing& ring) {
+    uint32_t tail = ring.tail.load(std::memory_order_relaxed);
+    uint32_t head = ring.head.load(std::memory_order_acquire);
+    
+    if (head == tail) {
+        unsigned long wait_start = micros();
+        while (true) {
+            // Check closed before head: a close is only published after the last slot
+            bool closed = ring.closed.load(std::memory_order_acquire);
+            head = ring.head.load(std::memory_order_acquire);
+            if (head != tail) break;
+            if (closed) {
+                ring.stats.consumer_wait_us += micros() - wait_start;
+                return nullptr;
+            }
+            tight_loop_contents();
+        }
+        ring.stats.consumer_wait_us += micros() - wait_start;
+    }
+    
+    uint8_t occupancy = head - tail;
+    ring.stats.chunks++;
+    ring.stats.occupancy_sum += occupancy;
+    if (occupancy > ring.stats.occupancy_max) {
+        ring.stats.occupancy_max = occupancy;
+    }
+    
+    return &ring.slots[tail % RING_SLOTS];
+}
+
+void ringCommitRead(ChunkRing& ring) {
+    ring.tail.store(ring.tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+void printRingStats(const ChunkRing& ring, const char* producer, const char* consumer) {
+    const RingStats& stats = ring.stats;
+    
+    Console.print("Ring: ");
+    Console.print(stats.chunks);
+    Console.print(" chunks, occupancy avg ");
+    if (stats.chunks > 0) {
+        Console.print((float)stats.occupancy_sum / stats.chunks, 1);
+    } else {
+        Console.print("0");
+    }
+    Console.print(" max ");
+    Console.print(stats.occupancy_max);
+    Console.print("/");
+    Console.println(RING_SLOTS);
+    
+    Console.print("  ");
+    Console.print(producer);
+    Console.print(" waited ");
+    Console.print(stats.producer_wait_us / 1000);
+    Console.print(" ms (ring full), ");
+    Console.print(consumer);
+    Console.print(" waited ");
+    Console.print(stats.consumer_wait_us / 1000);
+    Console.println(" ms (ring empty)");
+    
+    // A full ring means the consumer cannot keep up, an empty one the producer
+    Console.print("  Bottleneck: ");
+    Console.println(stats.producer_wait_us > stats.consumer_wait_us ? consumer : producer);
+}
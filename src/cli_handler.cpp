@@ -1,131 +1,115 @@
 #include "cli_handler.h"
 #include "fram_programmer.h"
 #include "encryption.h"
-#include <ArduinoJson.h>
+#include "gang_programmer.h"
+#include "dual_channel.h"
+#include "production_line.h"
+#include "backup_protocol.h"
+#include "merkle_tree.h"
+#include "restore_stream.h"
+#include "hex_codec.h"
+#include "fram_scrub.h"
+#include "backup_codec.h"
+#include "profile_store.h"
+#include "partition_table.h"
+#include "reader_check.h"
+#include "serial_line.h"
+#include "command_registry.h"
+#include "json_ingest.h"
+#include "command_arena.h"
+#include "logging.h"
+#include "console_out.h"
 #include <Wire.h>
 #include <Adafruit_FRAM_I2C.h>
 
 // CLI state
-static String inputBuffer = "";
 static bool waitingForInput = false;
 
 void initCLI() {
-    Serial.println("CLI initialized");
-    inputBuffer.reserve(1024); // Reserve space for input buffer
+    Console.println("CLI initialized");
 }
 
 void handleCLI() {
-    if (Serial.available()) {
-        char c = Serial.read();
-        
-        // Debug: pokaż otrzymany znak
-        Serial.print("Got char: '");
-        Serial.print(c);
-        Serial.print("' (");
-        Serial.print((int)c);
-        Serial.println(")");
-        
-        if (c == '\n' || c == '\r') {
-            if (inputBuffer.length() > 0) {
-                // Process command
-                inputBuffer.trim();
-                
-                Serial.print("Processing command: '");
-                Serial.print(inputBuffer);
-                Serial.println("'");
-                
-                CLICommand cmd = parseCommand(inputBuffer);
-                executeCommand(cmd, inputBuffer);
-                
-                inputBuffer = "";
-                if (!waitingForInput) {
-                    printPrompt();
-                }
-            }
-        } else if (c == '\b' || c == 127) { // Backspace
-            if (inputBuffer.length() > 0) {
-                inputBuffer.remove(inputBuffer.length() - 1);
-                Serial.print("\b \b");
-            }
-        } else if (c >= 32 && c < 127) { // Printable characters
-            inputBuffer += c;
-            Serial.print(c);
-        }
-    }
-}
-
-CLICommand parseCommand(const String& input) {
-    String cmd = input;
-    int spaceIndex = cmd.indexOf(' ');
-    if (spaceIndex > 0) {
-        cmd = cmd.substring(0, spaceIndex);
-    }
-    cmd.toLowerCase();
-    
-    if (cmd == "help" || cmd == "h") return CMD_HELP;
-    if (cmd == "detect" || cmd == "d") return CMD_DETECT;
-    if (cmd == "info" || cmd == "i") return CMD_INFO;
-    if (cmd == "backup" || cmd == "b") return CMD_BACKUP;
-    if (cmd == "restore" || cmd == "r") return CMD_RESTORE;
-    if (cmd == "program" || cmd == "p") return CMD_PROGRAM;
-    if (cmd == "verify" || cmd == "v") return CMD_VERIFY;
-    if (cmd == "config" || cmd == "c") return CMD_CONFIG;
-    if (cmd == "test" || cmd == "t") return CMD_TEST;
-    
-    return CMD_UNKNOWN;
-}
-
-void executeCommand(CLICommand cmd, const String& args) {
-    Serial.println(); // New line after command
-    
-    switch (cmd) {
-        case CMD_HELP:      cmdHelp(); break;
-        case CMD_DETECT:    cmdDetect(); break;
-        case CMD_INFO:      cmdInfo(); break;
-        case CMD_BACKUP:    cmdBackup(); break;
-        case CMD_RESTORE:   cmdRestore(); break;
-        case CMD_PROGRAM:   cmdProgram(); break;
-        case CMD_VERIFY:    cmdVerify(); break;
-        case CMD_CONFIG:    cmdConfig(); break;
-        case CMD_TEST:      cmdTest(); break;
-        case CMD_UNKNOWN:
-        default:
-            printError("Unknown command. Type 'help' for available commands.");
-            break;
+    LineResult result = pollSerialLine(true);
+    
+    if (result == LINE_TOO_LONG) {
+        printError("Line too long - ignored");
+        printPrompt();
+        return;
+    }
+    
+    if (result != LINE_READY) {
+        return;
+    }
+    
+    // Copy out: commands that prompt reuse the line buffer
+    String input = serialLineText();
+    input.trim();
+    if (input.length() == 0) {
+        return;
+    }
+    
+    Console.print("Processing command: '");
+    printCommandEcho(input);
+    Console.println("'");
+    
+    runCommandLine(input);
+    
+    if (!waitingForInput) {
+        printPrompt();
     }
 }
 
-void cmdHelp() {
-    Serial.println("FRAM Programmer Commands:");
-    Serial.println("========================");
-    Serial.println("  help (h)     - Show this help");
-    Serial.println("  detect (d)   - Detect FRAM device");
-    Serial.println("  info (i)     - Show FRAM information");
-    Serial.println("  backup (b)   - Backup entire FRAM content");
-    Serial.println("  restore (r)  - Restore FRAM from backup");
-    Serial.println("  program (p)  - Program credentials to FRAM");
-    Serial.println("  verify (v)   - Verify stored credentials");
-    Serial.println("  config (c)   - Configure via JSON input");
-    Serial.println("  test (t)     - Test FRAM read/write");
-    Serial.println();
-    Serial.println("Examples:");
-    Serial.println("  program      - Interactive credential input");
-    Serial.println("  config       - JSON configuration mode");
-    Serial.println("  backup       - Creates hex dump for external storage");
+void cmdHelp(const String& args) {
+    Console.println("FRAM Programmer Commands:");
+    Console.println("========================");
+    printCommandList();
+    Console.println("  (commands that ask for YES also take --yes)");
+    Console.println();
+    Console.println("Examples:");
+    Console.println("  program      - Interactive credential input");
+    Console.println("  program --name DOLEWKA_001 --ssid Net --password \"my pass\" --admin a --token t --yes");
+    Console.println("  config       - JSON configuration mode");
+    Console.println("  backup       - Creates hex dump for external storage");
+    Console.println("  backup lzr   - Compressed hex dump (run-length + LZ), reports ratio");
+    Console.println("  backup inc   - Only blocks changed since a previous manifest");
+    Console.println("  backup bin   - Framed binary stream for host tools (windowed acks)");
+    Console.println("  fill 0x7000 4096 DEADBEEF");
+    Console.println("  wipe credentials");
+    Console.println("  merkle creds 64  - Root over the credentials section, 64-byte leaves");
 }
 
-void cmdDetect() {
-    Serial.print("Scanning for FRAM at I2C address 0x");
-    Serial.print(FRAM_I2C_ADDR, HEX);
-    Serial.print("... ");
+void cmdDetect(const String& args) {
+    Console.print("Scanning for FRAM at I2C address 0x");
+    Console.print(FRAM_I2C_ADDR, HEX);
+    Console.print("... ");
     
     if (detectFRAM()) {
         printSuccess("FRAM detected successfully");
+        
+        CredentialStatus status;
+        if (readCredentialStatus(defaultFRAM, status)) {
+            Console.print("Credentials: ");
+            if (status.version != 0) {
+                Console.print("v");
+                Console.print(status.version);
+                Console.print(" '");
+                Console.print(status.device_name);
+                Console.print("', ");
+                Console.print(status.size);
+                Console.print(" bytes");
+            } else {
+                Console.print("none");
+            }
+            Console.print(" (status read ");
+            Console.print(status.bus_bytes);
+            Console.println(" bytes)");
+        }
     } else {
         printError("FRAM not found");
         
         // I2C scan for any devices  
-        Serial.println("Scanning I2C bus for any devices:");
+        Console.println("Scanning I2C bus for any devices:");
         bool found = false;
         
         for (uint8_t addr = 0x08; addr <= 0x77; addr++) {
@@ -133,62 +117,186 @@ void cmdDetect() {
             uint8_t error = Wire.endTransmission();
             
             if (error == 0) {
-                Serial.print("  Device found at address 0x");
-                if (addr < 16) Serial.print("0");
-                Serial.println(addr, HEX);
+                Console.print("  Device found at address 0x");
+                printHex(&addr, 1);
+                Console.println();
                 found = true;
             }
         }
         
         if (!found) {
-            Serial.println("  No I2C devices found!");
+            Console.println("  No I2C devices found!");
         }
     }
 }
 
-void cmdInfo() {
+void cmdInfo(const String& args) {
     printFRAMInfo();
 }
 
-void cmdBackup() {
+void cmdBackup(const String& args) {
+    String mode = getArgument(args, 1);
+    mode.toLowerCase();
+    
+    String encoding = getArgument(args, 2);
+    encoding.toLowerCase();
+    
+    if (mode == "bin") {
+        if (encoding.length() > 0 && encoding != "lzr") {
+            printError("Usage: backup bin [lzr]");
+            return;
+        }
+        
+        // Host tool takes over the port until the end frame is acknowledged
+        if (sendFramedBackup(0, FRAM_SIZE, encoding == "lzr" ? BACKUP_ENCODING_LZR
+                                                             : BACKUP_ENCODING_RAW)) {
+            printSuccess("Binary backup complete");
+        } else {
+            printError("Binary backup failed");
+        }
+        return;
+    }
+    
+    if (mode == "lzr") {
+        printInfo("Starting compressed FRAM backup (LZR, hex lines)");
+        if (sendCompressedHexBackup(0, FRAM_SIZE)) {
+            printInfo("Backup complete. Save the ZDATA lines above for restore.");
+        } else {
+            printError("Compressed backup failed");
+        }
+        return;
+    }
+    
+    if (mode == "inc") {
+        cmdIncrementalBackup(encoding);
+        return;
+    }
+    
+    if (mode.length() > 0 && mode != "hex") {
+        printError("Usage: backup [hex|lzr|inc [block]|bin [lzr]]");
+        return;
+    }
+    
     printInfo("Starting FRAM backup (output as hex dump)");
-    Serial.println("Copy the following output to save your backup:");
-    Serial.println();
+    Console.println("Copy the following output to save your backup:");
+    Console.println();
     
     backupFRAM();
     
     printInfo("Backup complete. Save the hex dump above for restore.");
 }
 
-void cmdRestore() {
-    printWarning("FRAM restore will overwrite ALL data!");
-    Serial.print("Type 'YES' to confirm: ");
+void cmdIncrementalBackup(const String& block_arg) {
+    static BlockManifest manifest;
     
-    waitingForInput = true;
-    String confirmation = readSerialLine();
-    waitingForInput = false;
+    unsigned long block_size = BACKUP_INC_DEFAULT_BLOCK;
+    if (block_arg.length() > 0 && !parseNumberArgument(block_arg, &block_size)) {
+        printError("Invalid block size");
+        return;
+    }
+    
+    if (!initManifest(manifest, block_size)) {
+        printError("Block size must be a power of two between 64 and 4096");
+        return;
+    }
+    
+    printInfo("Incremental backup - paste the previous manifest");
+    Console.println("(BLOCK_SIZE:/DIGEST: lines from the last backup, finish with 'END';");
+    Console.println(" 'END' alone gives a full backup with a fresh manifest)");
+    
+    size_t known = 0;
+    while (true) {
+        String line;
+        if (!readInputLine(line)) {
+            printError("Manifest not completed - backup cancelled");
+            return;
+        }
+        line.trim();
+        
+        if (line == "END" || line == "end") {
+            break;
+        }
+        
+        if (!parseManifestLine(line, manifest)) {
+            printError("Invalid manifest line (or block size mismatch) - backup cancelled");
+            return;
+        }
+        
+        if (line.startsWith("DIGEST:")) {
+            known++;
+        }
+    }
+    
+    Console.print(known);
+    Console.println(" digest(s) received");
+    
+    if (sendIncrementalBackup(manifest)) {
+        printInfo("Backup complete. Keep the DIGEST lines as the next manifest.");
+    } else {
+        printError("Incremental backup failed");
+    }
+}
+
+void cmdRestore(const String& args) {
+    printWarning("FRAM restore will overwrite ALL data!");
+    Console.print("Type 'YES' to confirm: ");
     
-    if (confirmation != "YES") {
+    if (!readConfirmation(false)) {
         printInfo("Restore cancelled");
         return;
     }
     
-    printInfo("Paste hex backup data below (end with 'END'):");
+    printInfo("Paste backup data below (ends at BACKUP_END or 'END'):");
+    
+    static RestoreStream stream;
+    if (!restoreBegin(stream)) {
+        printError("Restore cancelled");
+        return;
+    }
     
-    // Simple hex restore - for demo purposes
-    // Real implementation would parse the full backup format
-    printWarning("Hex restore not implemented - use backup format");
-    printInfo("Restore cancelled");
+    if (!receiveRestoreData(stream)) {
+        printError("Restore failed - FRAM may be partially written");
+    } else {
+        printSuccess("Restore complete");
+    }
+    printRestoreReport(stream);
+    reloadPartitions();     // The image may carry another superblock, or none
+}
+
+// Take a field from its --option when given, otherwise ask for it; either
+// way the text is copied once, straight into the fixed-capacity field
+template <size_t N>
+static void optionOrPrompt(const char* option, const char* prompt, FixedString<N>& field) {
+    const char* value = cliOption(option);
+    if (!value) {
+        Console.print(prompt);
+        value = readInputText();
+    }
+    field = value ? value : "";
 }
 
-void cmdProgram() {
+// programCredentials() with heap figures around it and its time at the current log level
+static bool programCredentialsTimed(const DeviceCredentials& creds) {
+    printHeapStats("Before: ");
+    unsigned long start = micros();
+    bool ok = programCredentials(creds);
+    unsigned long elapsed_us = micros() - start;
+    printHeapStats("After:  ");
+    Console.printf("Program time: %lu us (log level %s)\r\n", elapsed_us, logLevelName(logLevel()));
+    return ok;
+}
+
+void cmdProgram(const String& args) {
     printInfo("=== Interactive Credential Programming ===");
     
-    DeviceCredentials creds;
+    DeviceCredentials* slot = arenaNew<DeviceCredentials>();
+    if (!slot) {
+        return;
+    }
+    DeviceCredentials& creds = *slot;
     
     // Get device name
-    Serial.print("Device Name (1-31 chars, alphanumeric + _): ");
-    creds.device_name = readSerialLine();
+    optionOrPrompt("name", "Device Name (1-31 chars, alphanumeric + _): ", creds.device_name);
     
     if (!validateDeviceName(creds.device_name)) {
         printError("Invalid device name");
@@ -196,8 +304,7 @@ void cmdProgram() {
     }
     
     // Get WiFi SSID
-    Serial.print("WiFi SSID (1-63 chars): ");
-    creds.wifi_ssid = readSerialLine();
+    optionOrPrompt("ssid", "WiFi SSID (1-63 chars): ", creds.wifi_ssid);
     
     if (!validateWiFiSSID(creds.wifi_ssid)) {
         printError("Invalid WiFi SSID");
@@ -205,8 +312,7 @@ void cmdProgram() {
     }
     
     // Get WiFi password
-    Serial.print("WiFi Password (1-127 chars): ");
-    creds.wifi_password = readSerialLine();
+    optionOrPrompt("password", "WiFi Password (1-127 chars): ", creds.wifi_password);
     
     if (!validateWiFiPassword(creds.wifi_password)) {
         printError("Invalid WiFi password");
@@ -214,17 +320,15 @@ void cmdProgram() {
     }
     
     // Get admin password
-    Serial.print("Admin Password: ");
-    creds.admin_password = readSerialLine();
+    optionOrPrompt("admin", "Admin Password (1-127 chars): ", creds.admin_password);
     
-    if (creds.admin_password.length() == 0) {
-        printError("Admin password cannot be empty");
+    if (!validateAdminPassword(creds.admin_password)) {
+        printError("Invalid admin password");
         return;
     }
     
     // Get VPS token
-    Serial.print("VPS Token: ");
-    creds.vps_token = readSerialLine();
+    optionOrPrompt("token", "VPS Token: ", creds.vps_token);
     
     if (!validateVPSToken(creds.vps_token)) {
         printError("Invalid VPS token");
@@ -232,20 +336,18 @@ void cmdProgram() {
     }
     
     // Confirm programming
-    Serial.println();
-    Serial.println("=== CREDENTIALS SUMMARY ===");
-    Serial.print("Device Name: "); Serial.println(creds.device_name);
-    Serial.print("WiFi SSID: "); Serial.println(creds.wifi_ssid);
-    Serial.print("WiFi Password: "); Serial.println("******* (hidden)");
-    Serial.print("Admin Password: "); Serial.println("******* (will be hashed)");
-    Serial.print("VPS Token: "); Serial.println(creds.vps_token);
-    Serial.println();
-    
-    Serial.print("Program these credentials to FRAM? (YES/no): ");
-    String confirm = readSerialLine();
-    
-    if (confirm == "YES" || confirm == "yes" || confirm == "y" || confirm == "") {
-        if (programCredentials(creds)) {
+    Console.println();
+    Console.println("=== CREDENTIALS SUMMARY ===");
+    Console.print("Device Name: "); Console.println(creds.device_name.c_str());
+    Console.print("WiFi SSID: "); Console.println(creds.wifi_ssid.c_str());
+    Console.print("WiFi Password: "); Console.println("******* (hidden)");
+    Console.print("Admin Password: "); Console.println("******* (will be hashed)");
+    Console.print("VPS Token: "); Console.println(creds.vps_token.c_str());
+    Console.println();
+    
+    Console.print("Program these credentials to FRAM? (YES/no): ");
+    if (readConfirmation(true)) {
+        if (programCredentialsTimed(creds)) {
             printSuccess("Credentials programmed successfully!");
         } else {
             printError("Failed to program credentials");
@@ -255,65 +357,119 @@ void cmdProgram() {
     }
 }
 
-void cmdVerify() {
+// Decrypt one field into a local buffer and print it; no String copies of the plaintext
+static void printDecryptedField(const char* label, const CredentialRecord& rec,
+                                const uint8_t* key, CredentialFieldId id) {
+    uint8_t plaintext[CRED_CIPHER_SIZE(MAX_VPS_TOKEN_LEN)];
+    size_t plaintext_len = sizeof(plaintext);
+    
+    Console.print(label);
+    if (!decryptCredentialField(rec, key, id, plaintext, &plaintext_len)) {
+        Console.println("(decryption failed)");
+    } else if (id == CRED_FIELD_ADMIN_HASH && !rec.admin_hash_hex) {
+        // v2 raw digest, same lowercase text as v1
+        char hash_hex[SHA256_HASH_SIZE * 2 + 1];
+        size_t hex_len = hexEncode(plaintext, min(plaintext_len, (size_t)SHA256_HASH_SIZE), hash_hex);
+        for (size_t i = 0; i < hex_len; i++) {
+            hash_hex[i] = tolower(hash_hex[i]);
+        }
+        Console.println(hash_hex);
+    } else {
+        Console.write(plaintext, plaintext_len);
+        Console.println();
+    }
+    memset(plaintext, 0, sizeof(plaintext));
+}
+
+void cmdVerify(const String& args) {
+    String mode = getArgument(args, 1);
+    mode.toLowerCase();
+    bool full = mode == "full";
+    
     printInfo("Verifying FRAM credentials...");
+    reloadPartitions();
     
-    if (verifyCredentials()) {
+    // The key check runs on the record verifyCredentials read; no second read
+    static CredentialRecord rec;
+    if (verifyCredentials(rec)) {
         printSuccess("Credentials verification PASSED");
         
-        // Try to decrypt and show info
-        FRAMCredentials fram_creds;
-        if (readCredentialsSection(fram_creds)) {
-            DeviceCredentials creds;
-            if (decryptCredentials(fram_creds, creds)) {
-                Serial.println();
-                Serial.println("=== DECRYPTED CREDENTIALS ===");
-                Serial.print("Device Name: "); Serial.println(creds.device_name);
-                Serial.print("WiFi SSID: "); Serial.println(creds.wifi_ssid);
-                Serial.print("WiFi Password: "); Serial.println("******* (hidden)");
-                Serial.print("Admin Hash: "); Serial.println(creds.admin_password); // This is the hash
-                Serial.print("VPS Token: "); Serial.println(creds.vps_token);
-            } else {
-                printWarning("Could not decrypt credentials (incorrect key?)");
-            }
+        // Key check decrypts a single block; 'verify full' decrypts every field
+        uint32_t start = micros();
+        bool key_ok = fastVerifyCredentials(rec);
+        uint32_t elapsed = micros() - start;
+        
+        if (!key_ok) {
+            printWarning("Key check FAILED (incorrect key?)");
+        } else {
+            Console.print("Key check PASSED (1 block, ");
+            Console.print(elapsed);
+            Console.println(" us)");
+        }
+        
+        uint8_t key[AES_KEY_SIZE];
+        if (full && key_ok && credentialKey(rec, key)) {
+            Console.println();
+            Console.println("=== DECRYPTED CREDENTIALS ===");
+            Console.print("Device Name: "); Console.println(rec.device_name);
+            printDecryptedField("WiFi SSID: ", rec, key, CRED_FIELD_WIFI_SSID);
+            Console.print("WiFi Password: "); Console.println("******* (hidden)");
+            printDecryptedField("Admin Hash: ", rec, key, CRED_FIELD_ADMIN_HASH);
+            printDecryptedField("VPS Token: ", rec, key, CRED_FIELD_VPS_TOKEN);
+            memset(key, 0, sizeof(key));
         }
     } else {
         printError("Credentials verification FAILED");
     }
+    
+    if (partitionsLoaded()) {
+        Console.println();
+        Console.println("Sealed partitions:");
+        if (!verifyPartitions()) {
+            printWarning("Some partitions changed since they were sealed");
+        }
+    }
 }
 
-void cmdConfig() {
+void cmdConfig(const String& args) {
     printInfo("=== JSON Configuration Mode ===");
-    Serial.println("Paste JSON configuration below (single line):");
-    Serial.println("Format:");
-    Serial.println("{");
-    Serial.println("  \"device_name\": \"DOLEWKA_001\",");
-    Serial.println("  \"wifi_ssid\": \"MyNetwork\",");
-    Serial.println("  \"wifi_password\": \"MyPassword\",");
-    Serial.println("  \"admin_password\": \"admin123\",");
-    Serial.println("  \"vps_token\": \"sha256:abc123...\"");
-    Serial.println("}");
-    Serial.println();
-    Serial.print("JSON: ");
-    
-    String jsonInput = readSerialLine();
-    
-    DeviceCredentials creds;
-    if (parseJSONCredentials(jsonInput, creds)) {
-        Serial.println();
-        Serial.println("=== PARSED CREDENTIALS ===");
-        Serial.print("Device Name: "); Serial.println(creds.device_name);
-        Serial.print("WiFi SSID: "); Serial.println(creds.wifi_ssid);
-        Serial.print("WiFi Password: "); Serial.println("******* (hidden)");
-        Serial.print("Admin Password: "); Serial.println("******* (will be hashed)");
-        Serial.print("VPS Token: "); Serial.println(creds.vps_token);
-        Serial.println();
-        
-        Serial.print("Program these credentials? (YES/no): ");
-        String confirm = readSerialLine();
+    Console.println("Paste JSON configuration below (one line or pretty-printed):");
+    Console.println("Format:");
+    Console.println("{");
+    Console.println("  \"device_name\": \"DOLEWKA_001\",");
+    Console.println("  \"wifi_ssid\": \"MyNetwork\",");
+    Console.println("  \"wifi_password\": \"MyPassword\",");
+    Console.println("  \"admin_password\": \"admin123\",");
+    Console.println("  \"vps_token\": \"sha256:abc123...\"");
+    Console.println("}");
+    Console.println();
+    Console.print("JSON: ");
+    
+    DeviceCredentials* slot = arenaNew<DeviceCredentials>();
+    if (!slot) {
+        return;
+    }
+    DeviceCredentials& creds = *slot;
+    JsonIngestStats stats;
+    JsonIngestResult result = readJSONCredentials(creds, false, &stats);
+    if (result == JSON_INGEST_TIMEOUT) {
+        return;
+    }
+    
+    if (result == JSON_INGEST_OK) {
+        printJSONIngestStats(stats, 1);
+        Console.println();
+        Console.println("=== PARSED CREDENTIALS ===");
+        Console.print("Device Name: "); Console.println(creds.device_name.c_str());
+        Console.print("WiFi SSID: "); Console.println(creds.wifi_ssid.c_str());
+        Console.print("WiFi Password: "); Console.println("******* (hidden)");
+        Console.print("Admin Password: "); Console.println("******* (will be hashed)");
+        Console.print("VPS Token: "); Console.println(creds.vps_token.c_str());
+        Console.println();
         
-        if (confirm == "YES" || confirm == "yes" || confirm == "y" || confirm == "") {
-            if (programCredentials(creds)) {
+        Console.print("Program these credentials? (YES/no): ");
+        if (readConfirmation(true)) {
+            if (programCredentialsTimed(creds)) {
                 printSuccess("JSON credentials programmed successfully!");
             } else {
                 printError("Failed to program JSON credentials");
@@ -326,31 +482,94 @@ void cmdConfig() {
     }
 }
 
-void cmdTest() {
+// Synthetic FRAM-like image for the codec self-test: a header, some
+// pseudo-random "ciphertext", a repeated block and long constant runs
+struct CodecTestState {
+    size_t produced;
+    size_t checked;
+    bool match;
+};
+
+static uint8_t codecTestByte(size_t i) {
+    if (i < 24) return 0x00;
+    if (i < 536) return (uint8_t)((i * 2654435761u) >> 13);
+    if (i < 1048) return (uint8_t)(((i - 512) * 2654435761u) >> 13);    // Repeats the block above
+    if (i < 3000) return 0xFF;
+    return 0x00;
+}
+
+static size_t codecTestSource(uint8_t* buf, size_t len, void* ctx) {
+    CodecTestState* state = (CodecTestState*)ctx;
+    const size_t image_size = 4096;
+    size_t n = min(len, image_size - state->produced);
+    for (size_t i = 0; i < n; i++) {
+        buf[i] = codecTestByte(state->produced + i);
+    }
+    state->produced += n;
+    return n;
+}
+
+static bool codecTestSink(const uint8_t* data, size_t len, void* ctx) {
+    CodecTestState* state = (CodecTestState*)ctx;
+    for (size_t i = 0; i < len; i++) {
+        if (data[i] != codecTestByte(state->checked + i)) {
+            state->match = false;
+        }
+    }
+    state->checked += len;
+    return true;
+}
+
+bool testBackupCodec() {
+    static LzrEncoder encoder;
+    static LzrDecoder decoder;
+    CodecTestState source_state = { 0, 0, true };
+    CodecTestState sink_state = { 0, 0, true };
+    
+    lzrEncoderInit(encoder, codecTestSource, &source_state);
+    lzrDecoderInit(decoder, codecTestSink, &sink_state);
+    
+    // Odd piece size so tokens straddle chunk boundaries
+    uint8_t chunk[37];
+    size_t len;
+    bool decode_ok = true;
+    while ((len = lzrEncodeRead(encoder, chunk, sizeof(chunk))) > 0) {
+        decode_ok = decode_ok && lzrDecodeWrite(decoder, chunk, len);
+    }
+    decode_ok = decode_ok && lzrDecodeFinish(decoder);
+    
+    Console.print("  4096 bytes -> ");
+    Console.print(encoder.encoded_bytes);
+    Console.println(" bytes");
+    
+    return decode_ok && sink_state.match && sink_state.checked == source_state.produced;
+}
+
+void cmdTest(const String& args) {
     printInfo("=== FRAM Test Sequence ===");
     
     if (!detectFRAM()) {
         printError("FRAM not detected - cannot run tests");
         return;
     }
+    reloadPartitions();
     
     // Test 0: Structure alignment
-    Serial.println("Test 0: Structure Alignment Check");
+    Console.println("Test 0: Structure Alignment Check");
     size_t expected_size = 1024;
     size_t actual_size = sizeof(FRAMCredentials);
-    Serial.print("  Expected: "); Serial.print(expected_size); Serial.println(" bytes");
-    Serial.print("  Actual: "); Serial.print(actual_size); Serial.println(" bytes");
+    Console.print("  Expected: "); Console.print(expected_size); Console.println(" bytes");
+    Console.print("  Actual: "); Console.print(actual_size); Console.println(" bytes");
     
-    // Check field offsets
-    FRAMCredentials test_struct;
-    Serial.print("  magic offset: "); Serial.println((size_t)&test_struct.magic - (size_t)&test_struct);
-    Serial.print("  version offset: "); Serial.println((size_t)&test_struct.version - (size_t)&test_struct);
-    Serial.print("  device_name offset: "); Serial.println((size_t)&test_struct.device_name - (size_t)&test_struct);
-    Serial.print("  iv offset: "); Serial.println((size_t)&test_struct.iv - (size_t)&test_struct);
-    Serial.print("  checksum offset: "); Serial.println((size_t)&test_struct.checksum - (size_t)&test_struct);
+    // Check field offsets (also enforced at compile time in credential_record.h)
+    Console.print("  magic offset: "); Console.println(CredV1Magic::offset);
+    Console.print("  version offset: "); Console.println(CredV1Version::offset);
+    Console.print("  device_name offset: "); Console.println(CredV1DeviceName::offset);
+    Console.print("  iv offset: "); Console.println(CredV1Iv::offset);
+    Console.print("  checksum offset: "); Console.println(CredV1Checksum::offset);
     
     bool test0_pass = (actual_size == expected_size);
-    Serial.print("  Result: ");
+    Console.print("  Result: ");
     if (test0_pass) {
         printSuccess("PASS");
     } else {
@@ -358,35 +577,44 @@ void cmdTest() {
     }
     
     // Test 1: Basic read/write
-    Serial.println("Test 1: Basic Read/Write");
+    Console.println("Test 1: Basic Read/Write");
     uint8_t test_data[16] = {0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77,
                              0x88, 0x99, 0xAA, 0xBB, 0xCC, 0xDD, 0xEE, 0xFF};
     uint8_t read_data[16];
     
-    fram.write(0x7000, test_data, 16); // Safe test area
-    fram.read(0x7000, read_data, 16);
-    
-    bool test1_pass = (memcmp(test_data, read_data, 16) == 0);
-    Serial.print("  Result: ");
-    if (test1_pass) {
-        printSuccess("PASS");
+    // Only a declared scratch partition may be overwritten
+    const PartitionEntry* scratch = findPartitionByType(PART_TYPE_SCRATCH);
+    bool test1_pass = true;
+    if (scratch && scratch->length >= sizeof(test_data)) {
+        scrubNoteWrite(scratch->offset, 16);
+        fram.write(scratch->offset, test_data, 16);
+        fram.read(scratch->offset, read_data, 16);
+        
+        test1_pass = (memcmp(test_data, read_data, 16) == 0);
+        Console.print("  Result: ");
+        if (test1_pass) {
+            printSuccess("PASS");
+        } else {
+            printError("FAIL");
+        }
     } else {
-        printError("FAIL");
+        Console.print("  Result: ");
+        printWarning("SKIP - no scratch partition declared (see 'part init')");
     }
     
     // Test 2: Checksum function
-    Serial.println("Test 2: Checksum Function");
+    Console.println("Test 2: Checksum Function");
     uint8_t test_checksum_data[10] = {0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A};
     uint16_t checksum1 = calculateChecksum(test_checksum_data, 10);
     uint16_t checksum2 = calculateChecksum(test_checksum_data, 10);
     uint16_t expected_checksum = 0x01 + 0x02 + 0x03 + 0x04 + 0x05 + 0x06 + 0x07 + 0x08 + 0x09 + 0x0A; // = 55
     
-    Serial.print("  Expected checksum: "); Serial.println(expected_checksum);
-    Serial.print("  Calculated checksum 1: "); Serial.println(checksum1);
-    Serial.print("  Calculated checksum 2: "); Serial.println(checksum2);
+    Console.print("  Expected checksum: "); Console.println(expected_checksum);
+    Console.print("  Calculated checksum 1: "); Console.println(checksum1);
+    Console.print("  Calculated checksum 2: "); Console.println(checksum2);
     
     bool test2_pass = (checksum1 == checksum2 && checksum1 == expected_checksum);
-    Serial.print("  Result: ");
+    Console.print("  Result: ");
     if (test2_pass) {
         printSuccess("PASS");
     } else {
@@ -394,7 +622,7 @@ void cmdTest() {
     }
     
     // Test 3: Encryption/Decryption
-    Serial.println("Test 3: Encryption/Decryption");
+    Console.println("Test 3: Encryption/Decryption");
     String test_string = "Hello, FRAM!";
     uint8_t key[32] = {0}; // Test key
     uint8_t iv[8] = {0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08};
@@ -412,130 +640,841 @@ void cmdTest() {
     String decrypted_string = String((char*)decrypted);
     
     bool test3_pass = (enc_ok && dec_ok && decrypted_string == test_string);
-    Serial.print("  Original: "); Serial.println(test_string);
-    Serial.print("  Decrypted: "); Serial.println(decrypted_string);
-    Serial.print("  Result: ");
+    Console.print("  Original: "); Console.println(test_string);
+    Console.print("  Decrypted: "); Console.println(decrypted_string);
+    Console.print("  Result: ");
     if (test3_pass) {
         printSuccess("PASS");
     } else {
         printError("FAIL");
     }
     
+    // Test 4: Backup compression round trip
+    Console.println("Test 4: LZR Compression Round Trip");
+    bool test4_pass = testBackupCodec();
+    Console.print("  Result: ");
+    if (test4_pass) {
+        printSuccess("PASS");
+    } else {
+        printError("FAIL");
+    }
+    
+    // Test 5: Hex codec
+    Console.println("Test 5: Hex Codec");
+    bool test5_pass = testHexCodec();
+    Console.print("  Result: ");
+    if (test5_pass) {
+        printSuccess("PASS");
+    } else {
+        printError("FAIL");
+    }
+    
+    // Test 6: ESP32 reader library against the firmware
+    Console.println("Test 6: Reader Library Cross-Check");
+    bool test6_pass = testCredentialReader();
+    Console.print("  Result: ");
+    if (test6_pass) {
+        printSuccess("PASS");
+    } else {
+        printError("FAIL");
+    }
+    
+    // Test 7: JSON ingestion bounds
+    Console.println("Test 7: JSON Ingest (max-size record)");
+    bool test7_pass = testJSONIngest();
+    Console.print("  Result: ");
+    if (test7_pass) {
+        printSuccess("PASS");
+    } else {
+        printError("FAIL");
+    }
+    
     // Summary
-    Serial.println();
-    Serial.print("=== TEST SUMMARY: ");
-    if (test0_pass && test1_pass && test2_pass && test3_pass) {
+    Console.println();
+    Console.print("=== TEST SUMMARY: ");
+    if (test0_pass && test1_pass && test2_pass && test3_pass && test4_pass && test5_pass && test6_pass &&
+        test7_pass) {
         printSuccess("ALL TESTS PASSED");
     } else {
         printError("SOME TESTS FAILED");
     }
 }
 
-bool parseJSONCredentials(const String& json, DeviceCredentials& creds) {
-    DynamicJsonDocument doc(1024);
-    DeserializationError error = deserializeJson(doc, json);
+void cmdFill(const String& args) {
+    String pattern_arg = getArgument(args, 3);
     
-    if (error) {
-        Serial.print("JSON parsing error: ");
-        Serial.println(error.c_str());
-        return false;
+    if (pattern_arg.length() == 0) {
+        printError("Usage: fill <addr> <len> <hex pattern>");
+        return;
     }
     
-    // Extract fields
-    if (!doc.containsKey("device_name") || !doc.containsKey("wifi_ssid") ||
-        !doc.containsKey("wifi_password") || !doc.containsKey("admin_password") ||
-        !doc.containsKey("vps_token")) {
-        Serial.println("Missing required JSON fields");
-        return false;
+    unsigned long addr, len;
+    if (!parseNumberArgument(getArgument(args, 1), &addr) ||
+        !parseNumberArgument(getArgument(args, 2), &len)) {
+        printError("Invalid address or length");
+        return;
     }
     
-    creds.device_name = doc["device_name"].as<String>();
-    creds.wifi_ssid = doc["wifi_ssid"].as<String>();
-    creds.wifi_password = doc["wifi_password"].as<String>();
-    creds.admin_password = doc["admin_password"].as<String>();
-    creds.vps_token = doc["vps_token"].as<String>();
+    if (len == 0 || addr + len > FRAM_SIZE) {
+        printError("Range outside FRAM (0x0000-0x7FFF)");
+        return;
+    }
     
-    // Validate all fields
-    return validateDeviceName(creds.device_name) &&
-           validateWiFiSSID(creds.wifi_ssid) &&
-           validateWiFiPassword(creds.wifi_password) &&
-           creds.admin_password.length() > 0 &&
-           validateVPSToken(creds.vps_token);
+    uint8_t pattern[FRAM_FILL_MAX_PATTERN];
+    size_t pattern_len = 0;
+    if (!parseHexPattern(pattern_arg, pattern, &pattern_len)) {
+        printError("Invalid pattern (1-16 bytes as hex, e.g. FF or DEADBEEF)");
+        return;
+    }
+    
+    Console.print("Filling 0x");
+    Console.print(addr, HEX);
+    Console.print(" - 0x");
+    Console.print(addr + len - 1, HEX);
+    Console.print(" with ");
+    Console.print(pattern_len);
+    Console.println("-byte pattern");
+    
+    if (fillFRAM((uint16_t)addr, len, pattern, pattern_len)) {
+        printSuccess("Fill complete");
+    } else {
+        printError("Fill failed");
+    }
+}
+
+void cmdWipe(const String& args) {
+    String target = getArgument(args, 1);
+    target.toLowerCase();
+    
+    // With a partition table, only partitions flagged for wiping are touched.
+    // The table is re-read: the chip in the socket may not be the boot one.
+    reloadPartitions();
+    ByteRange ranges[PART_MAX];
+    uint8_t range_count = 0;
+    const PartitionEntry* part = findPartition(target.c_str());
+    
+    if (target == "credentials" || target == "creds") {
+        const PartitionEntry* creds = findPartitionByType(PART_TYPE_CREDENTIALS);
+        ranges[0] = creds ? ByteRange{ creds->offset, creds->length }
+                          : ByteRange{ FRAM_CREDENTIALS_ADDR, FRAM_CREDENTIALS_SIZE };
+        range_count = 1;
+    } else if (target == "all") {
+        range_count = partitionRanges(PART_FLAG_WIPE, ranges, PART_MAX);
+    } else if (part && (part->flags & PART_FLAG_WIPE)) {
+        ranges[0] = { part->offset, part->length };
+        range_count = 1;
+    } else {
+        printError(part ? "Partition is not flagged for wiping"
+                        : "Usage: wipe credentials|all|<partition>");
+        return;
+    }
+    
+    size_t total = 0;
+    for (uint8_t r = 0; r < range_count; r++) {
+        total += ranges[r].len;
+    }
+    
+    if (target == "all" && !partitionsLoaded()) {
+        printWarning("Wipe will erase the ENTIRE FRAM!");
+    } else {
+        Console.print("Wipe will erase ");
+        Console.print(total);
+        Console.print(" bytes in ");
+        Console.print(range_count);
+        Console.println(" range(s):");
+        for (uint8_t r = 0; r < range_count; r++) {
+            Console.print("  0x");
+            Console.print(ranges[r].addr, HEX);
+            Console.print(" - 0x");
+            Console.println(ranges[r].addr + ranges[r].len - 1, HEX);
+        }
+    }
+    Console.print("Type 'YES' to confirm: ");
+    
+    if (!readConfirmation(false)) {
+        printInfo("Wipe cancelled");
+        return;
+    }
+    
+    bool ok = range_count > 0;
+    for (uint8_t r = 0; r < range_count && ok; r++) {
+        ok = wipeFRAM(ranges[r].addr, ranges[r].len);
+    }
+    
+    if (ok) {
+        printSuccess("Wipe complete");
+    } else {
+        printError("Wipe failed");
+    }
+    reloadPartitions();     // 'wipe all' without a table clears the superblock too
 }
 
-String readSerialLine() {
+void cmdGang(const String& args) {
+    printInfo("=== Gang Programming ===");
+    
+    FRAMDevice devices[FRAM_MAX_DEVICES];
+    uint8_t found = discoverFRAMDevices(devices, FRAM_MAX_DEVICES);
+    
+    if (found == 0) {
+        printError("No FRAM devices found on 0x50-0x57");
+        return;
+    }
+    
+    Console.print("Found ");
+    Console.print(found);
+    Console.print(" FRAM device(s):");
+    for (uint8_t i = 0; i < found; i++) {
+        Console.print(" 0x");
+        Console.print(devices[i].i2c_addr, HEX);
+    }
+    Console.println();
+    
+    Console.print("Paste up to ");
+    Console.print(found);
+    Console.println(" JSON records, one per line, in address order (finish with 'END'):");
+    
+    DeviceCredentials* records = arenaNew<DeviceCredentials>(FRAM_MAX_DEVICES);
+    if (!records) {
+        return;
+    }
+    size_t count = readCredentialBatch(records, found);
+    
+    if (count == 0) {
+        printInfo("Gang programming cancelled");
+        return;
+    }
+    
+    if (count < found) {
+        Console.print("Only the first ");
+        Console.print(count);
+        Console.println(" chip(s) will be programmed");
+    }
+    
+    Console.print("Program ");
+    Console.print(count);
+    Console.print(" chip(s)? (YES/no): ");
+    if (!readConfirmation(true)) {
+        printInfo("Gang programming cancelled");
+        return;
+    }
+    
+    GangResult results[FRAM_MAX_DEVICES];
+    unsigned long total_us = 0;
+    uint8_t passed = programGang(devices, records, count, results, &total_us);
+    
+    printGangReport(records, results, count, total_us);
+    
+    if (passed == count) {
+        printSuccess("All chips programmed successfully!");
+    } else {
+        printError("Some chips failed - see table above");
+    }
+}
+
+void cmdDual(const String& args) {
+    String op_arg = getArgument(args, 1);
+    op_arg.toLowerCase();
+    
+    DualOperation op;
+    if (op_arg == "program") {
+        op = DUAL_PROGRAM;
+    } else if (op_arg == "backup") {
+        op = DUAL_BACKUP;
+    } else if (op_arg == "verify") {
+        op = DUAL_VERIFY;
+    } else {
+        printError("Usage: dual program|backup|verify");
+        return;
+    }
+    
+    initDualChannel();
+    printInfo("=== Dual Channel Mode (Wire on core 0, Wire1 on core 1) ===");
+    
+    DeviceCredentials* records = arenaNew<DeviceCredentials>(DUAL_CHANNEL_COUNT);
+    if (!records) {
+        return;
+    }
+    if (op == DUAL_PROGRAM) {
+        Console.println("Paste one JSON record per channel (channel 0 first):");
+        if (readCredentialBatch(records, DUAL_CHANNEL_COUNT) != DUAL_CHANNEL_COUNT) {
+            printInfo("Dual programming cancelled");
+            return;
+        }
+    }
+    
+    ChannelResult results[DUAL_CHANNEL_COUNT];
+    unsigned long wall_us = runDualChannel(op, records, results);
+    
+    if (op == DUAL_BACKUP) {
+        printDualBackup(results);
+    }
+    printDualReport(op, results, wall_us);
+    
+    bool all_ok = true;
+    for (uint8_t ch = 0; ch < DUAL_CHANNEL_COUNT; ch++) {
+        all_ok = all_ok && results[ch].ok;
+    }
+    
+    if (all_ok) {
+        printSuccess("Both channels completed");
+    } else {
+        printError("One or more channels failed - see report above");
+    }
+}
+
+void cmdLine(const String& args) {
+    printInfo("=== Production Line Mode ===");
+    Console.print("Paste up to ");
+    Console.print(LINE_MAX_RECORDS);
+    Console.println(" JSON records, one per line, in programming order (finish with 'END'):");
+    
+    DeviceCredentials* records = arenaNew<DeviceCredentials>(LINE_MAX_RECORDS);
+    if (!records) {
+        return;
+    }
+    size_t count = readCredentialBatch(records, LINE_MAX_RECORDS);
+    
+    if (count == 0) {
+        printInfo("Line mode cancelled");
+        return;
+    }
+    
+    Console.print(count);
+    Console.print(" record(s) loaded. Start line? (YES/no): ");
+    if (!readConfirmation(true)) {
+        printInfo("Line mode cancelled");
+        return;
+    }
+    
+    runProductionLine(records, count);
+    printInfo("Line mode finished");
+}
+
+size_t readCredentialBatch(DeviceCredentials* records, size_t max_records) {
+    size_t count = 0;
+    JsonIngestStats total = {0, 0, 0};
+    
+    while (count < max_records) {
+        Console.print("Record ");
+        Console.print(count + 1);
+        Console.print(": ");
+        
+        JsonIngestStats stats;
+        JsonIngestResult result = readJSONCredentials(records[count], true, &stats);
+        if (result == JSON_INGEST_END || result == JSON_INGEST_TIMEOUT) {
+            break;
+        }
+        
+        if (result != JSON_INGEST_OK) {
+            // A skipped record would shift every following chip, so reject the batch
+            Console.print("ERROR: Record ");
+            Console.print(count + 1);
+            Console.println(" is invalid - batch rejected");
+            return 0;
+        }
+        
+        Console.print("  ");
+        Console.println(records[count].device_name.c_str());
+        total.elapsed_us += stats.elapsed_us;
+        total.bytes += stats.bytes;
+        total.doc_used = max(total.doc_used, stats.doc_used);
+        count++;
+    }
+    
+    if (count > 0) {
+        printJSONIngestStats(total, count);
+    }
+    return count;
+}
+
+const char* readInputText(bool echo) {
     waitingForInput = true;
-    String input = "";
+    LineResult result = waitSerialLine(echo, serialPromptTimeout());
+    waitingForInput = false;
     
-    while (true) {
-        if (Serial.available()) {
-            char c = Serial.read();
-            
-            if (c == '\n' || c == '\r') {
-                if (input.length() > 0) {
-                    Serial.println();
-                    waitingForInput = false;
-                    return input;
-                }
-            } else if (c == '\b' || c == 127) { // Backspace
-                if (input.length() > 0) {
-                    input.remove(input.length() - 1);
-                    Serial.print("\b \b");
-                }
-            } else if (c >= 32 && c < 127) { // Printable characters
-                input += c;
-                Serial.print(c);
-            }
+    if (result == LINE_READY) {
+        return serialLineText();
+    }
+    
+    if (result == LINE_TIMEOUT) {
+        Console.println();
+        printWarning("No input - timed out");
+    } else {
+        printWarning("Line too long - ignored");
+    }
+    return nullptr;
+}
+
+bool readInputLine(String& line, bool echo) {
+    const char* text = readInputText(echo);
+    line = text ? text : "";
+    return text != nullptr;
+}
+
+String readSerialLine(bool echo) {
+    // A timeout or dropped line reads as empty, which no prompt accepts as YES
+    String line;
+    readInputLine(line, echo);
+    return line;
+}
+
+String getArgument(const String& input, int index) {
+    int pos = 0;
+    int len = input.length();
+    
+    for (int current = 0; pos < len; current++) {
+        // Skip separators
+        while (pos < len && input.charAt(pos) == ' ') pos++;
+        if (pos >= len) break;
+        
+        int end = input.indexOf(' ', pos);
+        if (end < 0) end = len;
+        
+        if (current == index) {
+            return input.substring(pos, end);
         }
-        delay(1);
+        pos = end;
     }
+    
+    return "";
+}
+
+bool parseNumberArgument(const String& arg, unsigned long* value) {
+    if (arg.length() == 0) {
+        return false;
+    }
+    
+    // Base 0 accepts decimal, 0x hex and leading-zero octal
+    char* end = nullptr;
+    *value = strtoul(arg.c_str(), &end, 0);
+    return end != nullptr && *end == '\0';
+}
+
+bool parseHexPattern(const String& arg, uint8_t* pattern, size_t* pattern_len) {
+    String hex = arg;
+    if (hex.startsWith("0x") || hex.startsWith("0X")) {
+        hex = hex.substring(2);
+    }
+    
+    size_t error_pos;
+    return hex.length() > 0 &&
+           hexDecode(hex.c_str(), hex.length(), pattern, FRAM_FILL_MAX_PATTERN,
+                     pattern_len, &error_pos);
 }
 
 void printPrompt() {
-    Serial.print("FRAM> ");
+    Console.print("FRAM> ");
+}
+
+// Status lines are sent at once: they often come just before a long silent step
+static void printStatus(const char* tag, const String& message) {
+    Console.printf("%s %s\r\n", tag, message.c_str());
+    Console.flush();
 }
 
 void printSuccess(const String& message) {
-    Serial.print("[SUCCESS] ");
-    Serial.println(message);
+    printStatus("[SUCCESS]", message);
 }
 
 void printError(const String& message) {
-    Serial.print("[ERROR] ");
-    Serial.println(message);
+    printStatus("[ERROR]", message);
 }
 
 void printWarning(const String& message) {
-    Serial.print("[WARNING] ");
-    Serial.println(message);
+    printStatus("[WARNING]", message);
 }
 
 void printInfo(const String& message) {
-    Serial.print("[INFO] ");
-    Serial.println(message);
+    printStatus("[INFO]", message);
 }
 
 void printHexDump(const uint8_t* data, size_t length) {
-    for (size_t i = 0; i < length; i++) {
-        if (i % 16 == 0) {
-            char addr_str[16];
-            sprintf(addr_str, "%08X: ", (unsigned int)i);
-            Serial.print(addr_str);
+    // Each row is built in the console buffer: "OFFSET: XX XX ...  |ascii|"
+    for (size_t row = 0; row < length; row += 16) {
+        char* line = Console.reserve(10 + 3 * 16 + 2 + 16 + 4);
+        size_t count = min((size_t)16, length - row);
+        size_t n = sprintf(line, "%08X: ", (unsigned int)row);
+        n += hexEncode(&data[row], count, &line[n], ' ');
+        
+        line[n++] = ' ';
+        line[n++] = '|';
+        for (size_t j = 0; j < count; j++) {
+            uint8_t c = data[row + j];
+            line[n++] = (c >= 32 && c < 127) ? c : '.';
+        }
+        line[n++] = '|';
+        line[n++] = '\r';
+        line[n++] = '\n';
+        Console.commit(n);
+    }
+}
+void cmdMerkle(const String& args) {
+    // Kept between calls so the host can walk the tree with 'merkle node'
+    static MerkleTree tree;
+    
+    String target = getArgument(args, 1);
+    target.toLowerCase();
+    
+    if (target == "node") {
+        unsigned long depth, index;
+        if (!parseNumberArgument(getArgument(args, 2), &depth) ||
+            !parseNumberArgument(getArgument(args, 3), &index)) {
+            printError("Usage: merkle node <depth> <index>");
+            return;
+        }
+        if (!tree.valid) {
+            printError("No tree built yet - run 'merkle' first");
+            return;
+        }
+        printMerkleNode(tree, depth, index);
+        return;
+    }
+    
+    unsigned long start = 0;
+    unsigned long size = FRAM_SIZE;
+    int leaf_arg = 2;
+    
+    if (target == "creds" || target == "credentials") {
+        start = FRAM_CREDENTIALS_ADDR;
+        size = FRAM_CREDENTIALS_SIZE;
+    } else if (target.length() > 0 && target != "all") {
+        if (!parseNumberArgument(target, &start) ||
+            !parseNumberArgument(getArgument(args, 2), &size)) {
+            printError("Usage: merkle [all|creds|<addr> <len>] [leaf]");
+            return;
+        }
+        leaf_arg = 3;
+    }
+    
+    unsigned long leaf_size = MERKLE_DEFAULT_LEAF;
+    String leaf_str = getArgument(args, leaf_arg);
+    if (leaf_str.length() > 0 && !parseNumberArgument(leaf_str, &leaf_size)) {
+        printError("Invalid leaf size");
+        return;
+    }
+    
+    if (!detectFRAM()) {
+        printError("FRAM not detected");
+        return;
+    }
+    
+    if (start >= FRAM_SIZE) {
+        printError("Address out of range");
+        return;
+    }
+    
+    unsigned long start_us = micros();
+    if (!buildMerkleTree(tree, start, size, leaf_size)) {
+        printError("Merkle tree build failed");
+        return;
+    }
+    unsigned long elapsed_us = micros() - start_us;
+    
+    printMerkleSummary(tree);
+    Console.print("Built in ");
+    Console.print(elapsed_us / 1000);
+    Console.println(" ms. Walk mismatches with 'merkle node <depth> <index>'");
+}
+
+bool receiveRestoreData(RestoreStream& stream) {
+    // Lines are not echoed: a full backup is ~70 KB of text
+    while (!stream.ended) {
+        String line;
+        if (!readInputLine(line, false)) {
+            // Still drain the writer core so chunks already queued are verified
+            printError("Restore stream stalled before BACKUP_END");
+            restoreFinish(stream);
+            return false;
         }
+        line.trim();
         
-        char hex_str[4];
-        sprintf(hex_str, "%02X ", data[i]);
-        Serial.print(hex_str);
+        if (line == "END") {
+            break;
+        }
         
-        if ((i + 1) % 16 == 0 || i == length - 1) {
-            // Print ASCII representation
-            Serial.print(" |");
-            size_t start = i - (i % 16);
-            for (size_t j = start; j <= i; j++) {
-                char c = (data[j] >= 32 && data[j] < 127) ? data[j] : '.';
-                Serial.print(c);
+        restoreFeedLine(stream, line);
+    }
+    
+    return restoreFinish(stream);
+}
+
+void cmdScrub(const String& args) {
+    String action = getArgument(args, 1);
+    action.toLowerCase();
+    
+    if (action == "on") {
+        printInfo("Building scrub index if needed...");
+        if (scrubEnable(true)) {
+            printSuccess("Background scrub enabled (persists across resets)");
+        } else {
+            printError("Could not enable scrub");
+        }
+    } else if (action == "off") {
+        scrubEnable(false);
+        printSuccess("Background scrub disabled");
+    } else if (action == "rebuild") {
+        unsigned long start = millis();
+        if (scrubRebuild()) {
+            Console.print("Index rebuilt in ");
+            Console.print(millis() - start);
+            Console.println(" ms");
+            printSuccess("All regions re-baselined, mismatch log cleared");
+        } else {
+            printError("Scrub index rebuild failed");
+        }
+    } else if (action == "status" || action.length() == 0) {
+        printScrubStatus();
+    } else {
+        printError("Usage: scrub on|off|status|rebuild");
+    }
+}
+
+void cmdMigrate(const String& args) {
+    printInfo("=== Credential Migration (v1 -> v2) ===");
+    printWarning("The credentials section will be rewritten in the v2 format");
+    Console.print("Type 'YES' to confirm: ");
+    
+    if (!readConfirmation(false)) {
+        printInfo("Migration cancelled");
+        return;
+    }
+    
+    if (migrateCredentialsSection()) {
+        printSuccess("Credentials are stored as v2");
+    } else {
+        printError("Migration failed");
+    }
+}
+
+static void printProfileLookup(const ProfileLookup& lookup) {
+    Console.print("Lookup: slot ");
+    Console.print(lookup.index);
+    Console.print(", ");
+    Console.print(lookup.probes);
+    Console.print(lookup.probes == 1 ? " probe" : " probes");
+    Console.print(", directory ");
+    Console.print(lookup.dir_us);
+    Console.print(" us, record ");
+    Console.print(lookup.record_us);
+    Console.println(" us");
+}
+
+void cmdProfile(const String& args) {
+    String action = getArgument(args, 1);
+    String name = getArgument(args, 2);
+    action.toLowerCase();
+    
+    if (!detectFRAM()) {
+        printError("FRAM not detected");
+        return;
+    }
+    
+    static CredentialRecord rec;
+    ProfileLookup lookup;
+    
+    if (action == "list" || action.length() == 0) {
+        printProfileList();
+    } else if (action == "add") {
+        if (!validateProfileName(name)) {
+            printError("Usage: profile add <name>");
+            return;
+        }
+        
+        bool replacing = profileFind(name.c_str(), rec, &lookup);
+        Console.println(replacing ? "Replacing existing profile. Paste JSON credentials (single line):"
+                                 : "Paste JSON credentials (single line):");
+        Console.print("JSON: ");
+        
+        DeviceCredentials* creds = arenaNew<DeviceCredentials>();
+        if (!creds) {
+            return;
+        }
+        JsonIngestResult result = readJSONCredentials(*creds, false, nullptr);
+        if (result != JSON_INGEST_OK) {
+            if (result == JSON_INGEST_INVALID) {
+                printError("Invalid JSON format");
             }
-            Serial.println("|");
+            return;
         }
+        
+        if (profileStore(name.c_str(), *creds, &lookup)) {
+            printProfileLookup(lookup);
+            printSuccess(replacing ? "Profile replaced" : "Profile added");
+        } else {
+            printError("Failed to store profile");
+        }
+    } else if (action == "get") {
+        if (!profileFind(name.c_str(), rec, &lookup)) {
+            printError("Profile not found");
+            return;
+        }
+        printProfileLookup(lookup);
+        
+        DeviceCredentials* slot = arenaNew<DeviceCredentials>();
+        if (!slot) {
+            return;
+        }
+        DeviceCredentials& creds = *slot;
+        if (decryptCredentials(rec, creds)) {
+            Console.println();
+            Console.print("=== PROFILE: "); Console.print(name); Console.println(" ===");
+            Console.print("Device Name: "); Console.println(creds.device_name.c_str());
+            Console.print("WiFi SSID: "); Console.println(creds.wifi_ssid.c_str());
+            Console.print("WiFi Password: "); Console.println("******* (hidden)");
+            Console.print("Admin Hash: "); Console.println(creds.admin_password.c_str());
+            Console.print("VPS Token: "); Console.println(creds.vps_token.c_str());
+        } else {
+            printWarning("Could not decrypt profile (incorrect key?)");
+        }
+    } else if (action == "del") {
+        printWarning("The profile record will be erased");
+        Console.print("Type 'YES' to confirm: ");
+        
+        if (!readConfirmation(false)) {
+            printInfo("Delete cancelled");
+            return;
+        }
+        
+        if (profileDelete(name.c_str())) {
+            printSuccess("Profile deleted");
+        } else {
+            printError("Profile not found");
+        }
+    } else if (action == "bench") {
+        printInfo("=== Profile Lookup Benchmark ===");
+        runProfileBench();
+    } else {
+        printError("Usage: profile list|add <name>|get <name>|del <name>|bench");
+    }
+}
+
+void cmdPart(const String& args) {
+    String action = getArgument(args, 1);
+    String name = getArgument(args, 2);
+    action.toLowerCase();
+    reloadPartitions();
+    
+    if (action == "show" || action.length() == 0) {
+        printPartitionTable();
+        return;
+    }
+    
+    if (!detectFRAM()) {
+        printError("FRAM not detected");
+        return;
+    }
+    
+    if (action == "init") {
+        printWarning(partitionsLoaded() ? "The existing partition table will be replaced"
+                                        : "A partition table will be written at 0x7E00");
+        Console.print("Type 'YES' to confirm: ");
+        
+        if (!readConfirmation(false)) {
+            printInfo("Partition init cancelled");
+            return;
+        }
+        
+        if (writeDefaultPartitions()) {
+            printPartitionTable();
+            printSuccess("Partition table written");
+        } else {
+            printError("Could not write partition table");
+        }
+    } else if (action == "seal") {
+        if (sealPartitions(name.length() > 0 ? name.c_str() : nullptr)) {
+            printSuccess("Partition CRCs recorded; 'verify' now checks them");
+        } else {
+            printError("Seal failed");
+        }
+    } else {
+        printError("Usage: part show|init|seal [name]");
+    }
+}
+
+void cmdRekey(const String& args) {
+    String option = getArgument(args, 1);
+    option.toLowerCase();
+    
+    if (option.length() > 0 && option != "salt") {
+        printError("Usage: rekey [salt]");
+        return;
     }
+    bool rotate_salt = option == "salt";
+    
+    printInfo(rotate_salt ? "=== Credential Re-key (new IV and key salt) ===" : "=== Credential Re-key (new IV) ===");
+    printWarning("Every encrypted field will be rewritten in place");
+    Console.print("Type 'YES' to confirm: ");
+    
+    if (!readConfirmation(false)) {
+        printInfo("Re-key cancelled");
+        return;
+    }
+    
+    if (rekeyCredentialsSection(rotate_salt)) {
+        printSuccess("Credentials re-keyed");
+    } else {
+        printError("Re-key failed");
+    }
+}
+
+void cmdInput(const String& args) {
+    String action = getArgument(args, 1);
+    action.toLowerCase();
+    
+    if (action == "timeout") {
+        unsigned long seconds;
+        if (!parseNumberArgument(getArgument(args, 2), &seconds) || seconds > 86400) {
+            printError("Usage: input timeout <seconds> (0 = wait forever)");
+            return;
+        }
+        setSerialPromptTimeout(seconds * 1000);
+    } else if (action.length() > 0) {
+        printError("Usage: input [timeout <seconds>]");
+        return;
+    }
+    
+    const SerialLineStats& stats = serialLineStats();
+    Console.println("=== Console Input ===");
+    Console.print("Bytes received: ");
+    Console.println(stats.bytes_in);
+    Console.print("Lines:          ");
+    Console.println(stats.lines);
+    Console.print("Ring peak:      ");
+    Console.print(stats.ring_peak);
+    Console.print(" / ");
+    Console.println(SERIAL_RING_SIZE);
+    Console.print("Overlong lines: ");
+    Console.println(stats.too_long);
+    Console.print("Timeouts:       ");
+    Console.println(stats.timeouts);
+    Console.print("Prompt timeout: ");
+    if (serialPromptTimeout() == 0) {
+        Console.println("none");
+    } else {
+        Console.print(serialPromptTimeout() / 1000);
+        Console.println(" s");
+    }
+}
+
+void cmdMem(const String& args) {
+    printHeapStats("");
+    Console.print("DeviceCredentials: ");
+    Console.print(sizeof(DeviceCredentials));
+    Console.println(" B each, taken from the command arena");
+}
+
+void cmdLogLevel(const String& args) {
+    String arg = getArgument(args, 1);
+    if (arg.length() > 0) {
+        uint8_t level;
+        if (!parseLogLevel(arg.c_str(), &level)) {
+            printError("Usage: loglevel [none|error|warn|info|debug|verbose|0-5]");
+            return;
+        }
+        if (setLogLevel(level) < level) {
+            Console.printf("%s is compiled out (CORE_DEBUG_LEVEL=%d)\r\n", logLevelName(level), LOG_COMPILED_LEVEL);
+        }
+    }
+    
+    Console.printf("Log level: %s (compiled in: %s)\r\n", logLevelName(logLevel()), logLevelName(LOG_COMPILED_LEVEL));
 }
\ No newline at end of file
@@ -0,0 +1,60 @@
+#include "command_arena.h"
+#include "console_out.h"
+#include <malloc.h>
+
+static uint8_t arena[COMMAND_ARENA_SIZE] __attribute__((aligned(8)));
+static size_t arena_used = 0;
+static size_t arena_peak = 0;
+
+void* arenaAlloc(size_t size, size_t align) {
+    size_t start = (arena_used + align - 1) & ~(align - 1);
+    if (start + size > COMMAND_ARENA_SIZE) {
+        Console.print("ERROR: Command arena exhausted (");
+        Console.print(start + size);
+        Console.print(" of ");
+        Console.print(COMMAND_ARENA_SIZE);
+        Console.println(" bytes)");
+        return nullptr;
+    }
+    
+    arena_used = start + size;
+    if (arena_used > arena_peak) {
+        arena_peak = arena_used;
+    }
+    return &arena[start];
+}
+
+void arenaReset() {
+    memset(arena, 0, arena_used);
+    arena_used = 0;
+}
+
+size_t arenaUsed() {
+    return arena_used;
+}
+
+size_t arenaPeak() {
+    return arena_peak;
+}
+
+HeapStats heapStats() {
+    struct mallinfo info = mallinfo();
+    HeapStats stats;
+    stats.used = info.uordblks;
+    stats.high_water = info.arena;
+    return stats;
+}
+
+void printHeapStats(const char* label) {
+    HeapStats stats = heapStats();
+    Console.print(label);
+    Console.print("heap in use ");
+    Console.print(stats.used);
+    Console.print(" B, high-water ");
+    Console.print(stats.high_water);
+    Console.print(" B, command arena peak ");
+    Console.print(arena_peak);
+    Console.print("/");
+    Console.print(COMMAND_ARENA_SIZE);
+    Console.println(" B");
+}
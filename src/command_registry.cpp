@@ -0,0 +1,378 @@
+#include "command_registry.h"
+#include "cli_handler.h"
+#include "serial_line.h"
+#include "command_arena.h"
+#include "console_out.h"
+
+static constexpr CommandSpec COMMANDS[] = {
+    // name       alias  handler       options                                     flags             help
+    { "help",     "h",   cmdHelp,      "",                                         0,                "Show this help" },
+    { "detect",   "d",   cmdDetect,    "",                                         0,                "Detect FRAM device" },
+    { "info",     "i",   cmdInfo,      "",                                         0,                "Show FRAM information" },
+    { "backup",   "b",   cmdBackup,    "",                                         0,                "Backup entire FRAM content: backup [hex|lzr|inc [block]|bin [lzr]]" },
+    { "restore",  "r",   cmdRestore,   "",                                         CMD_FLAG_CONFIRM, "Restore FRAM from backup" },
+    { "program",  "p",   cmdProgram,   "name= ssid= password= admin= token=",      CMD_FLAG_CONFIRM, "Program credentials to FRAM [--name --ssid --password --admin --token]" },
+    { "verify",   "v",   cmdVerify,    "",                                         0,                "Verify stored credentials (verify full: decrypt all)" },
+    { "config",   "c",   cmdConfig,    "",                                         CMD_FLAG_CONFIRM, "Configure via JSON input" },
+    { "test",     "t",   cmdTest,      "",                                         0,                "Test FRAM read/write" },
+    { "fill",     "f",   cmdFill,      "",                                         0,                "Fill range: fill <addr> <len> <hex pattern>" },
+    { "wipe",     "w",   cmdWipe,      "",                                         CMD_FLAG_CONFIRM, "Secure wipe: wipe credentials|all|<partition>" },
+    { "gang",     "g",   cmdGang,      "",                                         CMD_FLAG_CONFIRM, "Program all FRAMs on 0x50-0x57 from JSON lines" },
+    { "dual",     "",    cmdDual,      "",                                         0,                "Both buses in parallel: dual program|backup|verify" },
+    { "line",     "l",   cmdLine,      "",                                         CMD_FLAG_CONFIRM, "Production line: auto-program chips as they are inserted" },
+    { "merkle",   "m",   cmdMerkle,    "",                                         0,                "Hash tree: merkle [all|creds|<addr> <len>] [leaf] | merkle node <depth> <idx>" },
+    { "scrub",    "",    cmdScrub,     "",                                         0,                "Background CRC check: scrub on|off|status|rebuild" },
+    { "migrate",  "",    cmdMigrate,   "",                                         CMD_FLAG_CONFIRM, "Convert v1 credentials to the compact v2 record" },
+    { "rekey",    "",    cmdRekey,     "",                                         CMD_FLAG_CONFIRM, "Re-encrypt credentials under a new IV: rekey [salt]" },
+    { "profile",  "",    cmdProfile,   "",                                         CMD_FLAG_CONFIRM, "Site profiles: profile list|add <name>|get <name>|del <name>|bench" },
+    { "part",     "",    cmdPart,      "",                                         CMD_FLAG_CONFIRM, "Partition table: part show|init|seal [name]" },
+    { "input",    "",    cmdInput,     "",                                         0,                "Console input stats: input [timeout <seconds>]" },
+    { "mem",      "",    cmdMem,       "",                                         0,                "Heap and command arena usage" },
+    { "loglevel", "",    cmdLogLevel,  "",                                         0,                "Diagnostic output level: loglevel [none|error|warn|info|debug|verbose]" },
+};
+
+static constexpr size_t COMMAND_COUNT = sizeof(COMMANDS) / sizeof(COMMANDS[0]);
+
+static constexpr bool sameWord(const char* a, const char* b) {
+    while (*a && *a == *b) {
+        a++;
+        b++;
+    }
+    return *a == *b;
+}
+
+static constexpr bool commandWordsUnique() {
+    for (size_t i = 0; i < COMMAND_COUNT; i++) {
+        for (size_t j = i + 1; j < COMMAND_COUNT; j++) {
+            const char* a[2] = { COMMANDS[i].name, COMMANDS[i].alias };
+            const char* b[2] = { COMMANDS[j].name, COMMANDS[j].alias };
+            for (const char* x : a) {
+                for (const char* y : b) {
+                    if (*x && sameWord(x, y)) {
+                        return false;
+                    }
+                }
+            }
+        }
+    }
+    return true;
+}
+
+static_assert(commandWordsUnique(), "Duplicate command name or alias in COMMANDS");
+
+// Options of the running command; values point into option_buf
+struct ParsedOption {
+    const char* name;
+    const char* value;
+};
+
+static char option_buf[SERIAL_LINE_MAX + 1];
+static ParsedOption options[CLI_MAX_OPTIONS];
+static uint8_t option_count = 0;
+static bool option_yes = false;
+
+// Case-insensitive match of a word of known length against a table entry
+static bool wordEquals(const char* word, size_t len, const char* name) {
+    return strlen(name) == len && strncasecmp(word, name, len) == 0;
+}
+
+const CommandSpec* findCommand(const char* input) {
+    size_t len = 0;
+    while (input[len] != '\0' && input[len] != ' ') {
+        len++;
+    }
+    
+    for (size_t i = 0; i < COMMAND_COUNT; i++) {
+        if (wordEquals(input, len, COMMANDS[i].name) ||
+            (COMMANDS[i].alias[0] && wordEquals(input, len, COMMANDS[i].alias))) {
+            return &COMMANDS[i];
+        }
+    }
+    return nullptr;
+}
+
+// -1 unknown, 0 flag, 1 takes a value
+static int optionArity(const char* schema, const char* name) {
+    size_t len = strlen(name);
+    const char* p = schema;
+    
+    while (*p) {
+        while (*p == ' ') p++;
+        const char* start = p;
+        while (*p && *p != ' ' && *p != '=') p++;
+        
+        bool has_value = (*p == '=');
+        if ((size_t)(p - start) == len && len > 0 && strncmp(start, name, len) == 0) {
+            return has_value ? 1 : 0;
+        }
+        while (*p && *p != ' ') p++;
+    }
+    return -1;
+}
+
+// Split the next word off *pos in place, removing quotes and escapes.
+// Sets *quoted if any part of it was quoted; returns nullptr at the end.
+static char* nextWord(char** pos, bool* quoted, bool* bad) {
+    char* src = *pos;
+    while (*src == ' ') src++;
+    if (*src == '\0') {
+        return nullptr;
+    }
+    
+    char* start = src;
+    char* dst = src;
+    bool in_quotes = false;
+    *quoted = false;
+    
+    while (*src && (in_quotes || *src != ' ')) {
+        if (*src == '"') {
+            in_quotes = !in_quotes;
+            *quoted = true;
+            src++;
+            continue;
+        }
+        if (in_quotes && *src == '\\' && (src[1] == '"' || src[1] == '\\')) {
+            src++;
+        }
+        *dst++ = *src++;
+    }
+    
+    if (in_quotes) {
+        *bad = true;
+    }
+    
+    bool more = (*src != '\0');
+    *dst = '\0';
+    *pos = more ? src + 1 : src;
+    return start;
+}
+
+// Options whose values never go back out on the console
+static const char* const SECRET_OPTIONS[] = { "password", "admin", "token" };
+
+static bool isSecretOption(const char* name, size_t len) {
+    for (const char* secret : SECRET_OPTIONS) {
+        if (strlen(secret) == len && strncmp(name, secret, len) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void printCommandEcho(const String& input) {
+    const char* p = input.c_str();
+    bool mask_next = false;
+    bool first = true;
+    
+    while (*p) {
+        while (*p == ' ') p++;
+        if (!*p) break;
+        
+        // One word as nextWord() would split it, left as typed
+        const char* start = p;
+        bool in_quotes = false;
+        while (*p && (in_quotes || *p != ' ')) {
+            if (in_quotes && *p == '\\' && (p[1] == '"' || p[1] == '\\')) {
+                p++;
+            } else if (*p == '"') {
+                in_quotes = !in_quotes;
+            }
+            p++;
+        }
+        
+        if (!first) {
+            Console.print(' ');
+        }
+        first = false;
+        
+        if (mask_next) {
+            Console.print("***");
+            mask_next = false;
+            continue;
+        }
+        
+        if (start[0] == '-' && start[1] == '-') {
+            const char* name = start + 2;
+            const char* end = name;
+            while (end < p && *end != '=') end++;
+            
+            if (isSecretOption(name, end - name)) {
+                Console.write((const uint8_t*)start, end - start);
+                if (end < p) {
+                    Console.print("=***");
+                } else {
+                    mask_next = true;
+                }
+                continue;
+            }
+        }
+        Console.write((const uint8_t*)start, p - start);
+    }
+}
+
+static void printOptionUsage(const CommandSpec& spec) {
+    Console.print("Options for '");
+    Console.print(spec.name);
+    Console.print("':");
+    
+    const char* p = spec.options;
+    while (*p) {
+        while (*p == ' ') p++;
+        if (!*p) break;
+        Console.print(" --");
+        while (*p && *p != ' ' && *p != '=') {
+            Console.print(*p++);
+        }
+        if (*p == '=') {
+            Console.print(" <value>");
+            p++;
+        }
+    }
+    if (spec.flags & CMD_FLAG_CONFIRM) {
+        Console.print(" --yes");
+    }
+    if (!spec.options[0] && !(spec.flags & CMD_FLAG_CONFIRM)) {
+        Console.print(" none");
+    }
+    Console.println();
+}
+
+// Pull --options out of the line; positional words (command word first) go to 'positional'
+static bool parseOptions(const CommandSpec& spec, const String& input, String& positional) {
+    option_count = 0;
+    option_yes = false;
+    
+    size_t len = min((size_t)input.length(), sizeof(option_buf) - 1);
+    memcpy(option_buf, input.c_str(), len);
+    option_buf[len] = '\0';
+    
+    char* pos = option_buf;
+    bool quoted = false;
+    bool bad = false;
+    char* word;
+    
+    while ((word = nextWord(&pos, &quoted, &bad)) != nullptr) {
+        if (bad) {
+            printError("Unterminated quote");
+            return false;
+        }
+        
+        if (quoted || word[0] != '-' || word[1] != '-') {
+            if (positional.length() > 0) {
+                positional += ' ';
+            }
+            positional += word;
+            continue;
+        }
+        
+        char* name = word + 2;
+        char* value = strchr(name, '=');
+        if (value) {
+            *value++ = '\0';
+        }
+        
+        if (strcmp(name, "yes") == 0 && (spec.flags & CMD_FLAG_CONFIRM) && !value) {
+            option_yes = true;
+            continue;
+        }
+        
+        int arity = optionArity(spec.options, name);
+        if (arity < 0 || (arity == 0 && value)) {
+            Console.print("ERROR: Unknown option --");
+            Console.println(name);
+            printOptionUsage(spec);
+            return false;
+        }
+        
+        if (arity == 1 && !value) {
+            value = nextWord(&pos, &quoted, &bad);
+            if (!value || bad) {
+                Console.print("ERROR: Option --");
+                Console.print(name);
+                Console.println(" needs a value");
+                return false;
+            }
+        }
+        
+        if (option_count >= CLI_MAX_OPTIONS) {
+            printError("Too many options");
+            return false;
+        }
+        options[option_count].name = name;
+        options[option_count].value = value ? value : "";
+        option_count++;
+    }
+    
+    return true;
+}
+
+void runCommandLine(const String& input) {
+    Console.println(); // New line after command
+    
+    const CommandSpec* spec = findCommand(input.c_str());
+    if (!spec) {
+        printError("Unknown command. Type 'help' for available commands.");
+        return;
+    }
+    
+    // Lines without options reach the handler untouched
+    if (input.indexOf("--") < 0) {
+        option_count = 0;
+        option_yes = false;
+        spec->handler(input);
+    } else {
+        String positional;
+        if (parseOptions(*spec, input, positional)) {
+            spec->handler(positional);
+        }
+        option_count = 0;
+        option_yes = false;
+    }
+    
+    // Zero whatever the command took from the arena (plaintext credentials)
+    arenaReset();
+}
+
+void printCommandList() {
+    for (size_t i = 0; i < COMMAND_COUNT; i++) {
+        const CommandSpec& spec = COMMANDS[i];
+        size_t width = strlen(spec.name);
+        
+        Console.print("  ");
+        Console.print(spec.name);
+        if (spec.alias[0]) {
+            Console.print(" (");
+            Console.print(spec.alias);
+            Console.print(")");
+            width += strlen(spec.alias) + 3;
+        }
+        for (; width < 13; width++) {
+            Console.print(' ');
+        }
+        Console.print("- ");
+        Console.println(spec.help);
+    }
+}
+
+const char* cliOption(const char* name) {
+    for (uint8_t i = 0; i < option_count; i++) {
+        if (strcmp(options[i].name, name) == 0) {
+            return options[i].value;
+        }
+    }
+    return nullptr;
+}
+
+bool cliYes() {
+    return option_yes;
+}
+
+bool readConfirmation(bool accept_short) {
+    if (option_yes) {
+        Console.println("YES (--yes)");
+        return true;
+    }
+    
+    String answer = readSerialLine();
+    return answer == "YES" || (accept_short && (answer == "yes" || answer == "y"));
+}
@@ -0,0 +1,161 @@
+#include "console_out.h"
+#include <stdarg.h>
+
+ConsoleOut Console;
+
+struct ConsoleBuffer {
+    char* data;
+    size_t size;
+    size_t len;
+    bool line_mode;                 // Send at each newline (core 1)
+    unsigned long first_ms;         // When the oldest buffered byte arrived
+    ConsoleStats stats;
+};
+
+static char core0_data[CONSOLE_BUFFER_SIZE];
+static char core1_data[CONSOLE_LINE_SIZE];
+static ConsoleBuffer buffers[2] = {
+    { core0_data, sizeof(core0_data), 0, false, 0, { 0, 0, 0 } },
+    { core1_data, sizeof(core1_data), 0, true, 0, { 0, 0, 0 } }
+};
+
+// Each core only ever touches its own buffer, so no locking is needed
+static ConsoleBuffer& coreBuffer() {
+    return buffers[rp2040.cpuid() == 0 ? 0 : 1];
+}
+
+static void sendRaw(ConsoleBuffer& b, const uint8_t* data, size_t len) {
+    unsigned long start = micros();
+    Serial.write(data, len);
+    b.stats.write_us += micros() - start;
+    b.stats.bytes += len;
+    b.stats.writes++;
+}
+
+static void sendBuffer(ConsoleBuffer& b) {
+    if (b.len > 0) {
+        sendRaw(b, (const uint8_t*)b.data, b.len);
+        b.len = 0;
+    }
+}
+
+// After new text was added at 'added': send if the buffer is full, the line
+// is complete (core 1) or the oldest text has waited long enough (core 0)
+static void settle(ConsoleBuffer& b, const char* added, size_t len) {
+    if (b.len == b.size) {
+        sendBuffer(b);
+    } else if (b.line_mode) {
+        if (memchr(added, '\n', len)) {
+            sendBuffer(b);
+        }
+    } else if (millis() - b.first_ms >= CONSOLE_HOLD_MS) {
+        sendBuffer(b);
+    }
+}
+
+size_t ConsoleOut::write(uint8_t c) {
+    return write(&c, 1);
+}
+
+size_t ConsoleOut::write(const uint8_t* data, size_t len) {
+    ConsoleBuffer& b = coreBuffer();
+    
+    // Blocks as large as the buffer (binary frames) go out directly
+    if (len >= b.size) {
+        sendBuffer(b);
+        sendRaw(b, data, len);
+        return len;
+    }
+    
+    if (b.size - b.len < len) {
+        sendBuffer(b);
+    }
+    if (b.len == 0) {
+        b.first_ms = millis();
+    }
+    char* start = &b.data[b.len];
+    memcpy(start, data, len);
+    b.len += len;
+    settle(b, start, len);
+    return len;
+}
+
+void ConsoleOut::flush() {
+    sendBuffer(coreBuffer());
+}
+
+char* ConsoleOut::reserve(size_t len) {
+    ConsoleBuffer& b = coreBuffer();
+    if (len > b.size) {
+        return nullptr;
+    }
+    if (b.size - b.len < len) {
+        sendBuffer(b);
+    }
+    if (b.len == 0) {
+        b.first_ms = millis();
+    }
+    return &b.data[b.len];
+}
+
+void ConsoleOut::commit(size_t len) {
+    ConsoleBuffer& b = coreBuffer();
+    char* start = &b.data[b.len];
+    b.len += len;
+    settle(b, start, len);
+}
+
+size_t ConsoleOut::printf(const char* format, ...) {
+    ConsoleBuffer& b = coreBuffer();
+    
+    // Format at the end of the buffer; if it does not fit, send the buffer
+    // and format once more at its start
+    for (int attempt = 0; attempt < 2; attempt++) {
+        if (b.len == 0) {
+            b.first_ms = millis();
+        }
+        size_t room = b.size - b.len;
+        va_list args;
+        va_start(args, format);
+        int n = vsnprintf(&b.data[b.len], room, format, args);
+        va_end(args);
+        
+        if (n < 0) {
+            return 0;
+        }
+        if ((size_t)n < room || b.len == 0) {
+            size_t used = min((size_t)n, room - 1);
+            commit(used);
+            return used;
+        }
+        sendBuffer(b);
+    }
+    return 0;
+}
+
+ConsoleStats consoleStats() {
+    ConsoleStats total = buffers[0].stats;
+    total.bytes += buffers[1].stats.bytes;
+    total.writes += buffers[1].stats.writes;
+    total.write_us += buffers[1].stats.write_us;
+    return total;
+}
+
+void printConsoleStats(const ConsoleStats& before, unsigned long elapsed_us) {
+    Console.flush();
+    ConsoleStats now = consoleStats();
+    uint32_t bytes = now.bytes - before.bytes;
+    uint32_t writes = now.writes - before.writes;
+    
+    Console.print("Console: ");
+    Console.print(bytes);
+    Console.print(" bytes in ");
+    Console.print(writes);
+    Console.print(" USB writes (");
+    Console.print(writes > 0 ? bytes / writes : 0);
+    Console.print(" B each, ");
+    Console.print((now.write_us - before.write_us) / 1000);
+    Console.print(" ms in Serial.write), ");
+    Console.print(elapsed_us > 0 ? (unsigned long)((uint64_t)bytes * 1000000ULL / elapsed_us) : 0);
+    Console.println(" B/s");
+}
@@ -0,0 +1,43 @@
+#include "core1_worker.h"
+#include "console_out.h"
+#include <atomic>
+
+// Job handoff: core 0 publishes arg then job (release), core 1 clears job
+// after running it (release) so core 0 sees the job's writes (acquire).
+static std::atomic<Core1Job> pending_job(nullptr);
+static void* pending_arg = nullptr;
+
+bool core1Submit(Core1Job job, void* arg) {
+    if (core1Busy()) {
+        return false;
+    }
+    
+    // Core 0's buffered text goes out before the job can print its own
+    Console.flush();
+    
+    pending_arg = arg;
+    pending_job.store(job, std::memory_order_release);
+    return true;
+}
+
+bool core1Busy() {
+    return pending_job.load(std::memory_order_acquire) != nullptr;
+}
+
+void core1Wait() {
+    while (core1Busy()) {
+        tight_loop_contents();
+    }
+}
+
+// arduino-pico starts core 1 when these are defined
+void setup1() {
+}
+
+void loop1() {
+    Core1Job job = pending_job.load(std::memory_order_acquire);
+    if (job) {
+        job(pending_arg);
+        pending_job.store(nullptr, std::memory_order_release);
+    }
+}
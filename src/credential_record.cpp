@@ -0,0 +1,193 @@
+#include "credential_record.h"
+#include "crc32.h"
+#include "console_out.h"
+#include <stddef.h>
+
+static uint32_t recordCRC(const CredentialRecord& rec, uint16_t length) {
+    // Header up to (not including) the crc field, then the entries
+    uint32_t crc = crc32(rec.raw, offsetof(CredentialRecordHeader, crc));
+    return crc32Update(crc, &rec.raw[sizeof(CredentialRecordHeader)], length);
+}
+
+void credentialRecordBegin(CredentialRecord& rec) {
+    memset(&rec, 0, sizeof(CredentialRecord));
+    rec.size = sizeof(CredentialRecordHeader);
+}
+
+bool credentialRecordAdd(CredentialRecord& rec, uint8_t type, const uint8_t* data, size_t len) {
+    if (rec.size + CRED_TLV_HEADER_SIZE + len > FRAM_CREDENTIALS_SIZE) {
+        Console.println("ERROR: Credential record too large");
+        return false;
+    }
+    
+    uint8_t* entry = &rec.raw[rec.size];
+    entry[0] = type;
+    entry[1] = len & 0xFF;
+    entry[2] = len >> 8;
+    memcpy(&entry[CRED_TLV_HEADER_SIZE], data, len);
+    rec.size += CRED_TLV_HEADER_SIZE + len;
+    return true;
+}
+
+bool credentialRecordFinish(CredentialRecord& rec) {
+    CredentialRecordHeader header;
+    header.magic = FRAM_MAGIC_NUMBER;
+    header.version = FRAM_DATA_VERSION_V2;
+    header.length = rec.size - sizeof(CredentialRecordHeader);
+    memcpy(rec.raw, &header, sizeof(header));
+    
+    header.crc = recordCRC(rec, header.length);
+    memcpy(rec.raw, &header, sizeof(header));
+    
+    return parseCredentialRecord(rec);
+}
+
+static bool parseV1(CredentialRecord& rec) {
+    const FRAMCredentials* v1 = (const FRAMCredentials*)rec.raw;
+    
+    memcpy(rec.device_name, v1->device_name, MAX_DEVICE_NAME_LEN);
+    rec.device_name[MAX_DEVICE_NAME_LEN] = '\0';
+    
+    rec.iv = { offsetof(FRAMCredentials, iv), sizeof(v1->iv) };
+    rec.wifi_ssid = { offsetof(FRAMCredentials, encrypted_wifi_ssid), sizeof(v1->encrypted_wifi_ssid) };
+    rec.wifi_password = { offsetof(FRAMCredentials, encrypted_wifi_password), sizeof(v1->encrypted_wifi_password) };
+    rec.admin_hash = { offsetof(FRAMCredentials, encrypted_admin_hash), sizeof(v1->encrypted_admin_hash) };
+    rec.vps_token = { offsetof(FRAMCredentials, encrypted_vps_token), sizeof(v1->encrypted_vps_token) };
+    rec.profile_name = { 0, 0 };
+    rec.kdf_salt = { 0, 0 };
+    rec.admin_hash_hex = true;
+    rec.size = CRED_V1_USED_SIZE;
+    return true;
+}
+
+static bool parseV2(CredentialRecord& rec) {
+    CredentialRecordHeader header;
+    memcpy(&header, rec.raw, sizeof(header));
+    
+    size_t end = sizeof(header) + header.length;
+    if (end > FRAM_CREDENTIALS_SIZE) {
+        return false;
+    }
+    
+    CredentialField none = { 0, 0 };
+    rec.iv = rec.wifi_ssid = rec.wifi_password = rec.admin_hash = rec.vps_token = none;
+    rec.profile_name = rec.kdf_salt = none;
+    rec.device_name[0] = '\0';
+    rec.admin_hash_hex = false;
+    
+    for (size_t pos = sizeof(header); pos < end; ) {
+        if (pos + CRED_TLV_HEADER_SIZE > end) {
+            return false;
+        }
+        
+        uint8_t type = rec.raw[pos];
+        uint16_t len = rec.raw[pos + 1] | (rec.raw[pos + 2] << 8);
+        CredentialField field = { (uint16_t)(pos + CRED_TLV_HEADER_SIZE), len };
+        pos += CRED_TLV_HEADER_SIZE + len;
+        
+        if (pos > end) {
+            return false;
+        }
+        
+        switch (type) {
+            case CRED_TLV_DEVICE_NAME:
+                if (len > MAX_DEVICE_NAME_LEN) return false;
+                memcpy(rec.device_name, credentialField(rec, field), len);
+                rec.device_name[len] = '\0';
+                break;
+            case CRED_TLV_IV:             rec.iv = field; break;
+            case CRED_TLV_WIFI_SSID:      rec.wifi_ssid = field; break;
+            case CRED_TLV_WIFI_PASSWORD:  rec.wifi_password = field; break;
+            case CRED_TLV_ADMIN_HASH:     rec.admin_hash = field; break;
+            case CRED_TLV_VPS_TOKEN:      rec.vps_token = field; break;
+            case CRED_TLV_PROFILE_NAME:   rec.profile_name = field; break;
+            case CRED_TLV_KDF_SALT:
+                if (len != CRED_KDF_SALT_SIZE) return false;
+                rec.kdf_salt = field;
+                break;
+            default:                      break;    // Unknown entries are skipped
+        }
+    }
+    
+    // Every ciphertext must be whole AES blocks
+    const CredentialField* ciphertexts[] = { &rec.wifi_ssid, &rec.wifi_password,
+                                             &rec.admin_hash, &rec.vps_token };
+    for (const CredentialField* field : ciphertexts) {
+        if (field->len == 0 || field->len % AES_BLOCK_SIZE != 0) {
+            return false;
+        }
+    }
+    
+    rec.size = end;
+    return rec.device_name[0] != '\0' && rec.iv.len == AES_IV_SIZE;
+}
+
+bool parseCredentialRecord(CredentialRecord& rec) {
+    CredentialRecordHeader header;
+    memcpy(&header, rec.raw, sizeof(header));
+    
+    bool ok = false;
+    if (header.magic == FRAM_MAGIC_NUMBER) {
+        if (header.version == FRAM_DATA_VERSION) {
+            ok = parseV1(rec);
+        } else if (header.version == FRAM_DATA_VERSION_V2) {
+            ok = parseV2(rec);
+        }
+    }
+    
+    rec.version = ok ? header.version : 0;
+    return ok;
+}
+
+size_t credentialRecordReadSize(const CredentialRecordHeader& header) {
+    size_t size = sizeof(header);
+    if (header.magic == FRAM_MAGIC_NUMBER) {
+        if (header.version == FRAM_DATA_VERSION) {
+            size = CRED_V1_USED_SIZE;
+        } else if (header.version == FRAM_DATA_VERSION_V2) {
+            size += min((size_t)header.length, FRAM_CREDENTIALS_SIZE - sizeof(header));
+        }
+    }
+    return size;
+}
+
+uint16_t calculateChecksum(const uint8_t* data, size_t size) {
+    uint16_t sum = 0;
+    for (size_t i = 0; i < size; i++) {
+        sum += data[i];
+    }
+    return sum;
+}
+
+bool checkCredentialRecord(const CredentialRecord& rec, uint32_t* stored, uint32_t* computed) {
+    if (rec.version == FRAM_DATA_VERSION) {
+        const FRAMCredentials* v1 = (const FRAMCredentials*)rec.raw;
+        *stored = v1->checksum;
+        *computed = calculateChecksum(rec.raw, offsetof(FRAMCredentials, checksum));
+    } else if (rec.version == FRAM_DATA_VERSION_V2) {
+        CredentialRecordHeader header;
+        memcpy(&header, rec.raw, sizeof(header));
+        *stored = header.crc;
+        *computed = recordCRC(rec, header.length);
+    } else {
+        *stored = 0;
+        *computed = 1;
+        return false;
+    }
+    
+    return *stored == *computed;
+}
+
+bool updateCredentialRecordCheck(CredentialRecord& rec) {
+    if (rec.version == FRAM_DATA_VERSION) {
+        uint16_t checksum = calculateChecksum(rec.raw, offsetof(FRAMCredentials, checksum));
+        memcpy(&rec.raw[offsetof(FRAMCredentials, checksum)], &checksum, sizeof(checksum));
+        return true;
+    }
+    
+    if (rec.version == FRAM_DATA_VERSION_V2) {
+        return credentialRecordFinish(rec);     // Also picks up entries appended since
+    }
+    
+    return false;
+}
\ No newline at end of file
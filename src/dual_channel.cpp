@@ -0,0 +1,141 @@
+#include "dual_channel.h"
+#include "fram_scrub.h"
+#include "console_out.h"
+#include <Wire.h>
+#include <Adafruit_FRAM_I2C.h>
+
+// Channel 1 has its own driver instance; channel 0 reuses the global one
+static Adafruit_FRAM_I2C channel1_fram;
+static const FRAMDevice channel_devices[DUAL_CHANNEL_COUNT] = {
+    { &fram, &Wire, FRAM_I2C_ADDR },
+    { &channel1_fram, &Wire1, FRAM_I2C_ADDR }
+};
+
+// A channel's chip on its I2C bus
+class I2CFramBus : public FramBus {
+public:
+    explicit I2CFramBus(const FRAMDevice& dev) : dev_(dev) {}
+    
+    bool begin() override {
+        return detectFRAM(dev_) && dev_.fram->begin(dev_.i2c_addr, dev_.wire);
+    }
+    
+    bool read(uint16_t addr, uint8_t* data, size_t len) override {
+        return dev_.fram->read(addr, data, len);
+    }
+    
+    bool write(uint16_t addr, const uint8_t* data, size_t len) override {
+        if (dev_.fram == &fram) {
+            scrubNoteWrite(addr, len);
+        }
+        return dev_.fram->write(addr, (uint8_t*)data, len);
+    }
+    
+private:
+    const FRAMDevice& dev_;
+};
+
+static I2CFramBus channel_buses[DUAL_CHANNEL_COUNT] = {
+    I2CFramBus(channel_devices[0]),
+    I2CFramBus(channel_devices[1])
+};
+
+// Full images captured by DUAL_BACKUP, streamed afterwards from core 0
+static uint8_t backup_images[DUAL_CHANNEL_COUNT][FRAM_SIZE];
+
+// One staging record per channel
+static CredentialRecord channel_records[DUAL_CHANNEL_COUNT];
+
+static bool dual_initialized = false;
+
+bool initDualChannel() {
+    if (dual_initialized) {
+        return true;
+    }
+    
+    Wire1.setSDA(SDA1_PIN);
+    Wire1.setSCL(SCL1_PIN);
+    Wire1.begin();
+    Wire1.setClock(FRAM_I2C_CLOCK); // Same bus speed as Wire
+    
+    dual_initialized = true;
+    return true;
+}
+
+const FRAMDevice& getChannelDevice(uint8_t channel) {
+    return channel_devices[channel];
+}
+
+unsigned long runDualChannel(DualOperation op, const DeviceCredentials* records,
+                             ChannelResult* results) {
+    ChannelJob jobs[DUAL_CHANNEL_COUNT];
+    for (uint8_t ch = 0; ch < DUAL_CHANNEL_COUNT; ch++) {
+        jobs[ch].bus = &channel_buses[ch];
+        jobs[ch].op = op;
+        jobs[ch].record = records ? &records[ch] : nullptr;
+        jobs[ch].staging = &channel_records[ch];
+        jobs[ch].image = backup_images[ch];
+        jobs[ch].result = &results[ch];
+    }
+    
+    return runChannelPair(jobs);
+}
+
+void printDualBackup(const ChannelResult* results) {
+    for (uint8_t ch = 0; ch < DUAL_CHANNEL_COUNT; ch++) {
+        if (!results[ch].ok) {
+            continue;
+        }
+        
+        Console.print("CHANNEL:");
+        Console.println(ch);
+        Console.println("BACKUP_START");
+        Console.print("SIZE:");
+        Console.println(FRAM_SIZE);
+        
+        for (size_t addr = 0; addr < FRAM_SIZE; addr += 64) {
+            printBackupChunk(addr, &backup_images[ch][addr], 64);
+        }
+        
+        Console.println("BACKUP_END");
+    }
+}
+
+void printDualReport(DualOperation op, const ChannelResult* results, unsigned long wall_us) {
+    static const char* op_names[] = { "program", "backup", "verify" };
+    static const char* bus_names[] = { "Wire ", "Wire1" };
+    
+    unsigned long sum_us = 0;
+    
+    Console.println();
+    Console.print("=== DUAL CHANNEL REPORT (");
+    Console.print(op_names[op]);
+    Console.println(") ===");
+    Console.println("  Ch  Bus    Core  Result   Time       Detail");
+    
+    for (uint8_t ch = 0; ch < DUAL_CHANNEL_COUNT; ch++) {
+        const ChannelResult& r = results[ch];
+        char line[96];
+        char detail[24] = "";
+        
+        if (op == DUAL_BACKUP && r.ok) {
+            snprintf(detail, sizeof(detail), "CRC32 %08lX", (unsigned long)r.crc);
+        }
+        
+        snprintf(line, sizeof(line), "  %u   %s  %u     %-7s  %6lu ms  %s",
+                 (unsigned)ch, bus_names[ch], (unsigned)ch,
+                 !r.present ? "NO CHIP" : r.ok ? "PASS" : "FAIL",
+                 r.elapsed_us / 1000, detail);
+        Console.println(line);
+        
+        sum_us += r.elapsed_us;
+    }
+    
+    Console.print("Wall time: ");
+    Console.print(wall_us / 1000);
+    Console.print(" ms (channels total ");
+    Console.print(sum_us / 1000);
+    Console.print(" ms, speedup ");
+    Console.print(wall_us > 0 ? (double)sum_us / wall_us : 0.0, 2);
+    Console.println("x)");
+}
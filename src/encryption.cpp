@@ -1,31 +1,33 @@
 #include "encryption.h"
 #include "sha256.h"
 #include "aes.h"
+#include "hex_codec.h"
+#include "console_out.h"
+#include "logging.h"
 #include <stddef.h>
+#include <pico/rand.h>
 
-// AES-256-CBC instance
-AES256_CBC aes_cbc;
-
-bool generateEncryptionKey(const String& device_name, uint8_t* key) {
-    // Create key material: device_name + salt + seed
-    String key_material = device_name + ENCRYPTION_SALT + ENCRYPTION_SEED;
-    
-    // Hash to create 256-bit key
-    return sha256Hash(key_material, key);
+bool generateEncryptionKey(const char* device_name, size_t name_len, uint8_t* key,
+                           const uint8_t* kdf_salt, size_t kdf_salt_len) {
+    // Key material: device_name + salt + seed [+ per-record salt], hashed
+    // piece by piece so it is never assembled in one buffer
+    SHA256 sha;
+    sha.update((const uint8_t*)device_name, name_len);
+    sha.update((const uint8_t*)ENCRYPTION_SALT, strlen(ENCRYPTION_SALT));
+    sha.update((const uint8_t*)ENCRYPTION_SEED, strlen(ENCRYPTION_SEED));
+    if (kdf_salt) {
+        sha.update(kdf_salt, kdf_salt_len);
+    }
+    sha.final(key);
+    return true;
 }
 
 bool generateRandomIV(uint8_t* iv) {
-    // Generate random IV using built-in random functions
-    randomSeed(millis() ^ analogRead(A0));
-    
-    for (int i = 0; i < AES_IV_SIZE; i++) {
-        iv[i] = random(0, 256);
-    }
-    
-    // Add more entropy
-    for (int i = 0; i < AES_IV_SIZE; i++) {
-        iv[i] ^= (micros() & 0xFF);
-        delay(1);
+    // pico_rand: seeded from the RP2350 TRNG and safe to call from both cores
+    // at once (dual mode encrypts on core 0 and core 1 concurrently)
+    for (int i = 0; i < AES_IV_SIZE; i += sizeof(uint32_t)) {
+        uint32_t word = get_rand_32();
+        memcpy(&iv[i], &word, sizeof(word));
     }
     
     return true;
@@ -43,22 +45,19 @@ bool encryptData(const uint8_t* plaintext, size_t plaintext_len,
         padded_len += AES_BLOCK_SIZE;
     }
     
-    Serial.print("DEBUG encryptData: plaintext_len=");
-    Serial.print(plaintext_len);
-    Serial.print(", padded_len=");
-    Serial.print(padded_len);
-    Serial.print(", field_size=");
-    Serial.println(*ciphertext_len);
+    LOG_D("encryptData: plaintext_len=%u, padded_len=%u, field_size=%u",
+          (unsigned)plaintext_len, (unsigned)padded_len, (unsigned)*ciphertext_len);
     
     if (padded_len > *ciphertext_len) {
-        Serial.println("ERROR encryptData: Padded data larger than field size!");
+        Console.println("ERROR encryptData: Padded data larger than field size!");
         return false;
     }
     
-    // Create padded buffer
-    uint8_t* padded_data = new uint8_t[*ciphertext_len];
-    if (!padded_data) {
-        return false; // Memory allocation failed
+    // Padded copy on the stack; no field is larger than the token's
+    uint8_t padded_data[CRED_CIPHER_SIZE(MAX_VPS_TOKEN_LEN)];
+    if (*ciphertext_len > sizeof(padded_data)) {
+        Console.println("ERROR encryptData: Field larger than the largest credential");
+        return false;
     }
     
     // Initialize entire buffer with zeros
@@ -66,12 +65,10 @@ bool encryptData(const uint8_t* plaintext, size_t plaintext_len,
     
     // Copy data and add PKCS7 padding
     memcpy(padded_data, plaintext, plaintext_len);
-    size_t actual_padded_len = addPKCS7Padding(padded_data, plaintext_len, AES_BLOCK_SIZE);
-    
-    Serial.print("DEBUG encryptData: actual_padded_len=");
-    Serial.println(actual_padded_len);
+    addPKCS7Padding(padded_data, plaintext_len, AES_BLOCK_SIZE);
     
-    // Set up AES-256-CBC
+    // Set up AES-256-CBC (per call, so both cores can encrypt concurrently)
+    AES256_CBC aes_cbc;
     aes_cbc.set_key(key);
     
     // Extend 8-byte IV to 16-byte IV for AES
@@ -82,26 +79,24 @@ bool encryptData(const uint8_t* plaintext, size_t plaintext_len,
     aes_cbc.set_iv(full_iv);
     
     // Encrypt the entire field (including any zeros at the end)
-    if (!aes_cbc.encrypt(padded_data, *ciphertext_len, ciphertext)) {
-        delete[] padded_data;
-        return false;
-    }
+    bool ok = aes_cbc.encrypt(padded_data, *ciphertext_len, ciphertext);
     
     // ciphertext_len stays the same (full field size)
     
-    delete[] padded_data;
-    return true;
+    memset(padded_data, 0, sizeof(padded_data));
+    return ok;
 }
 
 bool decryptData(const uint8_t* ciphertext, size_t ciphertext_len,
                  const uint8_t* key, const uint8_t* iv,
-                 uint8_t* plaintext, size_t* plaintext_len) {
+                 uint8_t* plaintext, size_t* plaintext_len, bool exact_length) {
     
     if (ciphertext_len % AES_BLOCK_SIZE != 0) {
         return false;
     }
     
-    // Set up AES-256-CBC
+    // Set up AES-256-CBC (per call, so both cores can decrypt concurrently)
+    AES256_CBC aes_cbc;
     aes_cbc.set_key(key);
     
     // Extend 8-byte IV to 16-byte IV for AES
@@ -116,24 +111,20 @@ bool decryptData(const uint8_t* ciphertext, size_t ciphertext_len,
         return false;
     }
     
-    // Debug: Show decrypted blocks for larger ciphertext
+    // Decrypted blocks of larger fields (plaintext: verbose only)
     if (ciphertext_len > 64) {
-        Serial.print("DEBUG decryptData: Showing decrypted blocks for ");
-        Serial.print(ciphertext_len);
-        Serial.println(" byte field:");
-        
-        size_t blocks_to_show = min((size_t)6, ciphertext_len / 16);
-        for (size_t block = 0; block < blocks_to_show; block++) {
-            Serial.print("  Block ");
-            Serial.print(block);
-            Serial.print(": ");
-            for (int i = 0; i < 16; i++) {
-                if (plaintext[block * 16 + i] < 16) Serial.print("0");
-                Serial.print(plaintext[block * 16 + i], HEX);
-                Serial.print(" ");
-            }
-            Serial.println();
+        LOG_HEX_V("decryptData: first blocks of the field:", plaintext, min((size_t)96, ciphertext_len));
+    }
+    
+    // Exact-length ciphertext (v2 records): the padding must end the last block
+    if (exact_length) {
+        size_t unpadded_len = removePKCS7Padding(plaintext, ciphertext_len);
+        if (unpadded_len == 0) {
+            LOG_D("decryptData: Invalid PKCS7 padding");
+            return false;
         }
+        *plaintext_len = unpadded_len;
+        return true;
     }
     
     // New approach: Try to find valid PKCS7 padding by looking for non-zero data
@@ -146,16 +137,14 @@ bool decryptData(const uint8_t* ciphertext, size_t ciphertext_len,
         size_t unpadded_len = removePKCS7Padding(plaintext, try_len);
         if (unpadded_len > 0) {
             actual_data_len = unpadded_len;
-            Serial.print("DEBUG decryptData: Found valid padding at length ");
-            Serial.print(try_len);
-            Serial.print(", unpadded length = ");
-            Serial.println(actual_data_len);
+            LOG_D("decryptData: Found valid padding at length %u, unpadded length = %u",
+                  (unsigned)try_len, (unsigned)actual_data_len);
             break;
         }
     }
     
     if (actual_data_len == 0) {
-        Serial.println("DEBUG decryptData: No valid PKCS7 padding found");
+        LOG_D("decryptData: No valid PKCS7 padding found");
         return false;
     }
     
@@ -163,10 +152,6 @@ bool decryptData(const uint8_t* ciphertext, size_t ciphertext_len,
     return true;
 }
 
-bool sha256Hash(const String& input, uint8_t* hash) {
-    return sha256Hash((const uint8_t*)input.c_str(), input.length(), hash);
-}
-
 bool sha256Hash(const uint8_t* data, size_t len, uint8_t* hash) {
     sha256_hash(data, len, hash);
     return true;
@@ -181,11 +166,6 @@ size_t addPKCS7Padding(uint8_t* data, size_t data_len, size_t block_size) {
         padding_bytes = block_size;
     }
     
-    Serial.print("DEBUG addPKCS7Padding: data_len=");
-    Serial.print(data_len);
-    Serial.print(", padding_bytes=");
-    Serial.println(padding_bytes);
-    
     for (size_t i = 0; i < padding_bytes; i++) {
         data[data_len + i] = (uint8_t)padding_bytes;
     }
@@ -217,228 +197,494 @@ size_t removePKCS7Padding(const uint8_t* data, size_t data_len) {
     return data_len - padding_bytes;
 }
 
-bool encryptCredentials(const DeviceCredentials& creds, FRAMCredentials& fram_creds) {
-    Serial.println("Encrypting credentials...");
+// Encrypt one field into a v2 entry, sized to exactly the padded plaintext
+static bool addEncryptedEntry(CredentialRecord& rec, uint8_t type,
+                              const uint8_t* plaintext, size_t plaintext_len,
+                              const uint8_t* key, const uint8_t* iv) {
+    uint8_t ciphertext[CRED_CIPHER_SIZE(MAX_VPS_TOKEN_LEN)];
+    size_t ciphertext_len = CRED_CIPHER_SIZE(plaintext_len);
+    
+    if (ciphertext_len > sizeof(ciphertext) ||
+        !encryptData(plaintext, plaintext_len, key, iv, ciphertext, &ciphertext_len)) {
+        return false;
+    }
     
-    // Clear the structure
-    memset(&fram_creds, 0, sizeof(FRAMCredentials));
+    return credentialRecordAdd(rec, type, ciphertext, ciphertext_len);
+}
+
+// Build a v2 record from plaintext fields, a raw admin hash and a chosen IV
+static bool buildCredentialRecord(const DeviceCredentials& creds, const uint8_t* admin_hash,
+                                  const uint8_t* iv, CredentialRecord& rec) {
+    // Generate encryption key from device name
+    uint8_t encryption_key[AES_KEY_SIZE];
+    if (!generateEncryptionKey(creds.device_name.c_str(), creds.device_name.length(), encryption_key)) {
+        Console.println("ERROR: Failed to generate encryption key");
+        return false;
+    }
     
-    // Set magic and version
-    fram_creds.magic = FRAM_MAGIC_NUMBER;
-    fram_creds.version = FRAM_DATA_VERSION;
+    credentialRecordBegin(rec);
     
-    // Copy device name (plain text)
-    strncpy(fram_creds.device_name, creds.device_name.c_str(), 31);
-    fram_creds.device_name[31] = '\0';
+    // Device name and IV are stored in plain text
+    if (!credentialRecordAdd(rec, CRED_TLV_DEVICE_NAME, (const uint8_t*)creds.device_name.c_str(),
+                             creds.device_name.length()) ||
+        !credentialRecordAdd(rec, CRED_TLV_IV, iv, AES_IV_SIZE)) {
+        return false;
+    }
     
-    // Generate encryption key from device name
-    uint8_t encryption_key[AES_KEY_SIZE];
-    if (!generateEncryptionKey(creds.device_name, encryption_key)) {
-        Serial.println("ERROR: Failed to generate encryption key");
+    if (!addEncryptedEntry(rec, CRED_TLV_WIFI_SSID,
+                           (const uint8_t*)creds.wifi_ssid.c_str(), creds.wifi_ssid.length(),
+                           encryption_key, iv)) {
+        Console.println("ERROR: Failed to encrypt WiFi SSID");
         return false;
     }
     
-    // Generate random IV
-    if (!generateRandomIV(fram_creds.iv)) {
-        Serial.println("ERROR: Failed to generate IV");
+    if (!addEncryptedEntry(rec, CRED_TLV_WIFI_PASSWORD,
+                           (const uint8_t*)creds.wifi_password.c_str(), creds.wifi_password.length(),
+                           encryption_key, iv)) {
+        Console.println("ERROR: Failed to encrypt WiFi password");
         return false;
     }
     
-    // Hash admin password
-    String admin_password = creds.admin_password;
-    uint8_t admin_hash[SHA256_HASH_SIZE];
-    if (!sha256Hash(admin_password, admin_hash)) {
-        Serial.println("ERROR: Failed to hash admin password");
+    if (!addEncryptedEntry(rec, CRED_TLV_ADMIN_HASH, admin_hash, SHA256_HASH_SIZE,
+                           encryption_key, iv)) {
+        Console.println("ERROR: Failed to encrypt admin hash");
+        return false;
+    }
+    
+    if (!addEncryptedEntry(rec, CRED_TLV_VPS_TOKEN,
+                           (const uint8_t*)creds.vps_token.c_str(), creds.vps_token.length(),
+                           encryption_key, iv)) {
+        Console.println("ERROR: Failed to encrypt VPS token");
         return false;
     }
     
-    // Convert hash to hex string
-    String admin_hash_hex = "";
-    for (int i = 0; i < SHA256_HASH_SIZE; i++) {
-        if (admin_hash[i] < 16) admin_hash_hex += "0";
-        admin_hash_hex += String(admin_hash[i], HEX);
+    if (!credentialRecordFinish(rec)) {
+        Console.println("ERROR: Failed to finalize credential record");
+        return false;
     }
     
-    Serial.print("DEBUG: Admin hash hex string: '");
-    Serial.print(admin_hash_hex);
-    Serial.println("'");
-    Serial.print("DEBUG: Admin hash hex length: ");
-    Serial.println(admin_hash_hex.length());
+    LOG_D("Credential record v2, %u bytes", (unsigned)rec.size);
+    return true;
+}
+
+bool encryptCredentials(const DeviceCredentials& creds, CredentialRecord& rec) {
+    LOG_I("Encrypting credentials...");
     
-    // Encrypt WiFi SSID
-    size_t ciphertext_len = 64;
-    if (!encryptData((const uint8_t*)creds.wifi_ssid.c_str(), creds.wifi_ssid.length(),
-                     encryption_key, fram_creds.iv,
-                     fram_creds.encrypted_wifi_ssid, &ciphertext_len)) {
-        Serial.println("ERROR: Failed to encrypt WiFi SSID");
+    // Generate random IV
+    uint8_t iv[AES_IV_SIZE];
+    if (!generateRandomIV(iv)) {
+        Console.println("ERROR: Failed to generate IV");
         return false;
     }
     
-    // Encrypt WiFi password
-    ciphertext_len = 128;
-    if (!encryptData((const uint8_t*)creds.wifi_password.c_str(), creds.wifi_password.length(),
-                     encryption_key, fram_creds.iv,
-                     fram_creds.encrypted_wifi_password, &ciphertext_len)) {
-        Serial.println("ERROR: Failed to encrypt WiFi password");
+    // Hash admin password (v2 stores the raw digest)
+    uint8_t admin_hash[SHA256_HASH_SIZE];
+    if (!sha256Hash((const uint8_t*)creds.admin_password.c_str(), creds.admin_password.length(), admin_hash)) {
+        Console.println("ERROR: Failed to hash admin password");
         return false;
     }
     
-    // Encrypt admin hash
-    ciphertext_len = 96;
-    if (!encryptData((const uint8_t*)admin_hash_hex.c_str(), admin_hash_hex.length(),
-                     encryption_key, fram_creds.iv,
-                     fram_creds.encrypted_admin_hash, &ciphertext_len)) {
-        Serial.println("ERROR: Failed to encrypt admin hash");
+    if (!buildCredentialRecord(creds, admin_hash, iv, rec)) {
         return false;
     }
     
-    // Encrypt VPS token
-    ciphertext_len = 160;
-    if (!encryptData((const uint8_t*)creds.vps_token.c_str(), creds.vps_token.length(),
-                     encryption_key, fram_creds.iv,
-                     fram_creds.encrypted_vps_token, &ciphertext_len)) {
-        Serial.println("ERROR: Failed to encrypt VPS token");
+    LOG_I("SUCCESS: Credentials encrypted");
+    return true;
+}
+
+// Expand the stored 8-byte IV to the 16-byte CBC IV
+static void expandIV(const uint8_t* iv, uint8_t* full_iv) {
+    for (int i = 0; i < AES_BLOCK_SIZE; i++) {
+        full_iv[i] = iv[i % AES_IV_SIZE];
+    }
+}
+
+// Length of the PKCS7 padding that ends this block, 0 if there is none
+static size_t blockPadding(const uint8_t* block) {
+    uint8_t padding_bytes = block[AES_BLOCK_SIZE - 1];
+    if (padding_bytes == 0 || padding_bytes > AES_BLOCK_SIZE) {
+        return 0;
+    }
+    
+    for (size_t i = AES_BLOCK_SIZE - padding_bytes; i < AES_BLOCK_SIZE; i++) {
+        if (block[i] != padding_bytes) {
+            return 0;
+        }
+    }
+    return padding_bytes;
+}
+
+static const CredentialField* credentialFieldById(const CredentialRecord& rec, CredentialFieldId id) {
+    switch (id) {
+        case CRED_FIELD_WIFI_SSID:      return &rec.wifi_ssid;
+        case CRED_FIELD_WIFI_PASSWORD:  return &rec.wifi_password;
+        case CRED_FIELD_ADMIN_HASH:     return &rec.admin_hash;
+        case CRED_FIELD_VPS_TOKEN:      return &rec.vps_token;
+    }
+    return nullptr;
+}
+
+bool credentialKey(const CredentialRecord& rec, uint8_t* key) {
+    if (rec.version == 0) {
+        return false;
+    }
+    size_t name_len = strlen(rec.device_name);
+    if (rec.kdf_salt.len > 0) {
+        return generateEncryptionKey(rec.device_name, name_len, key,
+                                     credentialField(rec, rec.kdf_salt), rec.kdf_salt.len);
+    }
+    return generateEncryptionKey(rec.device_name, name_len, key);
+}
+
+bool decryptCredentialField(const CredentialRecord& rec, const uint8_t* key, CredentialFieldId id,
+                            uint8_t* out, size_t* out_len) {
+    const CredentialField* field = credentialFieldById(rec, id);
+    if (rec.version == 0 || !field || field->len == 0 || field->len % AES_BLOCK_SIZE != 0) {
+        return false;
+    }
+    
+    const uint8_t* ciphertext = credentialField(rec, *field);
+    bool exact_length = rec.version == FRAM_DATA_VERSION_V2;
+    
+    AES256 aes;
+    aes.set_key(key);
+    uint8_t chain[AES_BLOCK_SIZE];
+    expandIV(credentialField(rec, rec.iv), chain);
+    
+    // CBC one block at a time. Padding is stripped before a block is copied out,
+    // so the caller only needs room for the plaintext itself
+    size_t capacity = *out_len;
+    size_t written = 0;
+    for (size_t offset = 0; offset < field->len; offset += AES_BLOCK_SIZE) {
+        uint8_t block[AES_BLOCK_SIZE];
+        aes.decrypt_block(&ciphertext[offset], block);
+        for (int j = 0; j < AES_BLOCK_SIZE; j++) {
+            block[j] ^= chain[j];
+        }
+        memcpy(chain, &ciphertext[offset], AES_BLOCK_SIZE);
+        
+        // v2: the padding ends the field. v1: it ends the first block where it is
+        // valid, and the blocks after it are encrypted zeros that are never read
+        bool last = offset + AES_BLOCK_SIZE == field->len;
+        size_t padding = (last || !exact_length) ? blockPadding(block) : 0;
+        if (offset + AES_BLOCK_SIZE == padding) {
+            padding = 0;                        // Empty plaintext is never valid
+        }
+        if (exact_length && last && padding == 0) {
+            return false;
+        }
+        
+        size_t data_len = AES_BLOCK_SIZE - padding;
+        if (written + data_len > capacity) {
+            return false;
+        }
+        memcpy(&out[written], block, data_len);
+        written += data_len;
+        
+        if (padding > 0) {
+            *out_len = written;
+            return true;
+        }
+    }
+    
+    return false;   // v1 field without valid padding
+}
+
+bool fastVerifyCredentials(const CredentialRecord& rec) {
+    // The admin hash has a fixed length (v1: 64 hex characters, v2: the 32-byte digest),
+    // so the block after it is all padding: sixteen 0x10 bytes. For v2 that is the last
+    // block of the field. Decrypting it alone checks the key on 128 bits instead of the
+    // one padding byte a variable-length field would usually give
+    const CredentialField& field = rec.admin_hash;
+    size_t offset = rec.admin_hash_hex ? SHA256_HASH_SIZE * 2 : SHA256_HASH_SIZE;
+    if (rec.version == 0 || field.len < offset + AES_BLOCK_SIZE) {
+        return false;
+    }
+    if (rec.version == FRAM_DATA_VERSION_V2 && field.len != offset + AES_BLOCK_SIZE) {
         return false;
     }
     
-    // Calculate checksum (only bytes before checksum field: 0-495)
-    size_t checksum_offset = offsetof(FRAMCredentials, checksum);
-    uint16_t temp_checksum = calculateChecksum((uint8_t*)&fram_creds, checksum_offset);
-    fram_creds.checksum = temp_checksum;
+    uint8_t key[AES_KEY_SIZE];
+    if (!credentialKey(rec, key)) {
+        return false;
+    }
     
-    Serial.print("DEBUG: Calculated checksum during encryption = ");
-    Serial.println(fram_creds.checksum);
-    Serial.print("DEBUG: Checksum calculated over ");
-    Serial.print(checksum_offset);
-    Serial.println(" bytes (before checksum field)");
+    AES256 aes;
+    aes.set_key(key);
+    const uint8_t* ciphertext = credentialField(rec, field);
+    uint8_t block[AES_BLOCK_SIZE];
+    aes.decrypt_block(&ciphertext[offset], block);
     
-    Serial.println("SUCCESS: Credentials encrypted");
+    // CBC: the previous ciphertext block is this block's chaining value
+    for (int j = 0; j < AES_BLOCK_SIZE; j++) {
+        if ((block[j] ^ ciphertext[offset - AES_BLOCK_SIZE + j]) != AES_BLOCK_SIZE) {
+            return false;
+        }
+    }
     return true;
 }
 
-bool decryptCredentials(const FRAMCredentials& fram_creds, DeviceCredentials& creds) {
-    Serial.println("Decrypting credentials...");
+bool decryptCredentials(const CredentialRecord& rec, DeviceCredentials& creds) {
+    LOG_I("Decrypting credentials...");
+    
+    if (rec.version == 0) {
+        Console.println("ERROR: No valid credential record");
+        return false;
+    }
     
     // Generate encryption key from device name
     uint8_t encryption_key[AES_KEY_SIZE];
-    String device_name = String(fram_creds.device_name);
-    Serial.print("DEBUG: Device name for key generation: '");
-    Serial.print(device_name);
-    Serial.println("'");
+    LOG_D("Device name for key generation: '%s'", rec.device_name);
     
-    if (!generateEncryptionKey(device_name, encryption_key)) {
-        Serial.println("ERROR: Failed to generate encryption key");
+    if (!credentialKey(rec, encryption_key)) {
+        Console.println("ERROR: Failed to generate encryption key");
         return false;
     }
     
-    Serial.print("DEBUG: Generated key (first 8 bytes): ");
-    for (int i = 0; i < 8; i++) {
-        if (encryption_key[i] < 16) Serial.print("0");
-        Serial.print(encryption_key[i], HEX);
-    }
-    Serial.println();
-    
-    Serial.print("DEBUG: IV from FRAM: ");
-    for (int i = 0; i < AES_IV_SIZE; i++) {
-        if (fram_creds.iv[i] < 16) Serial.print("0");
-        Serial.print(fram_creds.iv[i], HEX);
-    }
-    Serial.println();
+    LOG_HEX_V("Generated key (first 8 bytes):", encryption_key, 8);
+    LOG_HEX_D("IV from FRAM:", credentialField(rec, rec.iv), AES_IV_SIZE);
     
     // Set device name
-    creds.device_name = device_name;
+    creds.device_name = rec.device_name;
     
     // Decrypt WiFi SSID
-    Serial.println("DEBUG: Attempting to decrypt WiFi SSID...");
-    uint8_t plaintext_buffer[256];
-    size_t plaintext_len = sizeof(plaintext_buffer);
+    LOG_D("Attempting to decrypt WiFi SSID...");
+    uint8_t plaintext_buffer[CRED_CIPHER_SIZE(MAX_VPS_TOKEN_LEN) + 1];
+    size_t plaintext_len = sizeof(plaintext_buffer) - 1;
     
-    if (!decryptData(fram_creds.encrypted_wifi_ssid, 64,
-                     encryption_key, fram_creds.iv,
-                     plaintext_buffer, &plaintext_len)) {
-        Serial.println("ERROR: Failed to decrypt WiFi SSID");
+    if (!decryptCredentialField(rec, encryption_key, CRED_FIELD_WIFI_SSID, plaintext_buffer, &plaintext_len)) {
+        Console.println("ERROR: Failed to decrypt WiFi SSID");
         return false;
     }
     
-    plaintext_buffer[plaintext_len] = '\0';
-    creds.wifi_ssid = String((char*)plaintext_buffer);
-    Serial.print("DEBUG: Decrypted SSID string: '");
-    Serial.print(creds.wifi_ssid);
-    Serial.println("'");
+    creds.wifi_ssid.assign((const char*)plaintext_buffer, plaintext_len);
+    LOG_V("Decrypted SSID string: '%s'", creds.wifi_ssid.c_str());
     
     // Decrypt WiFi password
-    Serial.println("DEBUG: Attempting to decrypt WiFi password...");
-    plaintext_len = sizeof(plaintext_buffer);
-    if (!decryptData(fram_creds.encrypted_wifi_password, 128,
-                     encryption_key, fram_creds.iv,
-                     plaintext_buffer, &plaintext_len)) {
-        Serial.println("ERROR: Failed to decrypt WiFi password");
-        return false;
-    }
-    plaintext_buffer[plaintext_len] = '\0';
-    creds.wifi_password = String((char*)plaintext_buffer);
-    Serial.print("DEBUG: Decrypted WiFi password string: '");
-    Serial.print(creds.wifi_password);
-    Serial.println("'");
-    
-    // Decrypt admin hash (we return the hash, not original password)
-    Serial.println("DEBUG: Attempting to decrypt admin hash...");
-    Serial.print("DEBUG: Admin hash encrypted size: 96 bytes, first 16 bytes: ");
-    for (int i = 0; i < 16; i++) {
-        if (fram_creds.encrypted_admin_hash[i] < 16) Serial.print("0");
-        Serial.print(fram_creds.encrypted_admin_hash[i], HEX);
-    }
-    Serial.println();
-    
-    plaintext_len = sizeof(plaintext_buffer);
-    if (!decryptData(fram_creds.encrypted_admin_hash, 96,
-                     encryption_key, fram_creds.iv,
-                     plaintext_buffer, &plaintext_len)) {
-        Serial.println("ERROR: Failed to decrypt admin hash");
-        Serial.println("DEBUG: Continuing with other fields...");
-        creds.admin_password = ""; // Set empty on failure
+    LOG_D("Attempting to decrypt WiFi password...");
+    plaintext_len = sizeof(plaintext_buffer) - 1;
+    if (!decryptCredentialField(rec, encryption_key, CRED_FIELD_WIFI_PASSWORD, plaintext_buffer, &plaintext_len)) {
+        Console.println("ERROR: Failed to decrypt WiFi password");
+        return false;
+    }
+    creds.wifi_password.assign((const char*)plaintext_buffer, plaintext_len);
+    LOG_V("Decrypted WiFi password string: '%s'", creds.wifi_password.c_str());
+    
+    // Decrypt admin hash (we return the hash as lowercase hex, not original password)
+    LOG_D("Attempting to decrypt admin hash (%u encrypted bytes)...", (unsigned)rec.admin_hash.len);
+    
+    plaintext_len = sizeof(plaintext_buffer) - 1;
+    if (!decryptCredentialField(rec, encryption_key, CRED_FIELD_ADMIN_HASH, plaintext_buffer, &plaintext_len)) {
+        Console.println("ERROR: Failed to decrypt admin hash");
+        LOG_D("Continuing with other fields...");
+        creds.admin_password.clear(); // Set empty on failure
     } else {
-        plaintext_buffer[plaintext_len] = '\0';
-        creds.admin_password = String((char*)plaintext_buffer); // This is actually the hash
-        Serial.print("DEBUG: Decrypted admin hash length: ");
-        Serial.println(creds.admin_password.length());
-        Serial.print("DEBUG: Admin hash (first 20 chars): ");
-        Serial.println(creds.admin_password.substring(0, 20));
+        if (rec.admin_hash_hex) {
+            creds.admin_password.assign((const char*)plaintext_buffer, plaintext_len); // This is actually the hash
+        } else {
+            // Same lowercase text form v1 stored
+            char hash_hex[SHA256_HASH_SIZE * 2 + 1];
+            size_t hex_len = hexEncode(plaintext_buffer, min(plaintext_len, (size_t)SHA256_HASH_SIZE), hash_hex);
+            for (size_t i = 0; i < hex_len; i++) {
+                hash_hex[i] = tolower(hash_hex[i]);
+            }
+            creds.admin_password.assign(hash_hex, hex_len);
+        }
+        LOG_V("Admin hash: %u chars, '%.20s'", (unsigned)creds.admin_password.length(),
+              creds.admin_password.c_str());
     }
     
     // Decrypt VPS token
-    Serial.println("DEBUG: Attempting to decrypt VPS token...");
-    plaintext_len = sizeof(plaintext_buffer);
-    if (!decryptData(fram_creds.encrypted_vps_token, 160,
-                     encryption_key, fram_creds.iv,
-                     plaintext_buffer, &plaintext_len)) {
-        Serial.println("ERROR: Failed to decrypt VPS token");
-        creds.vps_token = ""; // Set empty on failure
+    LOG_D("Attempting to decrypt VPS token...");
+    plaintext_len = sizeof(plaintext_buffer) - 1;
+    if (!decryptCredentialField(rec, encryption_key, CRED_FIELD_VPS_TOKEN, plaintext_buffer, &plaintext_len)) {
+        Console.println("ERROR: Failed to decrypt VPS token");
+        creds.vps_token.clear(); // Set empty on failure
     } else {
-        plaintext_buffer[plaintext_len] = '\0';
-        creds.vps_token = String((char*)plaintext_buffer);
-        Serial.print("DEBUG: Decrypted VPS token string: '");
-        Serial.print(creds.vps_token);
-        Serial.println("'");
+        creds.vps_token.assign((const char*)plaintext_buffer, plaintext_len);
+        LOG_V("Decrypted VPS token string: '%s'", creds.vps_token.c_str());
+    }
+    
+    LOG_I("SUCCESS: Credential decryption completed");
+    return true;
+}
+
+bool migrateCredentials(const CredentialRecord& v1, CredentialRecord& v2) {
+    Console.println("Migrating credentials to v2...");
+    
+    if (v1.version != FRAM_DATA_VERSION) {
+        Console.println("ERROR: Source is not a v1 credential record");
+        return false;
+    }
+    
+    DeviceCredentials creds;
+    if (!decryptCredentials(v1, creds)) {
+        return false;
+    }
+    
+    // v1 holds the admin hash as hex text; v2 stores the digest itself
+    uint8_t admin_hash[SHA256_HASH_SIZE];
+    size_t hash_len = 0;
+    if (!hexDecode(creds.admin_password.c_str(), creds.admin_password.length(),
+                   admin_hash, sizeof(admin_hash), &hash_len, nullptr) ||
+        hash_len != SHA256_HASH_SIZE) {
+        Console.println("ERROR: v1 admin hash is not a 64-character hex digest");
+        return false;
+    }
+    
+    // Keep the IV so the migrated record encrypts the same secrets the same way
+    if (!buildCredentialRecord(creds, admin_hash, credentialField(v1, v1.iv), v2)) {
+        return false;
+    }
+    
+    // Prove the new record decrypts to what the old one held before it is written
+    DeviceCredentials check;
+    if (!decryptCredentials(v2, check) ||
+        check.device_name != creds.device_name ||
+        check.wifi_ssid != creds.wifi_ssid ||
+        check.wifi_password != creds.wifi_password ||
+        check.admin_password != creds.admin_password ||
+        check.vps_token != creds.vps_token) {
+        Console.println("ERROR: Migrated record does not decrypt to the original credentials");
+        return false;
+    }
+    
+    Console.println("SUCCESS: Credentials migrated");
+    return true;
+}
+
+// Re-encrypt one field in place: each block is decrypted with the old key and
+// chain and encrypted again with the new ones, so only 16 bytes of plaintext
+// exist at a time. The whole field is processed, including v1's zero tail
+static void rekeyField(CredentialRecord& rec, const CredentialField& field,
+                       AES256& old_aes, const uint8_t* old_iv,
+                       AES256& new_aes, const uint8_t* new_iv) {
+    uint8_t old_chain[AES_BLOCK_SIZE];
+    uint8_t new_chain[AES_BLOCK_SIZE];
+    uint8_t block[AES_BLOCK_SIZE];
+    expandIV(old_iv, old_chain);
+    expandIV(new_iv, new_chain);
+    
+    uint8_t* ciphertext = &rec.raw[field.offset];
+    for (size_t offset = 0; offset < field.len; offset += AES_BLOCK_SIZE) {
+        uint8_t* cipher_block = &ciphertext[offset];
+        old_aes.decrypt_block(cipher_block, block);
+        for (int j = 0; j < AES_BLOCK_SIZE; j++) {
+            block[j] ^= old_chain[j] ^ new_chain[j];    // Strip the old chain, apply the new one
+        }
+        memcpy(old_chain, cipher_block, AES_BLOCK_SIZE);
+        
+        new_aes.encrypt_block(block, cipher_block);
+        memcpy(new_chain, cipher_block, AES_BLOCK_SIZE);
+    }
+    
+    memset(block, 0, sizeof(block));
+}
+
+bool rekeyCredentials(CredentialRecord& rec, bool rotate_salt) {
+    if (rec.version == 0) {
+        Console.println("ERROR: No valid credential record");
+        return false;
+    }
+    
+    if (rotate_salt && rec.version != FRAM_DATA_VERSION_V2) {
+        Console.println("ERROR: v1 records have no room for a key salt; run 'migrate' first");
+        return false;
+    }
+    
+    // Never re-encrypt what the current key cannot decrypt
+    if (!fastVerifyCredentials(rec)) {
+        Console.println("ERROR: Key check failed; record left unchanged");
+        return false;
+    }
+    
+    uint8_t old_key[AES_KEY_SIZE];
+    uint8_t new_key[AES_KEY_SIZE];
+    uint8_t old_iv[AES_IV_SIZE];
+    uint8_t new_iv[AES_IV_SIZE];
+    
+    credentialKey(rec, old_key);
+    memcpy(old_iv, credentialField(rec, rec.iv), AES_IV_SIZE);
+    if (!generateRandomIV(new_iv)) {
+        Console.println("ERROR: Failed to generate IV");
+        return false;
+    }
+    
+    if (rotate_salt) {
+        uint8_t salt[CRED_KDF_SALT_SIZE];
+        generateRandomIV(salt);     // Same entropy source, same size
+        if (rec.kdf_salt.len == CRED_KDF_SALT_SIZE) {
+            memcpy(&rec.raw[rec.kdf_salt.offset], salt, CRED_KDF_SALT_SIZE);
+        } else if (!credentialRecordAdd(rec, CRED_TLV_KDF_SALT, salt, CRED_KDF_SALT_SIZE) ||
+                   !credentialRecordFinish(rec)) {
+            return false;
+        }
+    }
+    credentialKey(rec, new_key);
+    
+    AES256 old_aes;
+    AES256 new_aes;
+    old_aes.set_key(old_key);
+    new_aes.set_key(new_key);
+    memset(old_key, 0, sizeof(old_key));
+    memset(new_key, 0, sizeof(new_key));
+    
+    const CredentialField fields[] = { rec.wifi_ssid, rec.wifi_password, rec.admin_hash, rec.vps_token };
+    for (const CredentialField& field : fields) {
+        rekeyField(rec, field, old_aes, old_iv, new_aes, new_iv);
+    }
+    memcpy(&rec.raw[rec.iv.offset], new_iv, AES_IV_SIZE);
+    
+    if (!updateCredentialRecordCheck(rec) || !fastVerifyCredentials(rec)) {
+        Console.println("ERROR: Re-keyed record failed its key check");
+        return false;
+    }
+    
+    return true;
+}
+
+bool validateCredentials(const DeviceCredentials& creds) {
+    if (!validateDeviceName(creds.device_name)) {
+        Console.println("ERROR: Invalid device name");
+        return false;
+    }
+    
+    if (!validateWiFiSSID(creds.wifi_ssid)) {
+        Console.println("ERROR: Invalid WiFi SSID");
+        return false;
+    }
+    
+    if (!validateWiFiPassword(creds.wifi_password)) {
+        Console.println("ERROR: Invalid WiFi password");
+        return false;
+    }
+    
+    if (!validateAdminPassword(creds.admin_password)) {
+        Console.println("ERROR: Invalid admin password");
+        return false;
+    }
+    
+    if (!validateVPSToken(creds.vps_token)) {
+        Console.println("ERROR: Invalid VPS token");
+        return false;
     }
     
-    Serial.println("SUCCESS: Credential decryption completed");
     return true;
 }
 
-bool validateDeviceName(const String& name) {
-    if (name.length() == 0 || name.length() > MAX_DEVICE_NAME_LEN) {
-        Serial.print("Device name length invalid (1-");
-        Serial.print(MAX_DEVICE_NAME_LEN);
-        Serial.println(" characters required)");
+bool validateDeviceName(const char* name, size_t len) {
+    if (len == 0 || len > MAX_DEVICE_NAME_LEN) {
+        Console.print("Device name length invalid (1-");
+        Console.print(MAX_DEVICE_NAME_LEN);
+        Console.println(" characters required)");
         return false;
     }
     
     // Check for valid characters (alphanumeric and underscore)
-    for (int i = 0; i < name.length(); i++) {
-        char c = name.charAt(i);
+    for (size_t i = 0; i < len; i++) {
+        char c = name[i];
         if (!isalnum(c) && c != '_') {
-            Serial.println("Device name contains invalid characters (alphanumeric and _ only)");
+            Console.println("Device name contains invalid characters (alphanumeric and _ only)");
             return false;
         }
     }
@@ -446,31 +692,47 @@ bool validateDeviceName(const String& name) {
     return true;
 }
 
-bool validateWiFiSSID(const String& ssid) {
-    if (ssid.length() == 0 || ssid.length() > MAX_WIFI_SSID_LEN) {
-        Serial.print("WiFi SSID length invalid (1-");
-        Serial.print(MAX_WIFI_SSID_LEN);
-        Serial.println(" characters required)");
+// Only the length is checked: any byte is valid in these fields, so the text
+// is taken for symmetry with validateDeviceName() and left unread
+bool validateWiFiSSID(const char* ssid, size_t len) {
+    (void)ssid;
+    if (len == 0 || len > MAX_WIFI_SSID_LEN) {
+        Console.print("WiFi SSID length invalid (1-");
+        Console.print(MAX_WIFI_SSID_LEN);
+        Console.println(" characters required)");
+        return false;
+    }
+    return true;
+}
+
+bool validateWiFiPassword(const char* password, size_t len) {
+    (void)password;
+    if (len == 0 || len > MAX_WIFI_PASSWORD_LEN) {
+        Console.print("WiFi password length invalid (1-");
+        Console.print(MAX_WIFI_PASSWORD_LEN);
+        Console.println(" characters required)");
         return false;
     }
     return true;
 }
 
-bool validateWiFiPassword(const String& password) {
-    if (password.length() == 0 || password.length() > MAX_WIFI_PASSWORD_LEN) {
-        Serial.print("WiFi password length invalid (1-");
-        Serial.print(MAX_WIFI_PASSWORD_LEN);
-        Serial.println(" characters required)");
+bool validateAdminPassword(const char* password, size_t len) {
+    (void)password;
+    if (len == 0 || len > MAX_ADMIN_PASSWORD_LEN) {
+        Console.print("Admin password length invalid (1-");
+        Console.print(MAX_ADMIN_PASSWORD_LEN);
+        Console.println(" characters required)");
         return false;
     }
     return true;
 }
 
-bool validateVPSToken(const String& token) {
-    if (token.length() == 0 || token.length() > MAX_VPS_TOKEN_LEN) {
-        Serial.print("VPS token length invalid (1-");
-        Serial.print(MAX_VPS_TOKEN_LEN);
-        Serial.println(" characters required)");
+bool validateVPSToken(const char* token, size_t len) {
+    (void)token;
+    if (len == 0 || len > MAX_VPS_TOKEN_LEN) {
+        Console.print("VPS token length invalid (1-");
+        Console.print(MAX_VPS_TOKEN_LEN);
+        Console.println(" characters required)");
         return false;
     }
     return true;
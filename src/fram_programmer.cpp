@@ -1,23 +1,36 @@
 #include "fram_programmer.h"
 #include "encryption.h"
+#include "credential_record.h"
+#include "crc32.h"
+#include "chunk_ring.h"
+#include "core1_worker.h"
+#include "hex_codec.h"
+#include "fram_scrub.h"
+#include "partition_table.h"
+#include "console_out.h"
+#include "logging.h"
 #include <Wire.h>
 #include <Adafruit_FRAM_I2C.h>
 #include <stddef.h>
 // Global FRAM object
 Adafruit_FRAM_I2C fram = Adafruit_FRAM_I2C();
+const FRAMDevice defaultFRAM = { &fram, &Wire, FRAM_I2C_ADDR };
+
+// Driver pool for multi-chip fixtures (one per strappable address)
+static Adafruit_FRAM_I2C device_pool[FRAM_MAX_DEVICES];
 
 bool initFRAM() {
-    Serial.print("Scanning I2C bus for FRAM at 0x");
-    Serial.print(FRAM_I2C_ADDR, HEX);
-    Serial.print("... ");
+    Console.print("Scanning I2C bus for FRAM at 0x");
+    Console.print(FRAM_I2C_ADDR, HEX);
+    Console.print("... ");
     
     // Initialize FRAM with specified address
     if (!fram.begin(FRAM_I2C_ADDR)) {
-        Serial.println("NOT FOUND");
+        Console.println("NOT FOUND");
         return false;
     }
     
-    Serial.println("FOUND");
+    Console.println("FOUND");
     
     // Verify FRAM is working by reading/writing test pattern
     uint8_t test_data = 0xAA;
@@ -28,7 +41,7 @@ bool initFRAM() {
     fram.read(0x7FFE, &read_data, 1);
     
     if (read_data != test_data) {
-        Serial.println("FRAM verification failed");
+        Console.println("FRAM verification failed");
         return false;
     }
     
@@ -40,363 +53,697 @@ bool initFRAM() {
 }
 
 bool detectFRAM() {
-    Wire.beginTransmission(FRAM_I2C_ADDR);
-    uint8_t error = Wire.endTransmission();
+    return detectFRAM(defaultFRAM);
+}
+
+bool detectFRAM(const FRAMDevice& dev) {
+    dev.wire->beginTransmission(dev.i2c_addr);
+    uint8_t error = dev.wire->endTransmission();
     return (error == 0);
 }
 
+uint8_t discoverFRAMDevices(FRAMDevice* devices, uint8_t max_devices) {
+    uint8_t count = 0;
+    
+    for (uint8_t addr = FRAM_I2C_ADDR_FIRST; addr <= FRAM_I2C_ADDR_LAST && count < max_devices; addr++) {
+        Wire.beginTransmission(addr);
+        if (Wire.endTransmission() != 0) {
+            continue;
+        }
+        
+        // The default address keeps using the global driver
+        Adafruit_FRAM_I2C* driver = (addr == FRAM_I2C_ADDR) ? &fram
+                                                            : &device_pool[addr - FRAM_I2C_ADDR_FIRST];
+        if (!driver->begin(addr, &Wire)) {
+            Console.print("WARNING: Device at 0x");
+            Console.print(addr, HEX);
+            Console.println(" responded but is not a FRAM");
+            continue;
+        }
+        
+        devices[count].fram = driver;
+        devices[count].wire = &Wire;
+        devices[count].i2c_addr = addr;
+        count++;
+    }
+    
+    return count;
+}
+
+// Print "<label>: <bytes> bytes in <ms> ms (<rate> B/s)"
+static void printThroughput(const char* label, size_t bytes, unsigned long elapsed_us) {
+    Console.print(label);
+    Console.print(": ");
+    Console.print(bytes);
+    Console.print(" bytes in ");
+    Console.print(elapsed_us / 1000);
+    Console.print(" ms (");
+    Console.print(elapsed_us > 0 ? (unsigned long)((uint64_t)bytes * 1000000ULL / elapsed_us) : 0);
+    Console.println(" B/s)");
+}
+
+// Ranges the backup covers: the partitions flagged for backup, or all of FRAM
+static ByteRange backup_ranges[PART_MAX];
+static uint8_t backup_range_count = 0;
+
+// Core 1 job: producer side of the backup ring, owns the FRAM bus
+static void backupReadJob(void* arg) {
+    ChunkRing& ring = *(ChunkRing*)arg;
+    
+    for (uint8_t r = 0; r < backup_range_count; r++) {
+        const ByteRange& range = backup_ranges[r];
+        
+        for (size_t done = 0; done < range.len; done += RING_SLOT_SIZE) {
+            RingSlot* slot = ringBeginWrite(ring);
+            slot->addr = range.addr + done;
+            slot->len = min((size_t)RING_SLOT_SIZE, range.len - done);
+            
+            for (size_t offset = 0; offset < slot->len; offset += FRAM_BULK_CHUNK_SIZE) {
+                size_t chunk = min((size_t)FRAM_BULK_CHUNK_SIZE, slot->len - offset);
+                fram.read(slot->addr + offset, &slot->data[offset], chunk);
+            }
+            ringCommitWrite(ring);
+        }
+    }
+    
+    ringClose(ring);
+}
+
 bool backupFRAM() {
-    Serial.println("Starting FRAM backup...");
+    Console.println("Starting FRAM backup...");
     
     if (!detectFRAM()) {
-        Serial.println("ERROR: FRAM not detected");
+        Console.println("ERROR: FRAM not detected");
         return false;
     }
     
-    // Read entire FRAM content (32KB = 32768 bytes)
-    const size_t fram_size = 32768;
-    const size_t chunk_size = 64;  // Read in 64-byte chunks
+    // Ranges from the chip in the socket, not from the one present at boot
+    reloadPartitions();
     
-    Serial.println("BACKUP_START");
-    Serial.print("SIZE:");
-    Serial.println(fram_size);
+    // Core 1 reads FRAM into the ring while core 0 formats and sends the hex
+    // lines, so the I2C and USB transfers overlap instead of alternating
+    static ChunkRing ring;
+    ringInit(ring);
     
-    for (size_t addr = 0; addr < fram_size; addr += chunk_size) {
-        uint8_t buffer[chunk_size];
-        size_t read_size = min(chunk_size, fram_size - addr);
-        
-        fram.read(addr, buffer, read_size);
-        
-        // Send address
-        Serial.print("ADDR:");
-        Serial.println(addr, HEX);
-        
-        // Send data as hex
-        Serial.print("DATA:");
-        for (size_t i = 0; i < read_size; i++) {
-            if (buffer[i] < 16) Serial.print("0");
-            Serial.print(buffer[i], HEX);
+    backup_range_count = partitionRanges(PART_FLAG_BACKUP, backup_ranges, PART_MAX);
+    size_t total = 0;
+    for (uint8_t r = 0; r < backup_range_count; r++) {
+        total += backup_ranges[r].len;
+    }
+    
+    Console.println("BACKUP_START");
+    Console.print("SIZE:");
+    Console.println(total);
+    
+    // Informational for the host; restore follows the ADDR: lines
+    if (partitionsLoaded()) {
+        for (uint8_t r = 0; r < backup_range_count; r++) {
+            Console.print("RANGE:");
+            Console.print(backup_ranges[r].addr, HEX);
+            Console.print(":");
+            Console.println(backup_ranges[r].len);
         }
-        Serial.println();
-        
-        delay(10); // Small delay for serial processing
     }
     
-    Serial.println("BACKUP_END");
+    Wire.setClock(FRAM_I2C_BULK_CLOCK);
+    ConsoleStats console_start = consoleStats();
+    unsigned long start_us = micros();
+    
+    if (!core1Submit(backupReadJob, &ring)) {
+        Wire.setClock(FRAM_I2C_CLOCK);
+        Console.println("ERROR: Core 1 busy");
+        return false;
+    }
+    
+    RingSlot* slot;
+    while ((slot = ringBeginRead(ring)) != nullptr) {
+        for (size_t offset = 0; offset < slot->len; offset += 64) {
+            printBackupChunk(slot->addr + offset, &slot->data[offset], min((size_t)64, slot->len - offset));
+        }
+        ringCommitRead(ring);
+    }
+    
+    core1Wait();
+    unsigned long elapsed_us = micros() - start_us;
+    Wire.setClock(FRAM_I2C_CLOCK);
+    
+    Console.println("BACKUP_END");
+    printThroughput("Backup", total, elapsed_us);
+    printConsoleStats(console_start, elapsed_us);
+    printRingStats(ring, "FRAM read", "USB output");
     return true;
 }
 
-bool restoreFRAM(const uint8_t* backup_data, size_t data_size) {
-    Serial.println("Starting FRAM restore...");
+void printBackupChunk(uint16_t addr, const uint8_t* data, size_t len) {
+    // Send address
+    Console.printf("ADDR:%X\r\n", addr);
     
+    // Send data as hex
+    printHexLine("DATA:", data, len);
+}
+
+bool fillFRAM(uint16_t addr, size_t len, const uint8_t* pattern, size_t pattern_len) {
     if (!detectFRAM()) {
-        Serial.println("ERROR: FRAM not detected");
+        Console.println("ERROR: FRAM not detected");
+        return false;
+    }
+    
+    if (pattern_len == 0 || pattern_len > FRAM_FILL_MAX_PATTERN) {
+        Console.println("ERROR: Invalid fill pattern length");
         return false;
     }
     
-    if (data_size > 32768) {
-        Serial.println("ERROR: Backup data too large");
+    if (len == 0 || (size_t)addr + len > FRAM_SIZE) {
+        Console.println("ERROR: Fill range outside FRAM");
         return false;
     }
     
-    // Write data in chunks
-    const size_t chunk_size = 32;
+    // One chunk-sized buffer holding the pattern repeated. Its length is a
+    // multiple of the pattern length so every write continues the pattern
+    // phase of the previous one and the same buffer can be sent every time.
+    uint8_t buffer[FRAM_BULK_CHUNK_SIZE];
+    size_t buffer_len = (FRAM_BULK_CHUNK_SIZE / pattern_len) * pattern_len;
+    for (size_t i = 0; i < buffer_len; i++) {
+        buffer[i] = pattern[i % pattern_len];
+    }
     
-    for (size_t addr = 0; addr < data_size; addr += chunk_size) {
-        size_t write_size = min(chunk_size, data_size - addr);
-        
-        // Cast away const for fram.write (it doesn't modify the data)
-        fram.write(addr, (uint8_t*)&backup_data[addr], write_size);
-        
-        // Verify written data
-        uint8_t verify_buffer[chunk_size];
-        fram.read(addr, verify_buffer, write_size);
+    // Expected CRC is computed from the buffer while the bus is busy writing
+    uint32_t expected_crc = 0;
+    unsigned long start = micros();
+    scrubNoteWrite(addr, len);
+    
+    for (size_t offset = 0; offset < len; offset += buffer_len) {
+        size_t write_size = min(buffer_len, len - offset);
+        fram.write(addr + offset, buffer, write_size);
+        expected_crc = crc32Update(expected_crc, buffer, write_size);
+    }
+    
+    printThroughput("  Write", len, micros() - start);
+    
+    // Confirm with a streaming CRC read instead of a byte-by-byte compare
+    uint32_t actual_crc = 0;
+    start = micros();
+    if (!crcFRAM(addr, len, &actual_crc)) {
+        return false;
+    }
+    printThroughput("  Verify", len, micros() - start);
+    
+    if (actual_crc != expected_crc) {
+        Console.print("ERROR: Fill verification failed - CRC32 expected 0x");
+        Console.print(expected_crc, HEX);
+        Console.print(", read 0x");
+        Console.println(actual_crc, HEX);
+        return false;
+    }
+    
+    return true;
+}
+
+bool wipeFRAM(uint16_t addr, size_t len) {
+    // Alternating bit patterns followed by a final zero pass
+    static const uint8_t wipe_patterns[FRAM_WIPE_PASSES] = {0x55, 0xAA, 0x00};
+    
+    unsigned long start = micros();
+    
+    for (int pass = 0; pass < FRAM_WIPE_PASSES; pass++) {
+        Console.print("Wipe pass ");
+        Console.print(pass + 1);
+        Console.print("/");
+        Console.print(FRAM_WIPE_PASSES);
+        Console.print(" (pattern 0x");
+        printHex(&wipe_patterns[pass], 1);
+        Console.println(")");
+        Console.flush();        // Shown before the pass, not after it
         
-        if (memcmp(&backup_data[addr], verify_buffer, write_size) != 0) {
-            Serial.print("ERROR: Verification failed at address 0x");
-            Serial.println(addr, HEX);
+        if (!fillFRAM(addr, len, &wipe_patterns[pass], 1)) {
+            Console.print("ERROR: Wipe failed on pass ");
+            Console.println(pass + 1);
+            return false;
+        }
+    }
+    
+    printThroughput("Wipe total", len * FRAM_WIPE_PASSES, micros() - start);
+    return true;
+}
+
+bool crcFRAM(uint16_t addr, size_t len, uint32_t* crc) {
+    if ((size_t)addr + len > FRAM_SIZE) {
+        Console.println("ERROR: CRC range outside FRAM");
+        return false;
+    }
+    
+    uint8_t buffer[FRAM_BULK_CHUNK_SIZE];
+    uint32_t value = 0;
+    
+    for (size_t offset = 0; offset < len; offset += FRAM_BULK_CHUNK_SIZE) {
+        size_t read_size = min((size_t)FRAM_BULK_CHUNK_SIZE, len - offset);
+        fram.read(addr + offset, buffer, read_size);
+        value = crc32Update(value, buffer, read_size);
+    }
+    
+    *crc = value;
+    return true;
+}
+
+bool readCredentialStatus(const FRAMDevice& dev, CredentialStatus& status) {
+    memset(&status, 0, sizeof(status));
+    
+    // magic, version and length in one 8-byte read; both versions share the first two
+    using HeaderSpan = FramSpan<CredV2Magic, CredV2Length>;
+    FramView<CredentialRecordHeader> header(dev, FRAM_CREDENTIALS_ADDR);
+    uint8_t head[HeaderSpan::size];
+    if (!header.readSpan<HeaderSpan>(head)) {
+        return false;
+    }
+    status.bus_bytes = HeaderSpan::size;
+    
+    uint32_t magic;
+    uint16_t version, length;
+    HeaderSpan::get<CredV2Magic>(head, magic);
+    HeaderSpan::get<CredV2Version>(head, version);
+    HeaderSpan::get<CredV2Length>(head, length);
+    
+    if (magic != FRAM_MAGIC_NUMBER) {
+        return true;
+    }
+    
+    if (version == FRAM_DATA_VERSION) {
+        FramView<FRAMCredentials> v1(dev, FRAM_CREDENTIALS_ADDR);
+        char name[sizeof(FRAMCredentials::device_name)];
+        if (!v1.read<CredV1DeviceName>(name)) {
             return false;
         }
+        status.bus_bytes += CredV1DeviceName::size;
+        memcpy(status.device_name, name, MAX_DEVICE_NAME_LEN);
+        status.version = version;
+        status.size = CRED_V1_USED_SIZE;
+    } else if (version == FRAM_DATA_VERSION_V2) {
+        // The device name is always the first entry
+        uint8_t entry[CRED_TLV_HEADER_SIZE + MAX_DEVICE_NAME_LEN];
+        if (!framViewRead(dev, FRAM_CREDENTIALS_ADDR + sizeof(CredentialRecordHeader), entry, sizeof(entry))) {
+            return false;
+        }
+        status.bus_bytes += sizeof(entry);
         
-        // Progress indicator
-        if (addr % 1024 == 0) {
-            Serial.print(".");
+        uint16_t name_len = entry[1] | (entry[2] << 8);
+        if (entry[0] == CRED_TLV_DEVICE_NAME && name_len <= MAX_DEVICE_NAME_LEN) {
+            memcpy(status.device_name, &entry[CRED_TLV_HEADER_SIZE], name_len);
+            status.version = version;
+            status.size = sizeof(CredentialRecordHeader) + length;
         }
     }
     
-    Serial.println();
-    Serial.println("FRAM restore completed successfully");
     return true;
 }
 
-bool readCredentialsSection(FRAMCredentials& creds) {
-    if (!detectFRAM()) {
-        Serial.println("ERROR: FRAM not detected");
+bool readCredentialsSection(CredentialRecord& rec) {
+    return readCredentialsSection(defaultFRAM, rec);
+}
+
+bool readCredentialsSection(const FRAMDevice& dev, CredentialRecord& rec) {
+    if (!detectFRAM(dev)) {
+        Console.println("ERROR: FRAM not detected");
         return false;
     }
     
-    // Read credentials structure from FRAM
-    fram.read(FRAM_CREDENTIALS_ADDR, (uint8_t*)&creds, sizeof(FRAMCredentials));
+    // Header first; it tells how much more of the record is worth reading
+    CredentialRecordHeader header;
+    FramView<CredentialRecordHeader>(dev, FRAM_CREDENTIALS_ADDR).readAll(header);
+    memcpy(rec.raw, &header, sizeof(header));
     
+    size_t size = credentialRecordReadSize(header);
+    if (size > sizeof(header)) {
+        dev.fram->read(FRAM_CREDENTIALS_ADDR + sizeof(header), &rec.raw[sizeof(header)],
+                       size - sizeof(header));
+    }
+    
+    // A bad magic/version/layout leaves rec.version at 0; the bus read itself succeeded
+    rec.size = size;
+    parseCredentialRecord(rec);
     return true;
 }
 
-bool writeCredentialsSection(const FRAMCredentials& creds) {
-    if (!detectFRAM()) {
-        Serial.println("ERROR: FRAM not detected");
+bool writeCredentialsSection(const CredentialRecord& rec) {
+    return writeCredentialsSection(defaultFRAM, rec);
+}
+
+bool writeCredentialsSection(const FRAMDevice& dev, const CredentialRecord& rec) {
+    if (!detectFRAM(dev)) {
+        Console.println("ERROR: FRAM not detected");
         return false;
     }
     
-    // Debug: show what we're writing
-    Serial.println("DEBUG: Writing structure to FRAM:");
-    const uint8_t* raw = (const uint8_t*)&creds;
-    Serial.println("First 50 bytes being written:");
-    for (int i = 0; i < 50; i++) {
-        if (i % 16 == 0) Serial.print("  ");
-        if (raw[i] < 16) Serial.print("0");
-        Serial.print(raw[i], HEX);
-        Serial.print(" ");
-        if ((i + 1) % 16 == 0) Serial.println();
+    LOG_HEX_V("First 50 bytes being written:", rec.raw, min((size_t)50, (size_t)rec.size));
+    if (LOG_ENABLED(LOG_LEVEL_DEBUG)) {
+        uint32_t stored, computed;
+        checkCredentialRecord(rec, &stored, &computed);
+        LOG_D("Record v%u, %u bytes, checksum being written: 0x%lX",
+              (unsigned)rec.version, (unsigned)rec.size, (unsigned long)stored);
     }
-    Serial.println();
     
-    Serial.print("DEBUG: Checksum being written: ");
-    Serial.println(creds.checksum);
-    Serial.print("DEBUG: Checksum field bytes: 0x");
-    Serial.print(raw[497], HEX);
-    Serial.println(raw[496], HEX);
-    
-    // Write credentials structure to FRAM
-    fram.write(FRAM_CREDENTIALS_ADDR, (uint8_t*)&creds, sizeof(FRAMCredentials));
+    // Write only the bytes the record occupies
+    if (dev.fram == &fram) {
+        scrubNoteWrite(FRAM_CREDENTIALS_ADDR, rec.size);
+    }
+    dev.fram->write(FRAM_CREDENTIALS_ADDR, (uint8_t*)rec.raw, rec.size);
     
     // Verify write by reading back
-    FRAMCredentials verify_creds;
-    fram.read(FRAM_CREDENTIALS_ADDR, (uint8_t*)&verify_creds, sizeof(FRAMCredentials));
+    uint8_t verify_raw[FRAM_CREDENTIALS_SIZE];
+    dev.fram->read(FRAM_CREDENTIALS_ADDR, verify_raw, rec.size);
     
     // Compare written data
-    if (memcmp(&creds, &verify_creds, sizeof(FRAMCredentials)) != 0) {
-        Serial.println("ERROR: FRAM write verification failed!");
-        
-        // Debug: find where they differ
-        const uint8_t* written = (const uint8_t*)&creds;
-        const uint8_t* read = (const uint8_t*)&verify_creds;
+    if (memcmp(rec.raw, verify_raw, rec.size) != 0) {
+        Console.println("ERROR: FRAM write verification failed!");
         
-        Serial.println("DEBUG: Differences found:");
-        for (size_t i = 0; i < sizeof(FRAMCredentials); i++) {
-            if (written[i] != read[i]) {
-                Serial.print("  Byte ");
-                Serial.print(i);
-                Serial.print(": written=0x");
-                if (written[i] < 16) Serial.print("0");
-                Serial.print(written[i], HEX);
-                Serial.print(", read=0x");
-                if (read[i] < 16) Serial.print("0");
-                Serial.println(read[i], HEX);
+        if (LOG_ENABLED(LOG_LEVEL_DEBUG)) {
+            LOG_D("Differences found:");
+            for (size_t i = 0; i < rec.size; i++) {
+                if (rec.raw[i] != verify_raw[i]) {
+                    Console.printf("  Byte %u: written=0x%02X, read=0x%02X\r\n",
+                                   (unsigned)i, rec.raw[i], verify_raw[i]);
+                }
             }
         }
         return false;
     }
     
-    Serial.println("DEBUG: FRAM write verification passed");
+    LOG_D("FRAM write verification passed");
     return true;
 }
 
 bool programCredentials(const DeviceCredentials& creds) {
-    Serial.println("Programming credentials to FRAM...");
+    LOG_I("Programming credentials to FRAM...");
     
     // Validate input credentials
-    if (!validateDeviceName(creds.device_name)) {
-        Serial.println("ERROR: Invalid device name");
+    if (!validateCredentials(creds)) {
         return false;
     }
     
-    if (!validateWiFiSSID(creds.wifi_ssid)) {
-        Serial.println("ERROR: Invalid WiFi SSID");
+    // Create and encrypt credentials record
+    static CredentialRecord rec;
+    if (!encryptCredentials(creds, rec)) {
+        Console.println("ERROR: Credential encryption failed");
         return false;
     }
     
-    if (!validateWiFiPassword(creds.wifi_password)) {
-        Serial.println("ERROR: Invalid WiFi password");
+    // Back up only the bytes the new record will overwrite
+    LOG_I("Backing up existing FRAM content...");
+    uint8_t backup_before[FRAM_CREDENTIALS_SIZE];
+    fram.read(FRAM_CREDENTIALS_ADDR, backup_before, rec.size);
+    
+    // Write to FRAM
+    LOG_I("Writing encrypted credentials to FRAM...");
+    if (!writeCredentialsSection(rec)) {
+        // Restore backup on failure
+        Console.println("FAILED: Restoring backup...");
+        scrubNoteWrite(FRAM_CREDENTIALS_ADDR, rec.size);
+        fram.write(FRAM_CREDENTIALS_ADDR, backup_before, rec.size);
         return false;
     }
     
-    if (!validateVPSToken(creds.vps_token)) {
-        Serial.println("ERROR: Invalid VPS token");
+    LOG_I("SUCCESS: Credentials programmed to FRAM");
+    
+    // Verify by reading back and checking magic/checksum
+    return verifyCredentials();
+}
+
+bool migrateCredentialsSection() {
+    static CredentialRecord v1, v2;
+    if (!readCredentialsSection(v1)) {
         return false;
     }
     
-    // Read current FRAM content to preserve other data
-    Serial.println("Backing up existing FRAM content...");
-    uint8_t backup_before[FRAM_CREDENTIALS_SIZE];
-    fram.read(FRAM_CREDENTIALS_ADDR, backup_before, FRAM_CREDENTIALS_SIZE);
+    if (v1.version == FRAM_DATA_VERSION_V2) {
+        Console.println("Credentials are already in v2 format");
+        return true;
+    }
     
-    // Create and encrypt credentials structure
-    FRAMCredentials fram_creds;
-    if (!encryptCredentials(creds, fram_creds)) {
-        Serial.println("ERROR: Credential encryption failed");
+    uint32_t stored, computed;
+    if (v1.version != FRAM_DATA_VERSION || !checkCredentialRecord(v1, &stored, &computed)) {
+        Console.println("ERROR: No valid v1 credentials to migrate");
         return false;
     }
     
-    // Write to FRAM
-    Serial.println("Writing encrypted credentials to FRAM...");
-    if (!writeCredentialsSection(fram_creds)) {
-        // Restore backup on failure
-        Serial.println("FAILED: Restoring backup...");
-        fram.write(FRAM_CREDENTIALS_ADDR, backup_before, FRAM_CREDENTIALS_SIZE);
+    if (!migrateCredentials(v1, v2)) {
         return false;
     }
     
-    Serial.println("SUCCESS: Credentials programmed to FRAM");
+    if (!writeCredentialsSection(v2)) {
+        Console.println("FAILED: Restoring v1 record...");
+        scrubNoteWrite(FRAM_CREDENTIALS_ADDR, v2.size);
+        fram.write(FRAM_CREDENTIALS_ADDR, v1.raw, v2.size);
+        return false;
+    }
+    
+    // Clear the v1 bytes the shorter v2 record no longer covers
+    uint8_t zeros[FRAM_BULK_CHUNK_SIZE];
+    memset(zeros, 0, sizeof(zeros));
+    if (v1.size > v2.size) {
+        scrubNoteWrite(FRAM_CREDENTIALS_ADDR + v2.size, v1.size - v2.size);
+    }
+    for (size_t offset = v2.size; offset < v1.size; offset += sizeof(zeros)) {
+        size_t chunk = min(sizeof(zeros), v1.size - offset);
+        fram.write(FRAM_CREDENTIALS_ADDR + offset, zeros, chunk);
+    }
+    
+    Console.print("Record size: ");
+    Console.print(v1.size);
+    Console.print(" -> ");
+    Console.print(v2.size);
+    Console.println(" bytes");
+    
+    return verifyCredentials();
+}
+
+// Rewrite only the bytes that differ from what the section held before. Runs
+// separated by fewer than CRED_REWRITE_GAP unchanged bytes are merged, since a
+// few repeated bytes cost less than addressing another I2C write. Bytes past
+// before_len were never read back, so they always count as changed
+#define CRED_REWRITE_GAP        4
+
+static size_t writeChangedRuns(const uint8_t* before, size_t before_len,
+                               const uint8_t* after, size_t after_len) {
+    size_t written = 0;
+    size_t i = 0;
+    while (i < after_len) {
+        if (i < before_len && before[i] == after[i]) {
+            i++;
+            continue;
+        }
+        
+        size_t start = i;
+        size_t end = i + 1;
+        size_t unchanged = 0;
+        for (i = end; i < after_len && unchanged < CRED_REWRITE_GAP; i++) {
+            if (i < before_len && before[i] == after[i]) {
+                unchanged++;
+            } else {
+                unchanged = 0;
+                end = i + 1;
+            }
+        }
+        
+        scrubNoteWrite(FRAM_CREDENTIALS_ADDR + start, end - start);
+        fram.write(FRAM_CREDENTIALS_ADDR + start, (uint8_t*)&after[start], end - start);
+        written += end - start;
+        i = end;
+    }
+    return written;
+}
+
+bool rekeyCredentialsSection(bool rotate_salt) {
+    static CredentialRecord rec, original;
+    if (!readCredentialsSection(rec)) {
+        return false;
+    }
+    
+    uint32_t stored, computed;
+    if (rec.version == 0 || !checkCredentialRecord(rec, &stored, &computed)) {
+        Console.println("ERROR: No valid credentials to re-key");
+        return false;
+    }
+    original = rec;
+    
+    unsigned long start = micros();
+    if (!rekeyCredentials(rec, rotate_salt)) {
+        return false;
+    }
+    unsigned long crypto_us = micros() - start;
+    
+    // Name, entry headers and v1 reserved bytes are unchanged and stay unwritten
+    start = micros();
+    size_t written = writeChangedRuns(original.raw, original.size, rec.raw, rec.size);
+    unsigned long write_us = micros() - start;
+    
+    uint8_t verify_raw[FRAM_CREDENTIALS_SIZE];
+    fram.read(FRAM_CREDENTIALS_ADDR, verify_raw, rec.size);
+    if (memcmp(rec.raw, verify_raw, rec.size) != 0) {
+        Console.println("FAILED: Restoring previous record...");
+        scrubNoteWrite(FRAM_CREDENTIALS_ADDR, original.size);
+        fram.write(FRAM_CREDENTIALS_ADDR, original.raw, original.size);
+        return false;
+    }
+    
+    Console.print("Re-encrypted ");
+    Console.print(rec.wifi_ssid.len + rec.wifi_password.len + rec.admin_hash.len + rec.vps_token.len);
+    Console.print(" bytes in ");
+    Console.print(crypto_us);
+    Console.println(" us");
+    Console.print("Wrote ");
+    Console.print(written);
+    Console.print(" of ");
+    Console.print(rec.size);
+    Console.print(" record bytes in ");
+    Console.print(write_us);
+    Console.println(" us");
     
-    // Verify by reading back and checking magic/checksum
     return verifyCredentials();
 }
 
 bool verifyCredentials() {
-    Serial.println("Verifying FRAM credentials...");
+    return verifyCredentials(defaultFRAM);
+}
+
+bool verifyCredentials(const FRAMDevice& dev) {
+    CredentialRecord rec;
+    return verifyCredentials(dev, rec);
+}
+
+bool verifyCredentials(CredentialRecord& rec) {
+    return verifyCredentials(defaultFRAM, rec);
+}
+
+bool verifyCredentials(const FRAMDevice& dev, CredentialRecord& rec) {
+    LOG_I("Verifying FRAM credentials...");
     
-    FRAMCredentials creds;
-    if (!readCredentialsSection(creds)) {
+    if (!readCredentialsSection(dev, rec)) {
         return false;
     }
     
-    // Debug: pokaż podstawowe informacje
-    Serial.print("DEBUG: Magic = 0x");
-    Serial.println(creds.magic, HEX);
-    Serial.print("DEBUG: Version = ");
-    Serial.println(creds.version);
-    Serial.print("DEBUG: Device name = '");
-    Serial.print(creds.device_name);
-    Serial.println("'");
-    Serial.print("DEBUG: Structure size = ");
-    Serial.println(sizeof(FRAMCredentials));
-    
-    // Debug: show some key structure bytes
-    uint8_t* raw = (uint8_t*)&creds;
-    Serial.println("DEBUG: First 50 bytes of structure:");
-    for (int i = 0; i < 50; i++) {
-        if (i % 16 == 0) Serial.print("  ");
-        if (raw[i] < 16) Serial.print("0");
-        Serial.print(raw[i], HEX);
-        Serial.print(" ");
-        if ((i + 1) % 16 == 0) Serial.println();
-    }
-    Serial.println();
+    CredentialRecordHeader header;
+    memcpy(&header, rec.raw, sizeof(header));
+    
+    LOG_D("Magic = 0x%lX, version = %u, device name = '%s', record size = %u",
+          (unsigned long)header.magic, (unsigned)header.version, rec.device_name, (unsigned)rec.size);
+    LOG_HEX_V("First 50 bytes of structure:", rec.raw, min((size_t)50, (size_t)rec.size));
     
     // Check magic number
-    if (creds.magic != FRAM_MAGIC_NUMBER) {
-        Serial.print("ERROR: Invalid magic number: 0x");
-        Serial.print(creds.magic, HEX);
-        Serial.print(", expected: 0x");
-        Serial.println(FRAM_MAGIC_NUMBER, HEX);
+    if (header.magic != FRAM_MAGIC_NUMBER) {
+        Console.print("ERROR: Invalid magic number: 0x");
+        Console.print(header.magic, HEX);
+        Console.print(", expected: 0x");
+        Console.println(FRAM_MAGIC_NUMBER, HEX);
         return false;
     }
     
-    // Check version
-    if (creds.version != FRAM_DATA_VERSION) {
-        Serial.print("ERROR: Invalid version: ");
-        Serial.print(creds.version);
-        Serial.print(", expected: ");
-        Serial.println(FRAM_DATA_VERSION);
+    // Check version and layout
+    if (header.version != FRAM_DATA_VERSION && header.version != FRAM_DATA_VERSION_V2) {
+        Console.print("ERROR: Invalid version: ");
+        Console.print(header.version);
+        Console.print(", expected: ");
+        Console.print(FRAM_DATA_VERSION);
+        Console.print(" or ");
+        Console.println(FRAM_DATA_VERSION_V2);
         return false;
     }
     
-    // Debug checksum calculation
-    uint16_t stored_checksum = creds.checksum;
-    
-    // Calculate checksum only over bytes BEFORE checksum field (0 to checksum_offset-1)
-    size_t checksum_offset = offsetof(FRAMCredentials, checksum);
-    uint16_t calculated_checksum = calculateChecksum((uint8_t*)&creds, checksum_offset);
-    
-    Serial.print("DEBUG: Checksum field at offset ");
-    Serial.println(checksum_offset);
-    Serial.print("DEBUG: Calculating checksum over ");
-    Serial.print(checksum_offset);
-    Serial.println(" bytes (before checksum field)");
-    Serial.print("DEBUG: Stored checksum = ");
-    Serial.println(stored_checksum);
-    Serial.print("DEBUG: Calculated checksum = ");
-    Serial.println(calculated_checksum);
-    Serial.print("DEBUG: Difference = ");
-    Serial.println(abs(stored_checksum - calculated_checksum));
-    
-    if (stored_checksum != calculated_checksum) {
-        Serial.print("ERROR: Checksum mismatch - stored: ");
-        Serial.print(stored_checksum);
-        Serial.print(", calculated: ");
-        Serial.println(calculated_checksum);
-        
-        // Debug: show bytes around checksum field
-        Serial.println("DEBUG: Bytes around checksum field (490-505):");
-        for (int i = 490; i < 506; i++) {
-            Serial.print("  [");
-            Serial.print(i);
-            Serial.print("] = 0x");
-            if (raw[i] < 16) Serial.print("0");
-            Serial.println(raw[i], HEX);
-        }
-        
+    if (rec.version == 0) {
+        Console.println("ERROR: Malformed credential record");
         return false;
     }
     
-    Serial.println("SUCCESS: Credentials verification passed");
-    return true;
-}
-
-uint16_t calculateChecksum(const uint8_t* data, size_t size) {
-    uint16_t sum = 0;
-    for (size_t i = 0; i < size; i++) {
-        sum += data[i];
+    // v1: 16-bit sum over bytes before the checksum field; v2: CRC32 of header and entries
+    uint32_t stored_checksum, calculated_checksum;
+    bool match = checkCredentialRecord(rec, &stored_checksum, &calculated_checksum);
+    
+    LOG_D("Stored checksum = 0x%lX, calculated = 0x%lX",
+          (unsigned long)stored_checksum, (unsigned long)calculated_checksum);
+    
+    if (!match) {
+        Console.print("ERROR: Checksum mismatch - stored: 0x");
+        Console.print(stored_checksum, HEX);
+        Console.print(", calculated: 0x");
+        Console.println(calculated_checksum, HEX);
+        return false;
     }
-    return sum;
+    
+    LOG_I("SUCCESS: Credentials verification passed");
+    return true;
 }
 
 void printFRAMInfo() {
-    Serial.println();
-    Serial.println("FRAM Information:");
-    Serial.print("  I2C Address: 0x");
-    Serial.println(FRAM_I2C_ADDR, HEX);
-    Serial.print("  Credentials Address: 0x");
-    Serial.println(FRAM_CREDENTIALS_ADDR, HEX);
-    Serial.print("  Credentials Size: ");
-    Serial.print(FRAM_CREDENTIALS_SIZE);
-    Serial.println(" bytes");
+    Console.println();
+    Console.println("FRAM Information:");
+    Console.print("  I2C Address: 0x");
+    Console.println(FRAM_I2C_ADDR, HEX);
+    Console.print("  Credentials Address: 0x");
+    Console.println(FRAM_CREDENTIALS_ADDR, HEX);
+    Console.print("  Credentials Size: ");
+    Console.print(FRAM_CREDENTIALS_SIZE);
+    Console.println(" bytes");
     
     // Check if credentials are present
-    FRAMCredentials creds;
-    if (readCredentialsSection(creds)) {
-        Serial.print("  Magic Number: 0x");
-        Serial.println(creds.magic, HEX);
+    static CredentialRecord rec;
+    if (readCredentialsSection(rec)) {
+        CredentialRecordHeader header;
+        memcpy(&header, rec.raw, sizeof(header));
+        Console.print("  Magic Number: 0x");
+        Console.println(header.magic, HEX);
         
-        if (creds.magic == FRAM_MAGIC_NUMBER) {
-            Serial.println("  Status: CREDENTIALS PRESENT");
-            printCredentialsInfo(creds);
+        if (rec.version != 0) {
+            Console.println("  Status: CREDENTIALS PRESENT");
+            printCredentialsInfo(rec);
+            
+            // One AES block, not the whole record
+            uint32_t start = micros();
+            bool key_ok = fastVerifyCredentials(rec);
+            Console.print("    Key Check: ");
+            Console.print(key_ok ? "OK" : "FAILED (wrong device name or corrupted record)");
+            Console.print(" (");
+            Console.print(micros() - start);
+            Console.println(" us)");
         } else {
-            Serial.println("  Status: NO VALID CREDENTIALS");
+            Console.println("  Status: NO VALID CREDENTIALS");
         }
     }
 }
 
-void printCredentialsInfo(const FRAMCredentials& creds) {
-    Serial.println("  Credential Details:");
-    Serial.print("    Version: ");
-    Serial.println(creds.version);
-    Serial.print("    Device Name: ");
-    Serial.println(creds.device_name);
-    Serial.print("    Checksum: 0x");
-    Serial.println(creds.checksum, HEX);
+static void printFieldSize(const char* label, const CredentialField& field) {
+    Console.print(label);
+    Console.print(field.len);
+    Console.println(" bytes");
+}
+
+void printCredentialsInfo(const CredentialRecord& rec) {
+    uint32_t stored, computed;
+    checkCredentialRecord(rec, &stored, &computed);
+    
+    Console.println("  Credential Details:");
+    Console.print("    Version: ");
+    Console.print(rec.version);
+    Console.println(rec.version == FRAM_DATA_VERSION ? " (fixed layout, run 'migrate' to compact)" : " (TLV)");
+    Console.print("    Record Size: ");
+    Console.print(rec.size);
+    Console.println(" bytes");
+    Console.print("    Device Name: ");
+    Console.println(rec.device_name);
+    Console.print(rec.version == FRAM_DATA_VERSION ? "    Checksum: 0x" : "    CRC32: 0x");
+    Console.print(stored, HEX);
+    Console.println(stored == computed ? "" : " (MISMATCH)");
     
     // Show encryption info
-    Serial.print("    IV: ");
-    for (int i = 0; i < AES_IV_SIZE; i++) {
-        if (creds.iv[i] < 16) Serial.print("0");
-        Serial.print(creds.iv[i], HEX);
-    }
-    Serial.println();
-    
-    Serial.println("    Encrypted Data Present:");
-    Serial.println("      - WiFi SSID: YES");
-    Serial.println("      - WiFi Password: YES");
-    Serial.println("      - Admin Hash: YES");
-    Serial.println("      - VPS Token: YES");
+    Console.print("    IV: ");
+    printHex(credentialField(rec, rec.iv), AES_IV_SIZE);
+    Console.println();
+    if (rec.kdf_salt.len > 0) {
+        Console.print("    Key Salt: ");
+        printHex(credentialField(rec, rec.kdf_salt), rec.kdf_salt.len);
+        Console.println();
+    }
+    
+    Console.println("    Encrypted Data Present:");
+    printFieldSize("      - WiFi SSID: ", rec.wifi_ssid);
+    printFieldSize("      - WiFi Password: ", rec.wifi_password);
+    printFieldSize("      - Admin Hash: ", rec.admin_hash);
+    printFieldSize("      - VPS Token: ", rec.vps_token);
 }
\ No newline at end of file
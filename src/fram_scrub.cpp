@@ -0,0 +1,353 @@
+#include "fram_scrub.h"
+#include "crc32.h"
+#include "serial_line.h"
+#include "console_out.h"
+#include <Wire.h>
+#include <Adafruit_FRAM_I2C.h>
+#include <pico/rand.h>
+
+// RAM copy of the index of the chip last seen in the socket. Staleness is
+// kept in the FRAM copy (SCRUB_CRC_STALE entries), so it survives a reset.
+static ScrubIndexHeader header;
+static uint32_t region_crc[SCRUB_REGION_COUNT];
+static bool index_valid = false;
+
+// Position of the running check
+static uint16_t current_region = 0;
+static uint16_t current_offset = 0;
+static uint32_t current_crc = 0;
+
+static uint32_t regions_checked = 0;
+static uint32_t passes = 0;
+static unsigned long enabled_at_ms = 0;
+static unsigned long slice_max_us = 0;
+
+static ScrubMismatch mismatches[SCRUB_MAX_MISMATCHES];
+static uint8_t mismatch_count = 0;
+
+static void writeHeader() {
+    header.table_crc = crc32((const uint8_t*)region_crc, sizeof(region_crc));
+    fram.write(SCRUB_INDEX_ADDR, (uint8_t*)&header, sizeof(header));
+}
+
+static void writeIndex() {
+    fram.write(SCRUB_INDEX_ADDR + sizeof(header), (uint8_t*)region_crc, sizeof(region_crc));
+    writeHeader();
+}
+
+static void writeRegionCRC(uint16_t region, uint32_t crc) {
+    region_crc[region] = crc;
+    fram.write(SCRUB_INDEX_ADDR + sizeof(header) + region * sizeof(uint32_t),
+               (uint8_t*)&region_crc[region], sizeof(uint32_t));
+}
+
+// Read the whole index of the chip present; the check restarts because the
+// position, mismatches and counters belonged to the previous index
+static void loadIndex() {
+    fram.read(SCRUB_INDEX_ADDR, (uint8_t*)&header, sizeof(header));
+    fram.read(SCRUB_INDEX_ADDR + sizeof(header), (uint8_t*)region_crc, sizeof(region_crc));
+    
+    index_valid = header.magic == SCRUB_INDEX_MAGIC &&
+                  header.version == SCRUB_INDEX_VERSION &&
+                  header.region_size == SCRUB_REGION_SIZE &&
+                  header.region_count == SCRUB_REGION_COUNT &&
+                  header.table_crc == crc32((const uint8_t*)region_crc, sizeof(region_crc));
+    
+    current_region = 0;
+    current_offset = 0;
+    mismatch_count = 0;
+    regions_checked = 0;
+    passes = 0;
+    enabled_at_ms = millis();
+}
+
+// Make the RAM copy describe the chip in the socket. Only the header is read
+// when nothing changed; its salt and table CRC differ between chips and after
+// any change to the table. False if there is no usable index (or no chip).
+static bool syncIndex() {
+    ScrubIndexHeader present;
+    if (!fram.read(SCRUB_INDEX_ADDR, (uint8_t*)&present, sizeof(present))) {
+        return false;
+    }
+    if (!index_valid || memcmp(&present, &header, sizeof(header)) != 0) {
+        loadIndex();
+    }
+    return index_valid;
+}
+
+static bool regionCRC(uint16_t region, uint32_t* crc) {
+    uint8_t buffer[FRAM_BULK_CHUNK_SIZE];
+    uint16_t addr = region * SCRUB_REGION_SIZE;
+    
+    *crc = 0;
+    for (size_t offset = 0; offset < SCRUB_REGION_SIZE; offset += sizeof(buffer)) {
+        if (!fram.read(addr + offset, buffer, sizeof(buffer))) {
+            return false;
+        }
+        *crc = crc32Update(*crc, buffer, sizeof(buffer));
+    }
+    return true;
+}
+
+static void recordMismatch(uint16_t region, uint32_t actual_crc) {
+    unsigned long now = millis();
+    
+    for (uint8_t i = 0; i < mismatch_count; i++) {
+        if (mismatches[i].region == region) {
+            mismatches[i].actual_crc = actual_crc;
+            mismatches[i].last_seen_ms = now;
+            mismatches[i].count++;
+            return;
+        }
+    }
+    
+    Console.println();
+    Console.print("WARNING: Scrub mismatch in region ");
+    Console.print(region);
+    Console.print(" (0x");
+    Console.print(region * SCRUB_REGION_SIZE, HEX);
+    Console.println(")");
+    
+    if (mismatch_count < SCRUB_MAX_MISMATCHES) {
+        ScrubMismatch& m = mismatches[mismatch_count++];
+        m.region = region;
+        m.expected_crc = region_crc[region];
+        m.actual_crc = actual_crc;
+        m.first_seen_ms = now;
+        m.last_seen_ms = now;
+        m.count = 1;
+    }
+}
+
+void initScrub() {
+    index_valid = false;
+    
+    if (!detectFRAM()) {
+        return;
+    }
+    
+    loadIndex();
+}
+
+void scrubNoteWrite(uint16_t addr, size_t len) {
+    if (len == 0 || addr >= SCRUB_INDEX_ADDR) {
+        return;     // A write over the index itself is picked up by the next syncIndex()
+    }
+    
+    // The index written to must be the one on this chip
+    if (!syncIndex()) {
+        return;
+    }
+    
+    size_t end = min((size_t)addr + len, (size_t)SCRUB_INDEX_ADDR);
+    uint16_t first = addr / SCRUB_REGION_SIZE;
+    uint16_t last = (end - 1) / SCRUB_REGION_SIZE;
+    bool changed = false;
+    
+    for (uint16_t region = first; region <= last; region++) {
+        if (region_crc[region] != SCRUB_CRC_STALE) {
+            writeRegionCRC(region, SCRUB_CRC_STALE);
+            changed = true;
+        }
+        if (region == current_region) {
+            current_offset = 0;     // Partly hashed before the write
+        }
+    }
+    
+    if (changed) {
+        writeHeader();
+    }
+}
+
+void scrubSlice() {
+    if (!index_valid || !(header.flags & SCRUB_FLAG_ENABLED)) {
+        return;
+    }
+    
+    // Never delay input that is already waiting
+    if (serialInputPending()) {
+        return;
+    }
+    
+    // loop() no longer sleeps 10 ms per pass; keep the scrub at its old pace
+    static unsigned long last_slice_ms = 0;
+    if (millis() - last_slice_ms < SCRUB_SLICE_INTERVAL_MS) {
+        return;
+    }
+    last_slice_ms = millis();
+    
+    unsigned long start_us = micros();
+    
+    if (current_offset == 0) {
+        current_crc = 0;
+    }
+    
+    uint8_t buffer[SCRUB_SLICE_BYTES];
+    uint16_t addr = current_region * SCRUB_REGION_SIZE + current_offset;
+    
+    Wire.setClock(FRAM_I2C_BULK_CLOCK);
+    bool read_ok = fram.read(addr, buffer, sizeof(buffer));
+    Wire.setClock(FRAM_I2C_CLOCK);
+    
+    if (!read_ok) {
+        return;     // Chip missing or bus busy; retry next time
+    }
+    
+    current_crc = crc32Update(current_crc, buffer, sizeof(buffer));
+    current_offset += sizeof(buffer);
+    
+    if (current_offset == SCRUB_REGION_SIZE) {
+        // A swapped chip must neither be judged by nor receive the previous
+        // chip's index; loading its own restarts the check
+        Wire.setClock(FRAM_I2C_BULK_CLOCK);
+        bool synced = syncIndex();
+        Wire.setClock(FRAM_I2C_CLOCK);
+        if (!synced || current_offset != SCRUB_REGION_SIZE) {
+            current_offset = 0;
+            return;
+        }
+        
+        if (region_crc[current_region] == SCRUB_CRC_STALE) {
+            // Written since the last baseline: adopt the new content
+            writeRegionCRC(current_region, current_crc);
+            writeHeader();
+        } else if (current_crc != region_crc[current_region]) {
+            recordMismatch(current_region, current_crc);
+        }
+        
+        regions_checked++;
+        current_offset = 0;
+        if (++current_region == SCRUB_REGION_COUNT) {
+            current_region = 0;
+            passes++;
+        }
+    }
+    
+    unsigned long elapsed_us = micros() - start_us;
+    if (elapsed_us > slice_max_us) {
+        slice_max_us = elapsed_us;
+    }
+}
+
+bool scrubRebuild() {
+    if (!detectFRAM()) {
+        Console.println("ERROR: FRAM not detected");
+        return false;
+    }
+    
+    // Keep the enable flag of this chip's index, if it has one
+    uint8_t flags = syncIndex() ? header.flags : 0;
+    
+    Wire.setClock(FRAM_I2C_BULK_CLOCK);
+    for (uint16_t region = 0; region < SCRUB_REGION_COUNT; region++) {
+        if (!regionCRC(region, &region_crc[region])) {
+            Wire.setClock(FRAM_I2C_CLOCK);
+            Console.println("ERROR: FRAM read failed");
+            return false;
+        }
+    }
+    Wire.setClock(FRAM_I2C_CLOCK);
+    
+    header.magic = SCRUB_INDEX_MAGIC;
+    header.version = SCRUB_INDEX_VERSION;
+    header.flags = flags;
+    header.region_size = SCRUB_REGION_SIZE;
+    header.region_count = SCRUB_REGION_COUNT;
+    header.reserved = 0;
+    header.salt = get_rand_32();
+    writeIndex();
+    
+    index_valid = true;
+    current_region = 0;
+    current_offset = 0;
+    mismatch_count = 0;
+    return true;
+}
+
+bool scrubEnable(bool enable) {
+    bool have_index = detectFRAM() && syncIndex();
+    if (enable && !have_index && !scrubRebuild()) {
+        return false;
+    }
+    if (!index_valid) {
+        return true;    // Disabling without an index: nothing to do
+    }
+    
+    if (enable) {
+        header.flags |= SCRUB_FLAG_ENABLED;
+        enabled_at_ms = millis();
+        regions_checked = 0;
+        passes = 0;
+        slice_max_us = 0;
+    } else {
+        header.flags &= ~SCRUB_FLAG_ENABLED;
+    }
+    writeIndex();
+    return true;
+}
+
+void printScrubStatus() {
+    if (detectFRAM()) {
+        syncIndex();
+    }
+    bool enabled = index_valid && (header.flags & SCRUB_FLAG_ENABLED);
+    
+    Console.print("Scrub: ");
+    Console.println(enabled ? "ON" : "OFF");
+    Console.print("  Index: ");
+    if (!index_valid) {
+        Console.println("none (created by 'scrub on' or 'scrub rebuild')");
+        return;
+    }
+    Console.print(SCRUB_REGION_COUNT);
+    Console.print(" x ");
+    Console.print(SCRUB_REGION_SIZE);
+    Console.print(" B regions (0x0000-0x");
+    Console.print(SCRUB_INDEX_ADDR - 1, HEX);
+    Console.print("), stored at 0x");
+    Console.println(SCRUB_INDEX_ADDR, HEX);
+    
+    uint16_t pending = 0;
+    for (uint16_t region = 0; region < SCRUB_REGION_COUNT; region++) {
+        if (region_crc[region] == SCRUB_CRC_STALE) pending++;
+    }
+    
+    if (enabled) {
+        unsigned long elapsed_ms = millis() - enabled_at_ms;
+        Console.print("  Checked: ");
+        Console.print(regions_checked);
+        Console.print(" regions, ");
+        Console.print(passes);
+        Console.print(" full pass(es) in ");
+        Console.print(elapsed_ms / 1000);
+        Console.print(" s (");
+        Console.print(elapsed_ms > 0 ? regions_checked * 1000.0f / elapsed_ms : 0.0f, 1);
+        Console.println(" regions/s)");
+        Console.print("  Longest slice: ");
+        Console.print(slice_max_us);
+        Console.println(" us");
+        Console.print("  Position: region ");
+        Console.println(current_region);
+    }
+    Console.print("  Re-baseline pending: ");
+    Console.println(pending);
+    
+    Console.print("  Mismatches: ");
+    Console.println(mismatch_count);
+    for (uint8_t i = 0; i < mismatch_count; i++) {
+        const ScrubMismatch& m = mismatches[i];
+        Console.print("    Region ");
+        Console.print(m.region);
+        Console.print(" (0x");
+        Console.print(m.region * SCRUB_REGION_SIZE, HEX);
+        Console.print("): expected ");
+        Console.print(m.expected_crc, HEX);
+        Console.print(", read ");
+        Console.print(m.actual_crc, HEX);
+        Console.print(", first seen ");
+        Console.print(m.first_seen_ms / 1000);
+        Console.print(" s after boot, ");
+        Console.print(m.count);
+        Console.println(" time(s)");
+    }
+}
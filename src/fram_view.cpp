@@ -0,0 +1,22 @@
+#include "fram_view.h"
+#include "fram_scrub.h"
+#include <Adafruit_FRAM_I2C.h>
+
+bool framViewRead(const FRAMDevice& dev, uint16_t addr, uint8_t* data, size_t len) {
+    if ((size_t)addr + len > FRAM_SIZE) {
+        return false;
+    }
+    return dev.fram->read(addr, data, len);
+}
+
+bool framViewWrite(const FRAMDevice& dev, uint16_t addr, const uint8_t* data, size_t len) {
+    if ((size_t)addr + len > FRAM_SIZE) {
+        return false;
+    }
+    
+    if (dev.fram == &fram) {
+        scrubNoteWrite(addr, len);
+    }
+    // Cast away const for fram.write (it doesn't modify the data)
+    return dev.fram->write(addr, (uint8_t*)data, len);
+}
@@ -0,0 +1,105 @@
+#include "gang_programmer.h"
+#include "encryption.h"
+#include "core1_worker.h"
+#include "console_out.h"
+
+// Encryption work item handed to core 1
+struct EncryptJob {
+    const DeviceCredentials* creds;
+    CredentialRecord* out;
+    bool ok;
+    unsigned long elapsed_us;
+};
+
+static void encryptJob(void* arg) {
+    EncryptJob* job = (EncryptJob*)arg;
+    unsigned long start = micros();
+    job->ok = encryptCredentials(*job->creds, *job->out);
+    job->elapsed_us = micros() - start;
+}
+
+uint8_t programGang(const FRAMDevice* devices, const DeviceCredentials* records,
+                    uint8_t count, GangResult* results, unsigned long* total_us) {
+    // Double-buffered staging: core 1 fills one slot while core 0 writes the other
+    static CredentialRecord staging[2];
+    EncryptJob jobs[2];
+    uint8_t verified = 0;
+    
+    unsigned long start = micros();
+    
+    if (count > 0) {
+        jobs[0] = { &records[0], &staging[0], false, 0 };
+        core1Submit(encryptJob, &jobs[0]);
+    }
+    
+    for (uint8_t i = 0; i < count; i++) {
+        // Wait for record i, then immediately start record i+1 on core 1
+        core1Wait();
+        EncryptJob& job = jobs[i % 2];
+        
+        if (i + 1 < count) {
+            EncryptJob& next = jobs[(i + 1) % 2];
+            next = { &records[i + 1], &staging[(i + 1) % 2], false, 0 };
+            core1Submit(encryptJob, &next);
+        }
+        
+        GangResult& result = results[i];
+        result.i2c_addr = devices[i].i2c_addr;
+        result.encrypted = job.ok;
+        result.written = false;
+        result.verified = false;
+        result.encrypt_us = job.elapsed_us;
+        result.write_us = 0;
+        
+        if (!job.ok) {
+            continue;
+        }
+        
+        unsigned long write_start = micros();
+        result.written = writeCredentialsSection(devices[i], *job.out);
+        result.verified = result.written && verifyCredentials(devices[i]);
+        result.write_us = micros() - write_start;
+        
+        if (result.verified) {
+            verified++;
+        }
+    }
+    
+    core1Wait();
+    *total_us = micros() - start;
+    return verified;
+}
+
+void printGangReport(const DeviceCredentials* records, const GangResult* results,
+                     uint8_t count, unsigned long total_us) {
+    uint8_t passed = 0;
+    
+    Console.println();
+    Console.println("=== GANG RESULTS ===");
+    Console.println("  #  Addr  Device Name                      Encrypt   Write+Verify  Result");
+    
+    for (uint8_t i = 0; i < count; i++) {
+        const GangResult& r = results[i];
+        char line[128];
+        const char* status = r.verified ? "PASS"
+                           : !r.encrypted ? "FAIL (encrypt)"
+                           : !r.written ? "FAIL (write)"
+                           : "FAIL (verify)";
+        snprintf(line, sizeof(line), "  %u  0x%02X  %-32s %5lu ms  %8lu ms   %s",
+                 (unsigned)(i + 1), r.i2c_addr, records[i].device_name.c_str(),
+                 r.encrypt_us / 1000, r.write_us / 1000, status);
+        Console.println(line);
+        
+        if (r.verified) passed++;
+    }
+    
+    Console.print("Total: ");
+    Console.print(passed);
+    Console.print("/");
+    Console.print(count);
+    Console.print(" chips programmed in ");
+    Console.print(total_us / 1000);
+    Console.print(" ms (");
+    Console.print(total_us > 0 ? passed * 60000000.0 / total_us : 0.0, 1);
+    Console.println(" units/min)");
+}
@@ -0,0 +1,208 @@
+#include "hex_codec.h"
+#include "console_out.h"
+
+#define HEX_INVALID             0xFF
+
+// Both tables are built at compile time and live in flash
+struct HexTables {
+    char encode[256][2];
+    uint8_t decode[256];
+    
+    constexpr HexTables() : encode(), decode() {
+        const char digits[] = "0123456789ABCDEF";
+        for (int i = 0; i < 256; i++) {
+            encode[i][0] = digits[i >> 4];
+            encode[i][1] = digits[i & 0x0F];
+            decode[i] = HEX_INVALID;
+        }
+        for (int i = 0; i < 10; i++) {
+            decode['0' + i] = i;
+        }
+        for (int i = 0; i < 6; i++) {
+            decode['A' + i] = 10 + i;
+            decode['a' + i] = 10 + i;
+        }
+    }
+};
+
+static constexpr HexTables hex_tables;
+
+size_t hexEncode(const uint8_t* data, size_t len, char* out, char separator) {
+    char* p = out;
+    
+    if (separator == '\0') {
+        for (size_t i = 0; i < len; i++) {
+            memcpy(p, hex_tables.encode[data[i]], 2);
+            p += 2;
+        }
+    } else {
+        for (size_t i = 0; i < len; i++) {
+            memcpy(p, hex_tables.encode[data[i]], 2);
+            p[2] = separator;
+            p += 3;
+        }
+    }
+    
+    *p = '\0';
+    return p - out;
+}
+
+bool hexDecode(const char* hex, size_t hex_len, uint8_t* out, size_t cap,
+               size_t* out_len, size_t* error_pos) {
+    const uint8_t* in = (const uint8_t*)hex;
+    const uint8_t* table = hex_tables.decode;
+    size_t limit = min(hex_len & ~(size_t)1, cap * 2);
+    size_t i = 0;
+    
+    // Eight characters per step; an invalid character sets bit 7 in the OR
+    while (i + 8 <= limit) {
+        uint8_t n0 = table[in[i]],     n1 = table[in[i + 1]];
+        uint8_t n2 = table[in[i + 2]], n3 = table[in[i + 3]];
+        uint8_t n4 = table[in[i + 4]], n5 = table[in[i + 5]];
+        uint8_t n6 = table[in[i + 6]], n7 = table[in[i + 7]];
+        
+        if ((n0 | n1 | n2 | n3 | n4 | n5 | n6 | n7) & 0x80) {
+            break;
+        }
+        
+        uint8_t* o = &out[i / 2];
+        o[0] = (n0 << 4) | n1;
+        o[1] = (n2 << 4) | n3;
+        o[2] = (n4 << 4) | n5;
+        o[3] = (n6 << 4) | n7;
+        i += 8;
+    }
+    
+    // Tail, or the block containing an invalid character
+    for (; i < limit; i += 2) {
+        uint8_t hi = table[in[i]];
+        uint8_t lo = table[in[i + 1]];
+        
+        if ((hi | lo) & 0x80) {
+            *error_pos = (hi & 0x80) ? i : i + 1;
+            return false;
+        }
+        out[i / 2] = (hi << 4) | lo;
+    }
+    
+    if (limit < hex_len) {
+        // More data than fits, or a dangling character at the end
+        *error_pos = (limit == cap * 2) ? limit : hex_len;
+        return false;
+    }
+    
+    *out_len = hex_len / 2;
+    return true;
+}
+
+bool hexParseNumber(const char* hex, size_t hex_len, uint32_t* value) {
+    if (hex_len == 0 || hex_len > 8) {
+        return false;
+    }
+    
+    uint32_t result = 0;
+    for (size_t i = 0; i < hex_len; i++) {
+        uint8_t nibble = hex_tables.decode[(uint8_t)hex[i]];
+        if (nibble == HEX_INVALID) {
+            return false;
+        }
+        result = (result << 4) | nibble;
+    }
+    
+    *value = result;
+    return true;
+}
+
+void printHex(const uint8_t* data, size_t len, char separator) {
+    size_t width = separator ? 3 : 2;
+    
+    // Encode straight into the console buffer, 32 bytes at a time
+    for (size_t offset = 0; offset < len; offset += 32) {
+        size_t chunk = min((size_t)32, len - offset);
+        char* out = Console.reserve(width * chunk + 1);
+        Console.commit(hexEncode(&data[offset], chunk, out, separator));
+    }
+}
+
+void printHexLine(const char* prefix, const uint8_t* data, size_t len) {
+    size_t prefix_len = strlen(prefix);
+    char* line = nullptr;
+    
+    if (prefix_len <= 16 && len <= HEX_LINE_MAX_BYTES) {
+        line = Console.reserve(prefix_len + 2 * len + 3);
+    }
+    if (!line) {
+        Console.print(prefix);
+        printHex(data, len);
+        Console.println();
+        return;
+    }
+    
+    // Built in place in the console buffer: prefix, hex, CRLF
+    memcpy(line, prefix, prefix_len);
+    size_t n = prefix_len + hexEncode(data, len, &line[prefix_len]);
+    line[n++] = '\r';
+    line[n++] = '\n';
+    Console.commit(n);
+}
+
+bool testHexCodec() {
+    uint8_t bytes[256];
+    for (int i = 0; i < 256; i++) {
+        bytes[i] = i;
+    }
+    
+    // Round trip of every byte value, and lowercase input
+    static char text[2 * 256 + 1];
+    uint8_t decoded[256];
+    size_t decoded_len = 0;
+    size_t error_pos = 0;
+    
+    size_t text_len = hexEncode(bytes, sizeof(bytes), text);
+    bool round_trip = text_len == 512 &&
+                      hexDecode(text, text_len, decoded, sizeof(decoded), &decoded_len, &error_pos) &&
+                      decoded_len == 256 && memcmp(bytes, decoded, 256) == 0;
+    
+    bool lowercase = hexDecode("deadbeef", 8, decoded, 4, &decoded_len, &error_pos) &&
+                     decoded[0] == 0xDE && decoded[3] == 0xEF;
+    
+    // Error positions: bad character in the fast and slow paths, odd length, overflow
+    bool errors = !hexDecode("0123456789ABCDEG", 16, decoded, 8, &decoded_len, &error_pos) && error_pos == 15;
+    errors = errors && !hexDecode("12x4", 4, decoded, 2, &decoded_len, &error_pos) && error_pos == 2;
+    errors = errors && !hexDecode("123", 3, decoded, 2, &decoded_len, &error_pos) && error_pos == 3;
+    errors = errors && !hexDecode("112233", 6, decoded, 2, &decoded_len, &error_pos) && error_pos == 4;
+    
+    Console.print("  Round trip: "); Console.print(round_trip ? "OK" : "FAIL");
+    Console.print(", lowercase: "); Console.print(lowercase ? "OK" : "FAIL");
+    Console.print(", error positions: "); Console.println(errors ? "OK" : "FAIL");
+    
+    // Timing: table encoder vs per-byte snprintf, same 1 KB. The comparison with
+    // the old Serial.print path is on the host (test/test_hex_codec)
+    const int rounds = 4;
+    unsigned long start_us = micros();
+    for (int r = 0; r < rounds; r++) {
+        for (int i = 0; i < 256; i++) {
+            snprintf(&text[i * 2], 3, "%02X", bytes[i]);
+        }
+    }
+    unsigned long per_byte_us = micros() - start_us;
+    
+    start_us = micros();
+    for (int r = 0; r < rounds; r++) {
+        hexEncode(bytes, sizeof(bytes), text);
+    }
+    unsigned long table_us = micros() - start_us;
+    
+    start_us = micros();
+    for (int r = 0; r < rounds; r++) {
+        hexDecode(text, text_len, decoded, sizeof(decoded), &decoded_len, &error_pos);
+    }
+    unsigned long decode_us = micros() - start_us;
+    
+    Console.print("  Encode 1 KB: snprintf "); Console.print(per_byte_us);
+    Console.print(" us, table "); Console.print(table_us);
+    Console.print(" us; decode 1 KB: "); Console.print(decode_us);
+    Console.println(" us");
+    
+    return round_trip && lowercase && errors;
+}
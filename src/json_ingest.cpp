@@ -0,0 +1,317 @@
+#include "json_ingest.h"
+#include "encryption.h"
+#include "serial_line.h"
+#include "console_out.h"
+
+static StaticJsonDocument<JSON_INGEST_DOC_SIZE> doc;
+static StaticJsonDocument<JSON_OBJECT_SIZE(5)> filter;
+static bool filter_ready = false;
+
+// ArduinoJson custom reader over the console ring: bounded length, and the
+// prompt idle timeout applies between bytes
+class ConsoleJsonReader {
+public:
+    size_t count = 0;
+    bool timed_out = false;
+    bool too_long = false;
+    
+    int read() {
+        if (count >= JSON_INGEST_MAX_BYTES) {
+            too_long = true;
+            return -1;
+        }
+        
+        int c = waitByte(serialPromptTimeout());
+        if (c < 0) {
+            timed_out = true;
+            return -1;
+        }
+        count++;
+        return c;
+    }
+    
+    size_t readBytes(char* buffer, size_t length) {
+        size_t n = 0;
+        while (n < length) {
+            int c = read();
+            if (c < 0) {
+                break;
+            }
+            buffer[n++] = (char)c;
+        }
+        return n;
+    }
+    
+    // Next byte within timeout_ms of idle input (0 = no limit); -1 on timeout
+    static int waitByte(unsigned long timeout_ms) {
+        unsigned long start = millis();
+        int c;
+        while ((c = serialReadByte()) < 0) {
+            if (timeout_ms > 0 && millis() - start >= timeout_ms) {
+                return -1;
+            }
+            delay(1);
+        }
+        return c;
+    }
+    
+    static int waitPeek(unsigned long timeout_ms) {
+        unsigned long start = millis();
+        int c;
+        while ((c = serialPeekByte()) < 0) {
+            if (timeout_ms > 0 && millis() - start >= timeout_ms) {
+                return -1;
+            }
+            delay(1);
+        }
+        return c;
+    }
+};
+
+static void buildFilter() {
+    if (filter_ready) {
+        return;
+    }
+    filter["device_name"] = true;
+    filter["wifi_ssid"] = true;
+    filter["wifi_password"] = true;
+    filter["admin_password"] = true;
+    filter["vps_token"] = true;
+    filter_ready = true;
+}
+
+// Drop the rest of the current line; returns false if it held more than whitespace
+static bool discardLine(unsigned long timeout_ms) {
+    bool clean = true;
+    int c;
+    while ((c = ConsoleJsonReader::waitByte(timeout_ms)) >= 0) {
+        if (c == '\n' || c == '\r') {
+            break;
+        }
+        if (c != ' ' && c != '\t') {
+            clean = false;
+        }
+    }
+    return clean;
+}
+
+static bool memberText(const char* key, const char** text, size_t* len) {
+    *text = doc[key].as<const char*>();
+    if (!*text) {
+        Console.print("Missing or non-string JSON field: ");
+        Console.println(key);
+        return false;
+    }
+    *len = strlen(*text);
+    return true;
+}
+
+// Validate the five values inside the document, then copy each one once
+static bool takeCredentials(DeviceCredentials& creds) {
+    const char* name; const char* ssid; const char* password; const char* admin; const char* token;
+    size_t name_len, ssid_len, password_len, admin_len, token_len;
+    
+    if (!memberText("device_name", &name, &name_len) || !memberText("wifi_ssid", &ssid, &ssid_len) ||
+        !memberText("wifi_password", &password, &password_len) ||
+        !memberText("admin_password", &admin, &admin_len) || !memberText("vps_token", &token, &token_len)) {
+        return false;
+    }
+    
+    if (!validateDeviceName(name, name_len) || !validateWiFiSSID(ssid, ssid_len) ||
+        !validateWiFiPassword(password, password_len) || !validateAdminPassword(admin, admin_len) ||
+        !validateVPSToken(token, token_len)) {
+        return false;
+    }
+    
+    creds.device_name.assign(name, name_len);
+    creds.wifi_ssid.assign(ssid, ssid_len);
+    creds.wifi_password.assign(password, password_len);
+    creds.admin_password.assign(admin, admin_len);
+    creds.vps_token.assign(token, token_len);
+    return true;
+}
+
+static bool reportParseError(const DeserializationError& error) {
+    if (error == DeserializationError::NoMemory) {
+        Console.println("JSON parsing error: a credential value exceeds its length limit");
+    } else {
+        Console.print("JSON parsing error: ");
+        Console.println(error.c_str());
+    }
+    return false;
+}
+
+JsonIngestResult readJSONCredentials(DeviceCredentials& creds, bool allow_end, JsonIngestStats* stats) {
+    buildFilter();
+    
+    // Skip blank lines and the line ending left by the previous line
+    int c;
+    while ((c = ConsoleJsonReader::waitPeek(serialPromptTimeout())) >= 0 &&
+           (c == ' ' || c == '\t' || c == '\r' || c == '\n')) {
+        serialReadByte();
+    }
+    if (c < 0) {
+        Console.println();
+        Console.println("WARNING: No input - timed out");
+        return JSON_INGEST_TIMEOUT;
+    }
+    
+    if (c != '{') {
+        char word[4];
+        size_t len = 0;
+        while ((c = ConsoleJsonReader::waitPeek(JSON_INGEST_EOL_WAIT_MS)) >= 0 &&
+               c != ' ' && c != '\r' && c != '\n') {
+            serialReadByte();
+            if (len < sizeof(word)) {
+                word[len] = (char)c;
+            }
+            len++;
+        }
+        bool clean = discardLine(JSON_INGEST_EOL_WAIT_MS);
+        
+        if (allow_end && clean && len == 3 && strncasecmp(word, "END", 3) == 0) {
+            Console.println("END");
+            return JSON_INGEST_END;
+        }
+        Console.println();
+        Console.println("Expected a JSON object");
+        return JSON_INGEST_INVALID;
+    }
+    
+    unsigned long start = micros();
+    ConsoleJsonReader reader;
+    DeserializationError error = deserializeJson(doc, reader, DeserializationOption::Filter(filter));
+    
+    if (stats) {
+        stats->bytes = reader.count;
+        stats->doc_used = doc.memoryUsage();
+    }
+    
+    Console.println();
+    JsonIngestResult result = JSON_INGEST_INVALID;
+    if (reader.timed_out) {
+        Console.println("WARNING: Record incomplete - timed out");
+        result = JSON_INGEST_TIMEOUT;
+    } else if (reader.too_long) {
+        discardLine(JSON_INGEST_EOL_WAIT_MS);
+        Console.print("JSON record longer than ");
+        Console.print(JSON_INGEST_MAX_BYTES);
+        Console.println(" bytes");
+    } else {
+        if (!discardLine(JSON_INGEST_EOL_WAIT_MS)) {
+            Console.println("WARNING: Text after the JSON object ignored");
+        }
+        if (error) {
+            reportParseError(error);
+        } else if (takeCredentials(creds)) {
+            result = JSON_INGEST_OK;
+        }
+    }
+    
+    // Nothing from this record is visible to the next one
+    doc.clear();
+    
+    if (stats) {
+        stats->elapsed_us = micros() - start;
+    }
+    return result;
+}
+
+bool parseJSONCredentials(const char* json, size_t len, DeviceCredentials& creds, JsonIngestStats* stats) {
+    buildFilter();
+    
+    unsigned long start = micros();
+    DeserializationError error = deserializeJson(doc, json, len, DeserializationOption::Filter(filter));
+    
+    if (stats) {
+        stats->bytes = len;
+        stats->doc_used = doc.memoryUsage();
+    }
+    
+    bool ok = error ? reportParseError(error) : takeCredentials(creds);
+    doc.clear();
+    
+    if (stats) {
+        stats->elapsed_us = micros() - start;
+    }
+    return ok;
+}
+
+void printJSONIngestStats(const JsonIngestStats& stats, size_t records) {
+    Console.print("Ingest: ");
+    Console.print(records);
+    Console.print(" record(s), ");
+    Console.print(stats.bytes);
+    Console.print(" bytes parsed in ");
+    Console.print(stats.elapsed_us);
+    Console.print(" us, document peak ");
+    Console.print(stats.doc_used);
+    Console.print("/");
+    Console.print(JSON_INGEST_DOC_SIZE);
+    Console.println(" bytes");
+}
+
+// Append a JSON string member of 'len' copies of 'fill' (one escaped quote first if quote)
+static size_t appendMember(char* buf, size_t pos, const char* key, char fill, size_t len, bool quote) {
+    pos += sprintf(&buf[pos], "%s\"%s\":\"", pos > 1 ? "," : "", key);
+    for (size_t i = 0; i < len; i++) {
+        if (quote && i == 0) {
+            buf[pos++] = '\\';
+            buf[pos++] = '"';
+        } else {
+            buf[pos++] = fill;
+        }
+    }
+    buf[pos++] = '"';
+    return pos;
+}
+
+bool testJSONIngest() {
+    static char json[JSON_INGEST_MAX_BYTES];
+    
+    // Every field at its limit, plus an unknown key the filter must drop
+    size_t pos = 0;
+    json[pos++] = '{';
+    pos = appendMember(json, pos, "notes", 'x', 600, false);
+    pos = appendMember(json, pos, "device_name", 'N', MAX_DEVICE_NAME_LEN, false);
+    pos = appendMember(json, pos, "wifi_ssid", 'S', MAX_WIFI_SSID_LEN, false);
+    pos = appendMember(json, pos, "wifi_password", 'P', MAX_WIFI_PASSWORD_LEN, true);
+    pos = appendMember(json, pos, "admin_password", 'A', MAX_ADMIN_PASSWORD_LEN, false);
+    pos = appendMember(json, pos, "vps_token", 'T', MAX_VPS_TOKEN_LEN, false);
+    json[pos++] = '}';
+    
+    DeviceCredentials creds;
+    JsonIngestStats stats;
+    bool parsed = parseJSONCredentials(json, pos, creds, &stats);
+    bool values = parsed &&
+                  creds.device_name.length() == MAX_DEVICE_NAME_LEN &&
+                  creds.wifi_ssid.length() == MAX_WIFI_SSID_LEN &&
+                  creds.wifi_password.length() == MAX_WIFI_PASSWORD_LEN &&
+                  creds.wifi_password.charAt(0) == '"' &&
+                  creds.admin_password.length() == MAX_ADMIN_PASSWORD_LEN &&
+                  creds.vps_token.length() == MAX_VPS_TOKEN_LEN &&
+                  stats.doc_used <= JSON_INGEST_DOC_SIZE;
+    
+    Console.print("  Max-size record: ");
+    Console.print(pos);
+    Console.print(" bytes in ");
+    Console.print(stats.elapsed_us);
+    Console.print(" us, document ");
+    Console.print(stats.doc_used);
+    Console.print("/");
+    Console.print(JSON_INGEST_DOC_SIZE);
+    Console.println(" bytes");
+    
+    // One character over the token limit must be refused
+    pos -= 2;
+    json[pos++] = 'T';
+    json[pos++] = '"';
+    json[pos++] = '}';
+    Console.print("  Over-limit token: ");
+    bool rejected = !parseJSONCredentials(json, pos, creds, nullptr);
+    if (!rejected) {
+        Console.println("accepted");
+    }
+    
+    return values && rejected;
+}
\ No newline at end of file
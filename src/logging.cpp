@@ -0,0 +1,44 @@
+#include "logging.h"
+#include "hex_codec.h"
+
+uint8_t log_runtime_level = LOG_COMPILED_LEVEL;
+
+static const char* const LEVEL_NAMES[] = { "none", "error", "warn", "info", "debug", "verbose" };
+
+void logHexRows(const char* tag, const char* label, const uint8_t* data, size_t len) {
+    Console.print(tag);
+    Console.println(label);
+    for (size_t row = 0; row < len; row += 16) {
+        Console.print("  ");
+        printHex(&data[row], min((size_t)16, len - row), ' ');
+        Console.println();
+    }
+}
+
+uint8_t logLevel() {
+    return log_runtime_level;
+}
+
+uint8_t setLogLevel(uint8_t level) {
+    log_runtime_level = min(level, (uint8_t)LOG_COMPILED_LEVEL);
+    return log_runtime_level;
+}
+
+const char* logLevelName(uint8_t level) {
+    return level <= LOG_LEVEL_VERBOSE ? LEVEL_NAMES[level] : "?";
+}
+
+bool parseLogLevel(const char* text, uint8_t* level) {
+    if (text[0] >= '0' && text[0] <= '5' && text[1] == '\0') {
+        *level = text[0] - '0';
+        return true;
+    }
+    
+    for (uint8_t i = 0; i <= LOG_LEVEL_VERBOSE; i++) {
+        if (strcasecmp(text, LEVEL_NAMES[i]) == 0) {
+            *level = i;
+            return true;
+        }
+    }
+    return false;
+}
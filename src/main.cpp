@@ -2,6 +2,10 @@
 #include <Wire.h>
 #include "fram_programmer.h"
 #include "cli_handler.h"
+#include "fram_scrub.h"
+#include "partition_table.h"
+#include "serial_line.h"
+#include "console_out.h"
 
 void setup() {
     // Initialize serial communication
@@ -14,40 +18,42 @@ void setup() {
     }
     
     // Print startup banner
-    Serial.println();
-    Serial.println("========================================");
-    Serial.println("    FRAM Programmer v1.0");
-    Serial.println("    Beetle RP2350 ESP32 Credentials");
-    Serial.println("========================================");
-    Serial.println();
+    Console.println();
+    Console.println("========================================");
+    Console.println("    FRAM Programmer v1.0");
+    Console.println("    Beetle RP2350 ESP32 Credentials");
+    Console.println("========================================");
+    Console.println();
     
     // Initialize I2C with custom pins for RP2350
     Wire.setSDA(SDA_PIN);
     Wire.setSCL(SCL_PIN);
     Wire.begin();
-    Wire.setClock(100000); // 100kHz for FRAM compatibility
+    Wire.setClock(FRAM_I2C_CLOCK); // 100kHz for FRAM compatibility
     
-    Serial.print("I2C initialized (SDA=");
-    Serial.print(SDA_PIN);
-    Serial.print(", SCL=");
-    Serial.print(SCL_PIN);
-    Serial.println(")");
+    Console.print("I2C initialized (SDA=");
+    Console.print(SDA_PIN);
+    Console.print(", SCL=");
+    Console.print(SCL_PIN);
+    Console.println(")");
     
     // Initialize FRAM
-    Serial.print("Initializing FRAM... ");
+    Console.print("Initializing FRAM... ");
     if (initFRAM()) {
-        Serial.println("SUCCESS");
+        Console.println("SUCCESS");
         printFRAMInfo();
+        initPartitions();
+        initScrub();
     } else {
-        Serial.println("FAILED");
-        Serial.println("WARNING: FRAM not detected. Some commands may not work.");
+        Console.println("FAILED");
+        Console.println("WARNING: FRAM not detected. Some commands may not work.");
     }
     
     // Initialize CLI
     initCLI();
     
-    Serial.println();
-    Serial.println("Ready! Type 'help' for available commands.");
+    Console.println();
+    Console.println("Ready! Type 'help' for available commands.");
     printPrompt();
 }
 
@@ -55,6 +61,11 @@ void loop() {
     // Handle CLI commands
     handleCLI();
     
-    // Small delay to prevent overwhelming the system
-    delay(10);
+    // Verify a slice of FRAM against the scrub index while idle
+    scrubSlice();
+    
+    // Sleep only when idle: input is drained as soon as it arrives
+    if (!serialInputPending()) {
+        delay(1);
+    }
 }
\ No newline at end of file
@@ -0,0 +1,175 @@
+#include "merkle_tree.h"
+#include "hex_codec.h"
+#include "console_out.h"
+#include <Adafruit_FRAM_I2C.h>
+
+static void printHash(const uint8_t* hash) {
+    printHex(hash, MERKLE_HASH_SIZE);
+}
+
+bool buildMerkleTree(MerkleTree& tree, uint16_t start, size_t size, size_t leaf_size) {
+    tree.valid = false;
+    
+    if (size == 0 || (size_t)start + size > FRAM_SIZE) {
+        Console.println("ERROR: Merkle region outside FRAM");
+        return false;
+    }
+    
+    if (leaf_size < MERKLE_MIN_LEAF || leaf_size > MERKLE_MAX_LEAF ||
+        (leaf_size & (leaf_size - 1)) != 0) {
+        Console.println("ERROR: Leaf size must be a power of two between 32 and 4096");
+        return false;
+    }
+    
+    size_t leaf_count = (size + leaf_size - 1) / leaf_size;
+    if (leaf_count > MERKLE_MAX_LEAVES) {
+        Console.println("ERROR: Too many leaves - use a larger leaf size");
+        return false;
+    }
+    
+    // Level sizes bottom-up, then lay the levels out in the node array with
+    // the leaves first so each parent level is built from the one before it
+    size_t counts[MERKLE_MAX_LEVELS];
+    uint8_t levels = 0;
+    size_t count = leaf_count;
+    while (true) {
+        counts[levels++] = count;
+        if (count == 1) break;
+        count = (count + 1) / 2;
+    }
+    
+    size_t offset = 0;
+    for (uint8_t i = 0; i < levels; i++) {
+        uint8_t depth = levels - 1 - i;
+        tree.level_offset[depth] = offset;
+        tree.level_count[depth] = counts[i];
+        offset += counts[i];
+    }
+    
+    tree.start = start;
+    tree.size = size;
+    tree.leaf_size = leaf_size;
+    tree.leaf_count = leaf_count;
+    tree.levels = levels;
+    
+    // Leaves: hash each leaf as it is read, one bulk chunk at a time
+    static const uint8_t leaf_prefix = 0x00;
+    static const uint8_t node_prefix = 0x01;
+    uint8_t buffer[FRAM_BULK_CHUNK_SIZE];
+    
+    for (size_t leaf = 0; leaf < leaf_count; leaf++) {
+        size_t leaf_start = leaf * leaf_size;
+        size_t leaf_len = min(leaf_size, size - leaf_start);
+        
+        SHA256 sha;
+        sha.update(&leaf_prefix, 1);
+        for (size_t done = 0; done < leaf_len; ) {
+            size_t chunk = min((size_t)FRAM_BULK_CHUNK_SIZE, leaf_len - done);
+            if (!fram.read(start + leaf_start + done, buffer, chunk)) {
+                Console.println("ERROR: FRAM read failed");
+                return false;
+            }
+            sha.update(buffer, chunk);
+            done += chunk;
+        }
+        sha.final(tree.nodes[tree.level_offset[levels - 1] + leaf]);
+    }
+    
+    // Interior levels, bottom-up
+    for (int depth = levels - 2; depth >= 0; depth--) {
+        size_t child_offset = tree.level_offset[depth + 1];
+        size_t child_count = tree.level_count[depth + 1];
+        
+        for (size_t i = 0; i < tree.level_count[depth]; i++) {
+            uint8_t* node = tree.nodes[tree.level_offset[depth] + i];
+            const uint8_t* left = tree.nodes[child_offset + 2 * i];
+            
+            if (2 * i + 1 >= child_count) {
+                memcpy(node, left, MERKLE_HASH_SIZE);
+                continue;
+            }
+            
+            SHA256 sha;
+            sha.update(&node_prefix, 1);
+            sha.update(left, MERKLE_HASH_SIZE);
+            sha.update(tree.nodes[child_offset + 2 * i + 1], MERKLE_HASH_SIZE);
+            sha.final(node);
+        }
+    }
+    
+    tree.valid = true;
+    return true;
+}
+
+const uint8_t* getMerkleNode(const MerkleTree& tree, size_t depth, size_t index) {
+    if (!tree.valid || depth >= tree.levels || index >= tree.level_count[depth]) {
+        return nullptr;
+    }
+    return tree.nodes[tree.level_offset[depth] + index];
+}
+
+void printMerkleSummary(const MerkleTree& tree) {
+    Console.println("MERKLE_START");
+    Console.print("REGION:");
+    Console.print(tree.start, HEX);
+    Console.print(":");
+    Console.println(tree.size);
+    Console.print("LEAF_SIZE:");
+    Console.println(tree.leaf_size);
+    Console.print("LEAVES:");
+    Console.println(tree.leaf_count);
+    Console.print("DEPTH:");
+    Console.println(tree.levels - 1);
+    Console.print("ROOT:");
+    printHash(getMerkleNode(tree, 0, 0));
+    Console.println();
+    Console.println("MERKLE_END");
+}
+
+bool printMerkleNode(const MerkleTree& tree, size_t depth, size_t index) {
+    const uint8_t* node = getMerkleNode(tree, depth, index);
+    if (node == nullptr) {
+        Console.println("ERROR: No such node");
+        return false;
+    }
+    
+    Console.print("NODE:");
+    Console.print(depth);
+    Console.print(":");
+    Console.print(index);
+    Console.print(":");
+    printHash(node);
+    Console.println();
+    
+    if (depth == tree.levels - 1) {
+        // Leaf: send its contents so the host can see the actual difference
+        size_t leaf_start = index * tree.leaf_size;
+        size_t leaf_len = min(tree.leaf_size, tree.size - leaf_start);
+        uint8_t buffer[64];
+        
+        for (size_t done = 0; done < leaf_len; done += sizeof(buffer)) {
+            size_t chunk = min(sizeof(buffer), leaf_len - done);
+            uint16_t addr = tree.start + leaf_start + done;
+            if (!fram.read(addr, buffer, chunk)) {
+                Console.println("ERROR: FRAM read failed");
+                return false;
+            }
+            printBackupChunk(addr, buffer, chunk);
+        }
+        return true;
+    }
+    
+    for (size_t child = 2 * index; child <= 2 * index + 1; child++) {
+        const uint8_t* hash = getMerkleNode(tree, depth + 1, child);
+        if (hash == nullptr) break;
+        
+        Console.print("CHILD:");
+        Console.print(depth + 1);
+        Console.print(":");
+        Console.print(child);
+        Console.print(":");
+        printHash(hash);
+        Console.println();
+    }
+    return true;
+}
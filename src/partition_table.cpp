@@ -0,0 +1,308 @@
+#include "partition_table.h"
+#include "crc32.h"
+#include "fram_scrub.h"
+#include "console_out.h"
+#include <Adafruit_FRAM_I2C.h>
+
+static_assert(sizeof(PartitionEntry) == 20, "PartitionEntry layout changed");
+static_assert(PART_TABLE_ADDR + sizeof(Superblock) <= FRAM_SIZE - 2,
+              "Superblock overlaps the init probe byte");
+
+// RAM copy of the superblock of the chip last read; every lookup below works from it
+static Superblock table;
+static bool loaded = false;
+
+// Default map: what the firmware already uses, with the gaps left unallocated
+static const PartitionEntry default_partitions[] = {
+    { "boot",     0x0000, 0x0018, PART_TYPE_SYSTEM,      PART_FLAG_BACKUP,                  0, 0 },
+    { "creds",    0x0018, 0x0400, PART_TYPE_CREDENTIALS, PART_FLAG_BACKUP | PART_FLAG_WIPE, 0, 0 },
+    { "profile",  0x0420, 0x61E0, PART_TYPE_PROFILES,    PART_FLAG_BACKUP | PART_FLAG_WIPE, 0, 0 },
+    { "scratch",  0x7000, 0x0C00, PART_TYPE_SCRATCH,     PART_FLAG_WIPE,                    0, 0 },
+    { "scrub",    0x7C00, 0x0200, PART_TYPE_SYSTEM,      0,                                 0, 0 },
+    { "super",    0x7E00, 0x0100, PART_TYPE_SYSTEM,      0,                                 0, 0 },
+    { "probe",    0x7FFE, 0x0002, PART_TYPE_SYSTEM,      0,                                 0, 0 },
+};
+
+static uint32_t tableCRC(const Superblock& sb) {
+    return crc32((const uint8_t*)sb.entries, sb.count * sizeof(PartitionEntry));
+}
+
+static bool nameEquals(const PartitionEntry& entry, const char* name) {
+    size_t len = strlen(name);
+    return len <= PART_NAME_LEN && strncmp(entry.name, name, PART_NAME_LEN) == 0 &&
+           (len == PART_NAME_LEN || entry.name[len] == '\0');
+}
+
+// Entries must lie inside FRAM and must not overlap each other
+static bool validTable(const Superblock& sb) {
+    if (sb.magic != PART_TABLE_MAGIC || sb.version != PART_TABLE_VERSION ||
+        sb.count == 0 || sb.count > PART_MAX || sb.table_crc != tableCRC(sb)) {
+        return false;
+    }
+    
+    for (uint8_t i = 0; i < sb.count; i++) {
+        const PartitionEntry& a = sb.entries[i];
+        if (a.length == 0 || (size_t)a.offset + a.length > FRAM_SIZE) {
+            return false;
+        }
+        for (uint8_t j = i + 1; j < sb.count; j++) {
+            const PartitionEntry& b = sb.entries[j];
+            if (a.offset < b.offset + b.length && b.offset < a.offset + a.length) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static bool writeTable(Superblock& sb) {
+    sb.table_crc = tableCRC(sb);
+    if (!validTable(sb)) {
+        Console.println("ERROR: Partition table is inconsistent");
+        return false;
+    }
+    
+    scrubNoteWrite(PART_TABLE_ADDR, sizeof(sb));
+    fram.write(PART_TABLE_ADDR, (uint8_t*)&sb, sizeof(sb));
+    
+    Superblock check;
+    fram.read(PART_TABLE_ADDR, (uint8_t*)&check, sizeof(check));
+    if (memcmp(&check, &sb, sizeof(sb)) != 0) {
+        Console.println("ERROR: Superblock write verification failed");
+        return false;
+    }
+    return true;
+}
+
+bool reloadPartitions() {
+    loaded = fram.read(PART_TABLE_ADDR, (uint8_t*)&table, sizeof(table)) && validTable(table);
+    return loaded;
+}
+
+bool initPartitions() {
+    reloadPartitions();
+    
+    Console.print("Partition table: ");
+    if (loaded) {
+        Console.print(table.count);
+        Console.println(" partition(s)");
+    } else {
+        Console.println("none (whole FRAM treated as in use, see 'part init')");
+    }
+    return loaded;
+}
+
+bool partitionsLoaded() {
+    return loaded;
+}
+
+const Superblock& partitionTable() {
+    return table;
+}
+
+const PartitionEntry* findPartition(const char* name) {
+    if (!loaded) return nullptr;
+    
+    for (uint8_t i = 0; i < table.count; i++) {
+        if (nameEquals(table.entries[i], name)) {
+            return &table.entries[i];
+        }
+    }
+    return nullptr;
+}
+
+const PartitionEntry* findPartitionByType(uint8_t type) {
+    if (!loaded) return nullptr;
+    
+    for (uint8_t i = 0; i < table.count; i++) {
+        if (table.entries[i].type == type) {
+            return &table.entries[i];
+        }
+    }
+    return nullptr;
+}
+
+uint8_t partitionRanges(uint8_t flags, ByteRange* ranges, uint8_t max_ranges) {
+    if (!loaded) {
+        if (max_ranges == 0) return 0;
+        ranges[0] = { 0, (uint16_t)FRAM_SIZE };
+        return 1;
+    }
+    
+    // Selection sort by offset (at most PART_MAX entries), merging neighbours
+    uint8_t count = 0;
+    size_t after = 0;
+    while (count < max_ranges) {
+        const PartitionEntry* next = nullptr;
+        for (uint8_t i = 0; i < table.count; i++) {
+            const PartitionEntry& entry = table.entries[i];
+            if ((entry.flags & flags) != flags) continue;
+            if (entry.offset < after) continue;
+            if (next == nullptr || entry.offset < next->offset) next = &entry;
+        }
+        if (next == nullptr) break;
+        
+        if (count > 0 && ranges[count - 1].addr + ranges[count - 1].len == next->offset) {
+            ranges[count - 1].len += next->length;
+        } else {
+            ranges[count++] = { next->offset, next->length };
+        }
+        after = next->offset + next->length;
+    }
+    return count;
+}
+
+bool writeDefaultPartitions() {
+    Superblock sb;
+    memset(&sb, 0, sizeof(sb));
+    sb.magic = PART_TABLE_MAGIC;
+    sb.version = PART_TABLE_VERSION;
+    sb.count = sizeof(default_partitions) / sizeof(default_partitions[0]);
+    memcpy(sb.entries, default_partitions, sizeof(default_partitions));
+    
+    if (!writeTable(sb)) {
+        return false;
+    }
+    
+    table = sb;
+    loaded = true;
+    return true;
+}
+
+bool sealPartitions(const char* name) {
+    if (!loaded) {
+        Console.println("ERROR: No partition table");
+        return false;
+    }
+    
+    Superblock sb = table;
+    uint8_t sealed = 0;
+    for (uint8_t i = 0; i < sb.count; i++) {
+        PartitionEntry& entry = sb.entries[i];
+        bool selected = name ? nameEquals(entry, name) : (entry.flags & PART_FLAG_BACKUP) != 0;
+        if (!selected) continue;
+        
+        uint32_t crc;
+        if (!crcFRAM(entry.offset, entry.length, &crc)) {
+            return false;
+        }
+        entry.crc = crc;
+        entry.flags |= PART_FLAG_SEALED;
+        sealed++;
+    }
+    
+    if (sealed == 0) {
+        Console.println("ERROR: No matching partition");
+        return false;
+    }
+    
+    if (!writeTable(sb)) {
+        return false;
+    }
+    table = sb;
+    
+    Console.print("Sealed ");
+    Console.print(sealed);
+    Console.println(" partition(s)");
+    return true;
+}
+
+static void printName(const PartitionEntry& entry) {
+    char name[PART_NAME_LEN + 1];
+    memcpy(name, entry.name, PART_NAME_LEN);
+    name[PART_NAME_LEN] = '\0';
+    Console.print(name);
+    for (size_t i = strlen(name); i < PART_NAME_LEN + 2; i++) {
+        Console.print(' ');
+    }
+}
+
+bool verifyPartitions() {
+    if (!loaded) {
+        return true;
+    }
+    
+    bool all_ok = true;
+    uint8_t sealed = 0;
+    for (uint8_t i = 0; i < table.count; i++) {
+        const PartitionEntry& entry = table.entries[i];
+        if (!(entry.flags & PART_FLAG_SEALED)) continue;
+        sealed++;
+        
+        uint32_t crc;
+        if (!crcFRAM(entry.offset, entry.length, &crc)) {
+            return false;
+        }
+        
+        Console.print("  ");
+        printName(entry);
+        if (crc == entry.crc) {
+            Console.println("OK");
+        } else {
+            Console.print("CHANGED since seal (0x");
+            Console.print(entry.crc, HEX);
+            Console.print(" -> 0x");
+            Console.print(crc, HEX);
+            Console.println(")");
+            all_ok = false;
+        }
+    }
+    
+    if (sealed == 0) {
+        Console.println("  none sealed (see 'part seal')");
+    }
+    return all_ok;
+}
+
+static const char* typeName(uint8_t type) {
+    switch (type) {
+        case PART_TYPE_SYSTEM:      return "system";
+        case PART_TYPE_CREDENTIALS: return "creds";
+        case PART_TYPE_PROFILES:    return "profiles";
+        case PART_TYPE_SCRATCH:     return "scratch";
+        case PART_TYPE_DATA:        return "data";
+        default:                    return "?";
+    }
+}
+
+void printPartitionTable() {
+    if (!loaded) {
+        Console.println("No partition table (whole FRAM treated as in use)");
+        return;
+    }
+    
+    Console.print("Superblock at 0x");
+    Console.print(PART_TABLE_ADDR, HEX);
+    Console.print(", ");
+    Console.print(table.count);
+    Console.print(" partition(s), table CRC 0x");
+    Console.println(table.table_crc, HEX);
+    Console.println("  Name      Offset  Length  Type      Flags  Sealed CRC");
+    
+    size_t allocated = 0;
+    for (uint8_t i = 0; i < table.count; i++) {
+        const PartitionEntry& entry = table.entries[i];
+        allocated += entry.length;
+        
+        char line[64];
+        snprintf(line, sizeof(line), "0x%04X  %6u  %-8s  %c%c%c    ",
+                 entry.offset, entry.length, typeName(entry.type),
+                 (entry.flags & PART_FLAG_BACKUP) ? 'B' : '-',
+                 (entry.flags & PART_FLAG_WIPE) ? 'W' : '-',
+                 (entry.flags & PART_FLAG_SEALED) ? 'S' : '-');
+        Console.print("  ");
+        printName(entry);
+        Console.print(line);
+        if (entry.flags & PART_FLAG_SEALED) {
+            Console.print("0x");
+            Console.print(entry.crc, HEX);
+        }
+        Console.println();
+    }
+    
+    Console.print("Allocated ");
+    Console.print(allocated);
+    Console.print(" of ");
+    Console.print(FRAM_SIZE);
+    Console.println(" bytes (B=backup, W=wipe, S=sealed)");
+}
@@ -0,0 +1,228 @@
+#include "production_line.h"
+#include "encryption.h"
+#include "serial_line.h"
+#include "console_out.h"
+#include <Adafruit_FRAM_I2C.h>
+
+static const char* stage_names[STAGE_COUNT] = {
+    "prepare", "write", "verify", "handling", "cycle"
+};
+
+// Per-stage timings (ms) for every unit seen in this run
+struct LineStats {
+    unsigned long samples[STAGE_COUNT][LINE_MAX_UNITS];
+    size_t counts[STAGE_COUNT];
+    size_t units;
+    size_t passed;
+};
+
+static void addSample(LineStats& stats, LineStage stage, unsigned long ms) {
+    if (stats.counts[stage] < LINE_MAX_UNITS) {
+        stats.samples[stage][stats.counts[stage]++] = ms;
+    }
+}
+
+// Percentile (0-100) by nearest rank over a sorted copy
+static unsigned long percentile(const unsigned long* samples, size_t count, int pct) {
+    if (count == 0) {
+        return 0;
+    }
+    
+    unsigned long sorted[LINE_MAX_UNITS];
+    memcpy(sorted, samples, count * sizeof(unsigned long));
+    
+    // Insertion sort - at most LINE_MAX_UNITS entries
+    for (size_t i = 1; i < count; i++) {
+        unsigned long value = sorted[i];
+        size_t j = i;
+        while (j > 0 && sorted[j - 1] > value) {
+            sorted[j] = sorted[j - 1];
+            j--;
+        }
+        sorted[j] = value;
+    }
+    
+    size_t rank = (pct * count + 99) / 100;
+    return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+static void printYield(const LineStats& stats) {
+    Console.print("yield=");
+    Console.print(stats.passed);
+    Console.print("/");
+    Console.print(stats.units);
+    Console.print(" (");
+    Console.print(stats.units > 0 ? stats.passed * 100.0 / stats.units : 0.0, 1);
+    Console.print("%)");
+}
+
+static void printLineSummary(const LineStats& stats) {
+    Console.println();
+    Console.println("=== LINE SUMMARY ===");
+    Console.print("Units: ");
+    Console.print(stats.units);
+    Console.print(", ");
+    printYield(stats);
+    Console.println();
+    Console.println("  Stage        n     p50 ms    p90 ms    p99 ms    mean ms");
+    
+    int bottleneck = -1;
+    unsigned long bottleneck_mean = 0;
+    
+    for (int stage = 0; stage < STAGE_COUNT; stage++) {
+        size_t n = stats.counts[stage];
+        unsigned long total = 0;
+        for (size_t i = 0; i < n; i++) {
+            total += stats.samples[stage][i];
+        }
+        unsigned long mean = n > 0 ? total / n : 0;
+        
+        char line[96];
+        snprintf(line, sizeof(line), "  %-10s %3u  %8lu  %8lu  %8lu  %8lu",
+                 stage_names[stage], (unsigned)n,
+                 percentile(stats.samples[stage], n, 50),
+                 percentile(stats.samples[stage], n, 90),
+                 percentile(stats.samples[stage], n, 99),
+                 mean);
+        Console.println(line);
+        
+        // Cycle is the sum of the others, not a stage of its own
+        if (stage != STAGE_CYCLE && n > 0 && mean >= bottleneck_mean) {
+            bottleneck = stage;
+            bottleneck_mean = mean;
+        }
+    }
+    
+    if (bottleneck >= 0) {
+        Console.print("Bottleneck stage: ");
+        Console.print(stage_names[bottleneck]);
+        Console.print(" (mean ");
+        Console.print(bottleneck_mean);
+        Console.println(" ms)");
+    }
+}
+
+// Debounced wait for the fixture to reach the wanted state.
+// Returns false if the operator pressed 'q'.
+static bool waitForChip(bool present) {
+    uint8_t stable = 0;
+    
+    while (stable < LINE_DEBOUNCE_POLLS) {
+        int c;
+        while ((c = serialReadByte()) >= 0) {
+            if (c == 'q' || c == 'Q') {
+                return false;
+            }
+        }
+        
+        stable = (detectFRAM() == present) ? stable + 1 : 0;
+        delay(LINE_POLL_MS);
+    }
+    
+    return true;
+}
+
+void runProductionLine(const DeviceCredentials* records, size_t record_count) {
+    static LineStats stats;
+    memset(&stats, 0, sizeof(stats));
+    
+    static CredentialRecord staged;
+    size_t next_record = 0;
+    size_t staged_record = record_count;     // Record currently held in `staged`
+    unsigned long last_insert_ms = 0;
+    unsigned long removed_ms = millis();
+    
+    Console.println("Line running - insert chips, press 'q' to stop");
+    
+    // Start with an empty fixture so the first unit is a clean insertion
+    if (detectFRAM()) {
+        Console.println("Remove the chip currently in the fixture...");
+        if (!waitForChip(false)) {
+            printLineSummary(stats);
+            return;
+        }
+        removed_ms = millis();
+    }
+    
+    while (next_record < record_count && stats.units < LINE_MAX_UNITS) {
+        // Prepare the next record while the fixture is empty (failed units reuse it)
+        if (staged_record != next_record) {
+            unsigned long start = millis();
+            bool prepared = encryptCredentials(records[next_record], staged);
+            addSample(stats, STAGE_PREPARE, millis() - start);
+            
+            // No chip can take it, and skipping it would shift every
+            // following record onto the wrong chip: stop before asking for one
+            if (!prepared) {
+                Console.print("ERROR: Record ");
+                Console.print(next_record + 1);
+                Console.print(" (");
+                Console.print(records[next_record].device_name.c_str());
+                Console.println(") could not be encrypted - line stopped");
+                break;
+            }
+            staged_record = next_record;
+        }
+        
+        Console.print("Waiting for unit ");
+        Console.print(stats.units + 1);
+        Console.print(" (");
+        Console.print(records[next_record].device_name.c_str());
+        Console.println(")...");
+        
+        if (!waitForChip(true)) {
+            break;
+        }
+        
+        unsigned long insert_ms = millis();
+        addSample(stats, STAGE_HANDLING, insert_ms - removed_ms);
+        if (last_insert_ms != 0) {
+            addSample(stats, STAGE_CYCLE, insert_ms - last_insert_ms);
+        }
+        last_insert_ms = insert_ms;
+        stats.units++;
+        
+        // Rebind the driver to the newly inserted chip
+        bool ok = fram.begin(FRAM_I2C_ADDR);
+        
+        unsigned long start = millis();
+        ok = ok && writeCredentialsSection(staged);
+        unsigned long write_ms = millis() - start;
+        addSample(stats, STAGE_WRITE, write_ms);
+        
+        start = millis();
+        ok = ok && verifyCredentials();
+        unsigned long verify_ms = millis() - start;
+        addSample(stats, STAGE_VERIFY, verify_ms);
+        
+        if (ok) {
+            stats.passed++;
+            next_record++;
+        }
+        
+        Console.print("UNIT ");
+        Console.print(stats.units);
+        Console.print(" ");
+        Console.print(records[staged_record].device_name.c_str());
+        Console.print(ok ? " PASS" : " FAIL");
+        Console.print(" write=");
+        Console.print(write_ms);
+        Console.print("ms verify=");
+        Console.print(verify_ms);
+        Console.print("ms ");
+        printYield(stats);
+        Console.println();
+        
+        if (!ok) {
+            Console.println("Unit failed - record will be reused for the next chip");
+        }
+        
+        Console.println("Remove unit...");
+        if (!waitForChip(false)) {
+            break;
+        }
+        removed_ms = millis();
+    }
+    
+    printLineSummary(stats);
+}
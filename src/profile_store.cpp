@@ -0,0 +1,427 @@
+#include "profile_store.h"
+#include "encryption.h"
+#include "fram_scrub.h"
+#include "console_out.h"
+#include <Adafruit_FRAM_I2C.h>
+
+struct ProfileDirectory {
+    ProfileDirHeader header;
+    ProfileDirEntry entries[PROFILE_SLOTS];
+} __attribute__((packed));
+
+static_assert(PROFILE_DIR_ADDR + sizeof(ProfileDirectory) <= PROFILE_SLOT_ADDR,
+              "Profile directory overlaps the first slot");
+static_assert(PROFILE_SLOT_SIZE >= CRED_V2_MAX_SIZE + CRED_TLV_HEADER_SIZE + PROFILE_NAME_MAX,
+              "Profile slot too small for the largest record");
+
+static uint16_t slotAddress(uint8_t index) {
+    return PROFILE_SLOT_ADDR + (uint16_t)index * PROFILE_SLOT_SIZE;
+}
+
+static uint16_t entryAddress(uint8_t index) {
+    return PROFILE_DIR_ADDR + sizeof(ProfileDirHeader) + index * sizeof(ProfileDirEntry);
+}
+
+uint32_t profileNameHash(const char* name) {
+    // FNV-1a, 32-bit
+    uint32_t hash = 2166136261UL;
+    while (*name) {
+        hash ^= (uint8_t)*name++;
+        hash *= 16777619UL;
+    }
+    return hash;
+}
+
+bool validateProfileName(const String& name) {
+    if (name.length() == 0 || name.length() > PROFILE_NAME_MAX) {
+        Console.print("Profile name length invalid (1-");
+        Console.print(PROFILE_NAME_MAX);
+        Console.println(" characters required)");
+        return false;
+    }
+    
+    for (int i = 0; i < name.length(); i++) {
+        char c = name.charAt(i);
+        if (!isalnum(c) && c != '_' && c != '-') {
+            Console.println("Profile name contains invalid characters (alphanumeric, _ and - only)");
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+// One read of the whole directory; false if it has never been formatted
+static bool readDirectory(ProfileDirectory& dir) {
+    fram.read(PROFILE_DIR_ADDR, (uint8_t*)&dir, sizeof(dir));
+    
+    return dir.header.magic == PROFILE_DIR_MAGIC &&
+           dir.header.version == PROFILE_DIR_VERSION &&
+           dir.header.slots == PROFILE_SLOTS &&
+           dir.header.slot_size == PROFILE_SLOT_SIZE;
+}
+
+static void formatDirectory(ProfileDirectory& dir) {
+    memset(&dir, 0, sizeof(dir));
+    dir.header.magic = PROFILE_DIR_MAGIC;
+    dir.header.version = PROFILE_DIR_VERSION;
+    dir.header.slots = PROFILE_SLOTS;
+    dir.header.slot_size = PROFILE_SLOT_SIZE;
+    
+    scrubNoteWrite(PROFILE_DIR_ADDR, sizeof(dir));
+    fram.write(PROFILE_DIR_ADDR, (uint8_t*)&dir, sizeof(dir));
+}
+
+static void writeEntry(uint8_t index, const ProfileDirEntry& entry) {
+    scrubNoteWrite(entryAddress(index), sizeof(entry));
+    fram.write(entryAddress(index), (uint8_t*)&entry, sizeof(entry));
+}
+
+// Read the record of a used entry and check it belongs to `name`
+static bool readSlot(uint8_t index, const ProfileDirEntry& entry, const char* name,
+                     CredentialRecord& rec) {
+    if (entry.length < sizeof(CredentialRecordHeader) || entry.length > PROFILE_SLOT_SIZE) {
+        return false;
+    }
+    
+    fram.read(slotAddress(index), rec.raw, entry.length);
+    if (!parseCredentialRecord(rec) || rec.size != entry.length) {
+        return false;
+    }
+    
+    size_t name_len = strlen(name);
+    return rec.profile_name.len == name_len &&
+           memcmp(credentialField(rec, rec.profile_name), name, name_len) == 0;
+}
+
+// Walk the probe chain for `name`. Returns the matching entry or -1, and the
+// first reusable entry seen (empty or tombstone) in *free_index
+static int16_t probe(const ProfileDirectory& dir, const char* name, uint32_t hash,
+                     CredentialRecord& rec, ProfileLookup* lookup, int16_t* free_index) {
+    uint8_t home = hash % PROFILE_SLOTS;
+    *free_index = -1;
+    lookup->probes = 0;
+    
+    for (uint8_t step = 0; step < PROFILE_SLOTS; step++) {
+        uint8_t index = (home + step) % PROFILE_SLOTS;
+        const ProfileDirEntry& entry = dir.entries[index];
+        lookup->probes++;
+        
+        if (entry.state == PROFILE_ENTRY_EMPTY) {
+            if (*free_index < 0) *free_index = index;
+            return -1;                      // End of the chain
+        }
+        
+        if (entry.state == PROFILE_ENTRY_DELETED) {
+            if (*free_index < 0) *free_index = index;
+            continue;
+        }
+        
+        // Full hash match first; the name check only costs a read on a real hit
+        if (entry.name_hash == hash && readSlot(index, entry, name, rec)) {
+            return index;
+        }
+    }
+    
+    return -1;
+}
+
+bool profileFind(const char* name, CredentialRecord& rec, ProfileLookup* lookup) {
+    static ProfileDirectory dir;
+    lookup->index = -1;
+    lookup->probes = 0;
+    lookup->record_us = 0;
+    
+    unsigned long start = micros();
+    bool formatted = readDirectory(dir);
+    lookup->dir_us = micros() - start;
+    
+    if (!formatted) {
+        return false;
+    }
+    
+    start = micros();
+    int16_t free_index;
+    lookup->index = probe(dir, name, profileNameHash(name), rec, lookup, &free_index);
+    lookup->record_us = micros() - start;
+    
+    return lookup->index >= 0;
+}
+
+// Store a finished record (without a profile name) under `name`
+static bool storeRecord(const char* name, CredentialRecord& rec, ProfileLookup* lookup) {
+    static ProfileDirectory dir;
+    static CredentialRecord existing;
+    
+    if (!credentialRecordAdd(rec, CRED_TLV_PROFILE_NAME, (const uint8_t*)name, strlen(name)) ||
+        !credentialRecordFinish(rec)) {
+        return false;
+    }
+    
+    if (rec.size > PROFILE_SLOT_SIZE) {
+        Console.println("ERROR: Record does not fit in a profile slot");
+        return false;
+    }
+    
+    unsigned long start = micros();
+    if (!readDirectory(dir)) {
+        Console.println("Formatting profile directory...");
+        formatDirectory(dir);
+    }
+    lookup->dir_us = micros() - start;
+    
+    uint32_t hash = profileNameHash(name);
+    int16_t free_index;
+    start = micros();
+    int16_t index = probe(dir, name, hash, existing, lookup, &free_index);
+    lookup->record_us = micros() - start;
+    
+    if (index < 0) {
+        index = free_index;
+    }
+    lookup->index = index;
+    
+    if (index < 0) {
+        Console.println("ERROR: Profile directory is full");
+        return false;
+    }
+    
+    // Record first, then its entry: an interrupted write leaves a record whose
+    // CRC fails rather than an entry pointing at someone else's data
+    scrubNoteWrite(slotAddress(index), rec.size);
+    fram.write(slotAddress(index), rec.raw, rec.size);
+    
+    uint8_t verify_raw[PROFILE_SLOT_SIZE];
+    fram.read(slotAddress(index), verify_raw, rec.size);
+    if (memcmp(rec.raw, verify_raw, rec.size) != 0) {
+        Console.println("ERROR: Profile write verification failed");
+        return false;
+    }
+    
+    ProfileDirEntry entry = { hash, rec.size, PROFILE_ENTRY_USED, 0 };
+    writeEntry(index, entry);
+    return true;
+}
+
+bool profileStore(const char* name, const DeviceCredentials& creds, ProfileLookup* lookup) {
+    static CredentialRecord rec;
+    
+    if (!validateCredentials(creds) || !encryptCredentials(creds, rec)) {
+        return false;
+    }
+    
+    return storeRecord(name, rec, lookup);
+}
+
+// True if a used entry was placed past tombstone t (lookups must step over it)
+static bool tombstoneNeeded(const ProfileDirectory& dir, uint8_t t) {
+    for (uint8_t u = 0; u < PROFILE_SLOTS; u++) {
+        if (dir.entries[u].state != PROFILE_ENTRY_USED) continue;
+        
+        uint8_t home = dir.entries[u].name_hash % PROFILE_SLOTS;
+        uint8_t dist_u = (u + PROFILE_SLOTS - home) % PROFILE_SLOTS;
+        uint8_t dist_t = (t + PROFILE_SLOTS - home) % PROFILE_SLOTS;
+        if (dist_t < dist_u) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool profileDelete(const char* name) {
+    static ProfileDirectory dir;
+    static CredentialRecord rec;
+    
+    if (!readDirectory(dir)) {
+        return false;
+    }
+    
+    ProfileLookup lookup;
+    int16_t free_index;
+    int16_t index = probe(dir, name, profileNameHash(name), rec, &lookup, &free_index);
+    if (index < 0) {
+        return false;
+    }
+    
+    // Clear the record so the secrets do not linger in the slot
+    uint8_t zeros[FRAM_BULK_CHUNK_SIZE];
+    memset(zeros, 0, sizeof(zeros));
+    uint16_t length = dir.entries[index].length;
+    scrubNoteWrite(slotAddress(index), length);
+    for (size_t offset = 0; offset < length; offset += sizeof(zeros)) {
+        size_t chunk = min(sizeof(zeros), (size_t)(length - offset));
+        fram.write(slotAddress(index) + offset, zeros, chunk);
+    }
+    
+    ProfileDirEntry cleared = { 0, 0, PROFILE_ENTRY_DELETED, 0 };
+    dir.entries[index] = cleared;
+    
+    // Only tombstones that still sit on some profile's probe path are kept;
+    // the rest (including this one) become empty so misses stop early
+    for (uint8_t t = 0; t < PROFILE_SLOTS; t++) {
+        if (dir.entries[t].state != PROFILE_ENTRY_DELETED || tombstoneNeeded(dir, t)) {
+            continue;
+        }
+        dir.entries[t].state = PROFILE_ENTRY_EMPTY;
+        if (t != index) {
+            writeEntry(t, dir.entries[t]);
+        }
+    }
+    
+    writeEntry(index, dir.entries[index]);
+    return true;
+}
+
+void printProfileList() {
+    static ProfileDirectory dir;
+    static CredentialRecord rec;
+    
+    if (!readDirectory(dir)) {
+        Console.println("No profile directory (created by the first 'profile add')");
+        return;
+    }
+    
+    Console.println("Slot  Addr    Profile                  Device Name                      Size  Probe");
+    
+    uint8_t used = 0;
+    uint8_t tombstones = 0;
+    for (uint8_t i = 0; i < PROFILE_SLOTS; i++) {
+        const ProfileDirEntry& entry = dir.entries[i];
+        if (entry.state == PROFILE_ENTRY_DELETED) tombstones++;
+        if (entry.state != PROFILE_ENTRY_USED) continue;
+        used++;
+        
+        char name[PROFILE_NAME_MAX + 1] = "?";
+        const char* device = "?";
+        if (entry.length <= PROFILE_SLOT_SIZE) {
+            fram.read(slotAddress(i), rec.raw, entry.length);
+            if (parseCredentialRecord(rec) && rec.profile_name.len <= PROFILE_NAME_MAX) {
+                memcpy(name, credentialField(rec, rec.profile_name), rec.profile_name.len);
+                name[rec.profile_name.len] = '\0';
+                device = rec.device_name;
+            }
+        }
+        
+        // Distance from the home entry = probes a lookup of this profile needs - 1
+        uint8_t distance = (i + PROFILE_SLOTS - entry.name_hash % PROFILE_SLOTS) % PROFILE_SLOTS;
+        
+        char line[100];
+        snprintf(line, sizeof(line), "%4u  0x%04X  %-23s  %-31s  %4u  %5u",
+                 i, slotAddress(i), name, device, entry.length, distance + 1);
+        Console.println(line);
+    }
+    
+    Console.print("Profiles: ");
+    Console.print(used);
+    Console.print("/");
+    Console.print(PROFILE_SLOTS);
+    Console.print(", tombstones: ");
+    Console.println(tombstones);
+}
+
+// Bench profiles start with '.', which validateProfileName rejects, so the
+// benchmark can never replace and then delete a real profile
+static void benchName(char* name, uint8_t index) {
+    snprintf(name, PROFILE_NAME_MAX + 1, ".bench_%02u", index);
+}
+
+// Average and worst lookup time over the bench profiles currently stored
+static void benchLookups(uint8_t bench_count, uint8_t total) {
+    static CredentialRecord rec;
+    unsigned long sum_us = 0;
+    unsigned long max_us = 0;
+    uint32_t probe_sum = 0;
+    
+    for (uint8_t i = 0; i < bench_count; i++) {
+        char name[PROFILE_NAME_MAX + 1];
+        benchName(name, i);
+        
+        ProfileLookup lookup;
+        if (!profileFind(name, rec, &lookup)) {
+            Console.print("ERROR: Lookup failed for ");
+            Console.println(name);
+            return;
+        }
+        
+        unsigned long us = lookup.dir_us + lookup.record_us;
+        sum_us += us;
+        max_us = max(max_us, us);
+        probe_sum += lookup.probes;
+    }
+    
+    uint32_t probes_x100 = probe_sum * 100 / bench_count;
+    char line[80];
+    snprintf(line, sizeof(line), "%8u  %10lu  %10lu  %7lu.%02lu",
+             total, sum_us / bench_count, max_us,
+             (unsigned long)(probes_x100 / 100), (unsigned long)(probes_x100 % 100));
+    Console.println(line);
+}
+
+void runProfileBench() {
+    static ProfileDirectory dir;
+    static CredentialRecord base;
+    static CredentialRecord rec;
+    
+    uint8_t existing = 0;
+    if (readDirectory(dir)) {
+        for (uint8_t i = 0; i < PROFILE_SLOTS; i++) {
+            if (dir.entries[i].state == PROFILE_ENTRY_USED) existing++;
+        }
+    }
+    
+    uint8_t room = PROFILE_SLOTS - existing;
+    if (room == 0) {
+        Console.println("ERROR: No free profile slots for the benchmark");
+        return;
+    }
+    
+    // Encrypt once; each bench profile only differs by its name entry
+    DeviceCredentials creds;
+    creds.device_name = "BENCH_DEVICE";
+    creds.wifi_ssid = "BenchNetwork";
+    creds.wifi_password = "BenchPassword";
+    creds.admin_password = "bench";
+    creds.vps_token = "bench-token";
+    if (!encryptCredentials(creds, base)) {
+        return;
+    }
+    
+    Console.print("Adding up to ");
+    Console.print(room);
+    Console.print(" bench profiles next to ");
+    Console.print(existing);
+    Console.println(" existing");
+    Console.println("Profiles   Avg (us)    Max (us)  Avg probes");
+    
+    uint8_t added = 0;
+    for (uint8_t target = 1; added < room; target *= 2) {
+        uint8_t goal = min(target, room);
+        while (added < goal) {
+            char name[PROFILE_NAME_MAX + 1];
+            benchName(name, added);
+            
+            rec = base;
+            ProfileLookup lookup;
+            if (!storeRecord(name, rec, &lookup)) {
+                Console.println("ERROR: Could not add bench profile");
+                room = added;
+                break;
+            }
+            added++;
+        }
+        
+        if (added > 0) {
+            benchLookups(added, existing + added);
+        }
+    }
+    
+    for (uint8_t i = 0; i < added; i++) {
+        char name[PROFILE_NAME_MAX + 1];
+        benchName(name, i);
+        profileDelete(name);
+    }
+    
+    Console.print("Removed ");
+    Console.print(added);
+    Console.println(" bench profiles");
+}
@@ -0,0 +1,141 @@
+#include "reader_check.h"
+#include "encryption.h"
+#include "fram_programmer.h"
+#include "console_out.h"
+#include <fram_cred_reader.h>
+
+static_assert((int)CRED_FIELD_WIFI_SSID == (int)fram_cred::kWifiSsid &&
+              (int)CRED_FIELD_WIFI_PASSWORD == (int)fram_cred::kWifiPassword &&
+              (int)CRED_FIELD_ADMIN_HASH == (int)fram_cred::kAdminHash &&
+              (int)CRED_FIELD_VPS_TOKEN == (int)fram_cred::kVpsToken,
+              "Field ids must match the reader library");
+static_assert(fram_cred::kMagic == FRAM_MAGIC_NUMBER && fram_cred::kVersion1 == FRAM_DATA_VERSION &&
+              fram_cred::kVersion2 == FRAM_DATA_VERSION_V2, "Reader library record ids out of date");
+static_assert(fram_cred::kV2HeaderSize == sizeof(CredentialRecordHeader) &&
+              fram_cred::kV1Size == CRED_V1_USED_SIZE && fram_cred::kIvSize == AES_IV_SIZE &&
+              fram_cred::kSaltSize == CRED_KDF_SALT_SIZE && fram_cred::kMaxNameLen == MAX_DEVICE_NAME_LEN,
+              "Reader library sizes out of date");
+
+bool crossCheckCredentialReader(const CredentialRecord& rec) {
+    fram_cred::Record view;
+    bool parsed = fram_cred::parse(rec.raw, rec.size, view);
+    if (parsed != (rec.version != 0) || view.version != rec.version || (parsed && view.size != rec.size)) {
+        Console.println("  Reader: parse differs");
+        return false;
+    }
+    if (!parsed) {
+        return true;        // Both reject it
+    }
+    
+    uint32_t stored, computed;
+    if (fram_cred::check(view) != checkCredentialRecord(rec, &stored, &computed)) {
+        Console.println("  Reader: integrity check differs");
+        return false;
+    }
+    
+    if (view.name.len != strlen(rec.device_name) ||
+        memcmp(view.name.data, rec.device_name, view.name.len) != 0 ||
+        view.salt.len != rec.kdf_salt.len) {
+        Console.println("  Reader: device name or salt differs");
+        return false;
+    }
+    
+    fram_cred::Decryptor reader(view);
+    if (reader.verifyKey() != fastVerifyCredentials(rec)) {
+        Console.println("  Reader: key check differs");
+        return false;
+    }
+    
+    uint8_t key[AES_KEY_SIZE];
+    credentialKey(rec, key);
+    
+    bool match = true;
+    for (uint8_t id = 0; id < fram_cred::kFieldCount && match; id++) {
+        uint8_t expected[CRED_CIPHER_SIZE(MAX_VPS_TOKEN_LEN)];
+        uint8_t actual[CRED_CIPHER_SIZE(MAX_VPS_TOKEN_LEN)];
+        size_t expected_len = sizeof(expected);
+        uint32_t actual_len = sizeof(actual);
+        
+        bool expected_ok = decryptCredentialField(rec, key, (CredentialFieldId)id, expected, &expected_len);
+        bool actual_ok = reader.field((fram_cred::Field)id, actual, &actual_len);
+        match = expected_ok == actual_ok &&
+                (!expected_ok || (expected_len == actual_len && memcmp(expected, actual, actual_len) == 0));
+        if (!match) {
+            Console.print("  Reader: field ");
+            Console.print(id);
+            Console.println(" differs");
+        }
+        memset(expected, 0, sizeof(expected));
+        memset(actual, 0, sizeof(actual));
+    }
+    
+    memset(key, 0, sizeof(key));
+    return match;
+}
+
+bool testCredentialReader() {
+    static CredentialRecord rec, variant;
+    
+    DeviceCredentials creds;
+    creds.device_name = "READER_TEST_01";
+    creds.wifi_ssid = "Network-16-chars";          // Exactly one block: padding fills the next
+    creds.wifi_password = "correct horse battery staple";
+    creds.admin_password = "admin123";
+    creds.vps_token = "sha256:0123456789abcdef0123456789abcdef";
+    
+    if (!encryptCredentials(creds, rec)) {
+        return false;
+    }
+    
+    bool fresh = fastVerifyCredentials(rec) && crossCheckCredentialReader(rec);
+    
+    // A salted re-key exercises entry 0x08 and the longer key material
+    variant = rec;
+    bool salted = rekeyCredentials(variant, true) && variant.kdf_salt.len == CRED_KDF_SALT_SIZE &&
+                  fastVerifyCredentials(variant) && crossCheckCredentialReader(variant);
+    
+    // Damaged ciphertext: both must reject the same way
+    variant = rec;
+    variant.raw[variant.vps_token.offset + 3] ^= 0x40;
+    bool damaged = crossCheckCredentialReader(variant);
+    
+    // Whatever the chip holds now, v1 included
+    bool stored = true;
+    if (readCredentialsSection(variant) && variant.version != 0) {
+        stored = crossCheckCredentialReader(variant);
+    }
+    
+    Console.print("  Fresh v2: "); Console.print(fresh ? "OK" : "FAIL");
+    Console.print(", salted: "); Console.print(salted ? "OK" : "FAIL");
+    Console.print(", damaged: "); Console.print(damaged ? "OK" : "FAIL");
+    Console.print(", stored: "); Console.println(stored ? "OK" : "FAIL");
+    
+    // Boot path of a consumer: parse, integrity, key check and the SSID alone
+    unsigned long start = micros();
+    fram_cred::Record view;
+    uint8_t ssid[MAX_WIFI_SSID_LEN + 1];
+    uint32_t ssid_len = sizeof(ssid);
+    bool boot_ok = fram_cred::parse(rec.raw, rec.size, view) && fram_cred::check(view);
+    if (boot_ok) {
+        fram_cred::Decryptor reader(view);
+        boot_ok = reader.verifyKey() && reader.field(fram_cred::kWifiSsid, ssid, &ssid_len);
+    }
+    unsigned long reader_us = micros() - start;
+    boot_ok = boot_ok && ssid_len == creds.wifi_ssid.length() &&
+              memcmp(ssid, creds.wifi_ssid.c_str(), ssid_len) == 0;
+    
+    // The same information through the full firmware path
+    start = micros();
+    DeviceCredentials full;
+    uint32_t stored_crc, computed_crc;
+    bool full_ok = checkCredentialRecord(rec, &stored_crc, &computed_crc) && decryptCredentials(rec, full);
+    unsigned long full_us = micros() - start;
+    
+    Console.print("  Boot read: reader ");
+    Console.print(reader_us);
+    Console.print(" us, full decrypt ");
+    Console.print(full_us);
+    Console.println(" us");
+    
+    return fresh && salted && damaged && stored && boot_ok && full_ok;
+}
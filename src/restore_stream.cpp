@@ -0,0 +1,286 @@
+#include "restore_stream.h"
+#include "fram_programmer.h"
+#include "core1_worker.h"
+#include "hex_codec.h"
+#include "fram_scrub.h"
+#include "console_out.h"
+#include <Wire.h>
+#include <Adafruit_FRAM_I2C.h>
+
+// Core 1 job: consumer side of the restore ring. Core 0 only parses serial
+// input during a restore, so the I2C bus belongs to core 1 until the ring closes.
+static void restoreWriteJob(void* arg) {
+    RestoreStream& stream = *(RestoreStream*)arg;
+    uint8_t verify[FRAM_BULK_CHUNK_SIZE];
+    RingSlot* slot;
+    
+    while ((slot = ringBeginRead(stream.ring)) != nullptr) {
+        bool ok = true;
+        uint16_t error_addr = 0;
+        
+        // Noted here rather than on core 0: the scrub index is on this bus
+        scrubNoteWrite(slot->addr, slot->len);
+        for (size_t offset = 0; offset < slot->len; offset += FRAM_BULK_CHUNK_SIZE) {
+            size_t len = min((size_t)FRAM_BULK_CHUNK_SIZE, slot->len - offset);
+            fram.write(slot->addr + offset, &slot->data[offset], len);
+        }
+        
+        for (size_t offset = 0; ok && offset < slot->len; offset += FRAM_BULK_CHUNK_SIZE) {
+            size_t len = min((size_t)FRAM_BULK_CHUNK_SIZE, slot->len - offset);
+            fram.read(slot->addr + offset, verify, len);
+            
+            for (size_t i = 0; i < len; i++) {
+                if (verify[i] != slot->data[offset + i]) {
+                    ok = false;
+                    error_addr = slot->addr + offset + i;
+                    break;
+                }
+            }
+        }
+        
+        if (ok) {
+            stream.bytes_written += slot->len;
+            stream.chunks_written++;
+        } else {
+            if (stream.chunk_errors < RESTORE_ERROR_LOG) {
+                RestoreError& error = stream.errors[stream.chunk_errors];
+                error.addr = slot->addr;
+                error.len = slot->len;
+                error.error_addr = error_addr;
+            }
+            stream.chunk_errors++;
+        }
+        
+        ringCommitRead(stream.ring);
+    }
+}
+
+// Publish the slot being filled so core 1 can write it
+static void flushChunk(RestoreStream& stream) {
+    if (stream.filling != nullptr && stream.filling->len > 0) {
+        ringCommitWrite(stream.ring);
+        stream.filling = nullptr;
+    }
+}
+
+static bool appendData(RestoreStream& stream, const uint8_t* data, size_t len) {
+    if (stream.next_addr + len > FRAM_SIZE) {
+        Console.println("ERROR: Restore data beyond end of FRAM");
+        return false;
+    }
+    
+    while (len > 0) {
+        // A chunk is one contiguous address range
+        if (stream.filling != nullptr &&
+            stream.filling->addr + stream.filling->len != stream.next_addr) {
+            flushChunk(stream);
+        }
+        if (stream.filling == nullptr) {
+            stream.filling = ringBeginWrite(stream.ring);
+            stream.filling->addr = stream.next_addr;
+            stream.filling->len = 0;
+        }
+        
+        RingSlot* slot = stream.filling;
+        size_t take = min(len, (size_t)(RING_SLOT_SIZE - slot->len));
+        memcpy(&slot->data[slot->len], data, take);
+        slot->len += take;
+        stream.next_addr += take;
+        stream.bytes_received += take;
+        data += take;
+        len -= take;
+        
+        if (slot->len == RING_SLOT_SIZE) {
+            flushChunk(stream);
+        }
+    }
+    return true;
+}
+
+// LzrSink adapter: decoded ZDATA goes straight into the chunk buffers
+static bool decodedSink(const uint8_t* data, size_t len, void* ctx) {
+    return appendData(*(RestoreStream*)ctx, data, len);
+}
+
+static bool lineError(RestoreStream& stream, const char* message) {
+    stream.line_errors++;
+    Console.print("ERROR: Line ");
+    Console.print(stream.lines);
+    Console.print(": ");
+    Console.println(message);
+    return false;
+}
+
+bool restoreBegin(RestoreStream& stream) {
+    ringInit(stream.ring);
+    stream.filling = nullptr;
+    stream.next_addr = 0;
+    stream.addr_invalid = false;
+    stream.compressed = false;
+    stream.expected_size = 0;
+    stream.lines = 0;
+    stream.bytes_received = 0;
+    stream.line_errors = 0;
+    stream.ended = false;
+    stream.start_us = 0;
+    stream.elapsed_us = 0;
+    stream.bytes_written = 0;
+    stream.chunks_written = 0;
+    stream.chunk_errors = 0;
+    
+    if (!detectFRAM()) {
+        Console.println("ERROR: FRAM not detected");
+        return false;
+    }
+    
+    Wire.setClock(FRAM_I2C_BULK_CLOCK);
+    
+    if (!core1Submit(restoreWriteJob, &stream)) {
+        Wire.setClock(FRAM_I2C_CLOCK);
+        Console.println("ERROR: Core 1 busy");
+        return false;
+    }
+    return true;
+}
+
+bool restoreFeedLine(RestoreStream& stream, const String& line) {
+    stream.lines++;
+    
+    if (stream.start_us == 0) {
+        stream.start_us = micros();
+    }
+    
+    if (line.startsWith("DATA:") || line.startsWith("ZDATA:")) {
+        bool compressed = line.charAt(0) == 'Z';
+        size_t prefix_len = compressed ? 6 : 5;
+        uint8_t bytes[RESTORE_LINE_MAX_BYTES];
+        size_t len, error_pos;
+        
+        if (stream.addr_invalid) {
+            return lineError(stream, "data after invalid ADDR skipped");
+        }
+        
+        if (!hexDecode(line.c_str() + prefix_len, line.length() - prefix_len,
+                       bytes, sizeof(bytes), &len, &error_pos)) {
+            char message[48];
+            snprintf(message, sizeof(message), "invalid hex data at column %u",
+                     (unsigned)(prefix_len + error_pos + 1));
+            return lineError(stream, message);
+        }
+        
+        if (!compressed) {
+            return appendData(stream, bytes, len) || lineError(stream, "write failed");
+        }
+        
+        if (!stream.compressed) {
+            return lineError(stream, "ZDATA without ENCODING:LZR");
+        }
+        
+        return lzrDecodeWrite(stream.decoder, bytes, len) || lineError(stream, "corrupt LZR stream");
+    }
+    
+    if (line.startsWith("ADDR:")) {
+        // A damaged address must not turn into 0x0000 and send the
+        // following data over the credentials
+        uint32_t addr;
+        if (!hexParseNumber(line.c_str() + 5, line.length() - 5, &addr)) {
+            stream.addr_invalid = true;
+            return lineError(stream, "invalid ADDR value");
+        }
+        if (addr >= FRAM_SIZE) {
+            stream.addr_invalid = true;
+            return lineError(stream, "address out of range");
+        }
+        stream.next_addr = addr;
+        stream.addr_invalid = false;
+        return true;
+    }
+    
+    if (line.startsWith("SIZE:") && stream.lines <= 2) {
+        const char* digits = line.c_str() + 5;
+        char* end = nullptr;
+        unsigned long size = isdigit((unsigned char)digits[0]) ? strtoul(digits, &end, 10) : 0;
+        if (end == nullptr || *end != '\0') {
+            return lineError(stream, "invalid SIZE value");
+        }
+        stream.expected_size = size;
+        return true;
+    }
+    
+    if (line == "MODE:INCREMENTAL") {
+        // Only changed blocks follow, so SIZE: is not the amount of data
+        stream.expected_size = 0;
+        return true;
+    }
+    
+    if (line == "ENCODING:LZR") {
+        stream.compressed = true;
+        lzrDecoderInit(stream.decoder, decodedSink, &stream);
+        return true;
+    }
+    
+    if (line == "BACKUP_END") {
+        stream.ended = true;
+    }
+    
+    // BACKUP_START, BLOCK_SIZE:, DIGEST: and the like carry no data
+    return true;
+}
+
+bool restoreFinish(RestoreStream& stream) {
+    if (stream.compressed && !lzrDecodeFinish(stream.decoder)) {
+        lineError(stream, "LZR stream truncated");
+    }
+    
+    flushChunk(stream);
+    ringClose(stream.ring);
+    core1Wait();
+    
+    stream.elapsed_us = stream.start_us ? micros() - stream.start_us : 0;
+    Wire.setClock(FRAM_I2C_CLOCK);
+    
+    for (size_t i = 0; i < min(stream.chunk_errors, (size_t)RESTORE_ERROR_LOG); i++) {
+        const RestoreError& error = stream.errors[i];
+        Console.print("ERROR: Chunk 0x");
+        Console.print(error.addr, HEX);
+        Console.print("-0x");
+        Console.print(error.addr + error.len - 1, HEX);
+        Console.print(" failed verification at 0x");
+        Console.println(error.error_addr, HEX);
+    }
+    
+    return stream.chunk_errors == 0 && stream.line_errors == 0;
+}
+
+void printRestoreReport(const RestoreStream& stream) {
+    Console.print("Restored ");
+    Console.print(stream.bytes_written);
+    Console.print(" bytes in ");
+    Console.print(stream.chunks_written);
+    Console.print(" chunk(s), ");
+    Console.print(stream.elapsed_us / 1000);
+    Console.print(" ms");
+    if (stream.elapsed_us > 0) {
+        Console.print(" (");
+        Console.print((uint32_t)((uint64_t)stream.bytes_written * 1000000ULL / stream.elapsed_us));
+        Console.print(" bytes/sec)");
+    }
+    Console.println();
+    
+    if (stream.expected_size > 0 && stream.bytes_received != stream.expected_size) {
+        Console.print("WARNING: Backup declared ");
+        Console.print(stream.expected_size);
+        Console.print(" bytes, received ");
+        Console.println(stream.bytes_received);
+    }
+    
+    if (stream.chunk_errors > 0 || stream.line_errors > 0) {
+        Console.print("Errors: ");
+        Console.print(stream.chunk_errors);
+        Console.print(" chunk(s) failed verification, ");
+        Console.print(stream.line_errors);
+        Console.println(" bad line(s)");
+    }
+    
+    printRingStats(stream.ring, "USB input", "FRAM write");
+}
@@ -0,0 +1,180 @@
+#include "serial_line.h"
+#include "console_out.h"
+
+static uint8_t ring[SERIAL_RING_SIZE];
+static uint16_t ring_head = 0;      // Next write
+static uint16_t ring_count = 0;
+
+static char line_buf[SERIAL_LINE_MAX + 1];
+static size_t line_len = 0;         // Line being edited
+static size_t ready_len = 0;        // Last completed line
+static bool line_overflow = false;
+
+static unsigned long prompt_timeout_ms = SERIAL_PROMPT_TIMEOUT_MS;
+static SerialLineStats stats;
+
+static_assert((SERIAL_RING_SIZE & (SERIAL_RING_SIZE - 1)) == 0, "Ring size must be a power of two");
+
+void serialPump() {
+    // Whatever was printed goes out before the firmware waits on the host
+    Console.flush();
+    
+    int available = Serial.available();
+    while (available > 0 && ring_count < SERIAL_RING_SIZE) {
+        // Largest contiguous free run from the head
+        size_t space = SERIAL_RING_SIZE - ring_count;
+        size_t run = min(space, (size_t)(SERIAL_RING_SIZE - ring_head));
+        size_t n = Serial.readBytes(&ring[ring_head], min(run, (size_t)available));
+        if (n == 0) {
+            break;
+        }
+        
+        ring_head = (ring_head + n) & (SERIAL_RING_SIZE - 1);
+        ring_count += n;
+        stats.bytes_in += n;
+        available -= n;
+    }
+    
+    if (ring_count > stats.ring_peak) {
+        stats.ring_peak = ring_count;
+    }
+}
+
+bool serialInputPending() {
+    return ring_count > 0 || Serial.available() > 0;
+}
+
+static int ringPop() {
+    if (ring_count == 0) {
+        return -1;
+    }
+    uint8_t c = ring[(ring_head - ring_count) & (SERIAL_RING_SIZE - 1)];
+    ring_count--;
+    return c;
+}
+
+int serialReadByte() {
+    if (ring_count == 0) {
+        serialPump();
+    }
+    return ringPop();
+}
+
+int serialPeekByte() {
+    if (ring_count == 0) {
+        serialPump();
+    }
+    if (ring_count == 0) {
+        return -1;
+    }
+    return ring[(ring_head - ring_count) & (SERIAL_RING_SIZE - 1)];
+}
+
+LineResult pollSerialLine(bool echo) {
+    serialPump();
+    
+    // Echo is collected and written once per call, not per character
+    char echo_buf[64];
+    size_t echo_len = 0;
+    LineResult result = LINE_PENDING;
+    
+    while (result == LINE_PENDING && ring_count > 0) {
+        char c = (char)ringPop();
+        
+        if (c == '\n' || c == '\r') {
+            if (line_len == 0 && !line_overflow) {
+                continue;           // Blank line, or the LF of a CRLF
+            }
+            
+            line_buf[line_len] = '\0';
+            ready_len = line_len;
+            line_len = 0;
+            if (line_overflow) {
+                line_overflow = false;
+                stats.too_long++;
+                result = LINE_TOO_LONG;
+            } else {
+                stats.lines++;
+                result = LINE_READY;
+            }
+        } else if (c == '\b' || c == 127) {     // Backspace
+            if (line_len > 0) {
+                line_len--;
+                if (echo_len + 3 > sizeof(echo_buf)) {
+                    if (echo) Console.write((const uint8_t*)echo_buf, echo_len);
+                    echo_len = 0;
+                }
+                memcpy(&echo_buf[echo_len], "\b \b", 3);
+                echo_len += 3;
+            }
+        } else if (c >= 32 && c < 127) {        // Printable characters
+            if (line_len < SERIAL_LINE_MAX) {
+                line_buf[line_len++] = c;
+            } else {
+                line_overflow = true;
+            }
+            if (echo_len == sizeof(echo_buf)) {
+                if (echo) Console.write((const uint8_t*)echo_buf, echo_len);
+                echo_len = 0;
+            }
+            echo_buf[echo_len++] = c;
+        }
+    }
+    
+    if (echo) {
+        if (echo_len > 0) {
+            Console.write((const uint8_t*)echo_buf, echo_len);
+        }
+        if (result != LINE_PENDING) {
+            Console.println();
+        }
+        Console.flush();
+    }
+    return result;
+}
+
+LineResult waitSerialLine(bool echo, unsigned long idle_timeout_ms) {
+    unsigned long last_input_ms = millis();
+    uint32_t seen = stats.bytes_in;
+    
+    while (true) {
+        LineResult result = pollSerialLine(echo);
+        if (result != LINE_PENDING) {
+            return result;
+        }
+        
+        if (stats.bytes_in != seen) {
+            seen = stats.bytes_in;
+            last_input_ms = millis();
+        } else if (idle_timeout_ms > 0 && millis() - last_input_ms >= idle_timeout_ms) {
+            line_len = 0;           // A half-typed line is not an answer
+            line_overflow = false;
+            ready_len = 0;
+            line_buf[0] = '\0';
+            stats.timeouts++;
+            return LINE_TIMEOUT;
+        } else if (!serialInputPending()) {
+            delay(1);               // Only idle when nothing is waiting
+        }
+    }
+}
+
+const char* serialLineText() {
+    return line_buf;
+}
+
+size_t serialLineLength() {
+    return ready_len;
+}
+
+void setSerialPromptTimeout(unsigned long timeout_ms) {
+    prompt_timeout_ms = timeout_ms;
+}
+
+unsigned long serialPromptTimeout() {
+    return prompt_timeout_ms;
+}
+
+const SerialLineStats& serialLineStats() {
+    return stats;
+}
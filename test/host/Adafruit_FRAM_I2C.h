@@ -0,0 +1,56 @@
+#ifndef HOST_ADAFRUIT_FRAM_I2C_H
+#define HOST_ADAFRUIT_FRAM_I2C_H
+
+// The Adafruit I2C FRAM driver on the host. The chip in the socket is a RAM
+// array the test points the driver at, so a test can swap chips between
+// calls; with no chip every transfer fails like a NAK.
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+class TwoWire;
+
+class Adafruit_FRAM_I2C {
+public:
+    uint8_t* chip = nullptr;
+    size_t chip_size = 0;
+    
+    bool begin(uint8_t addr = 0x50, TwoWire* wire = nullptr) {
+        (void)addr;
+        (void)wire;
+        return chip != nullptr;
+    }
+    
+    bool write(uint16_t addr, uint8_t value) {
+        return write(addr, &value, 1);
+    }
+    
+    bool write(uint16_t addr, uint8_t* values, size_t n) {
+        if (!inside(addr, n)) {
+            return false;
+        }
+        memcpy(&chip[addr], values, n);
+        return true;
+    }
+    
+    uint8_t read(uint16_t addr) {
+        uint8_t value = 0;
+        read(addr, &value, 1);
+        return value;
+    }
+    
+    bool read(uint16_t addr, uint8_t* values, size_t n) {
+        if (!inside(addr, n)) {
+            return false;
+        }
+        memcpy(values, &chip[addr], n);
+        return true;
+    }
+    
+private:
+    bool inside(uint16_t addr, size_t n) const {
+        return chip != nullptr && (size_t)addr + n <= chip_size;
+    }
+};
+
+#endif // HOST_ADAFRUIT_FRAM_I2C_H
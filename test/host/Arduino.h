@@ -0,0 +1,163 @@
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+// Just enough of the Arduino/arduino-pico API to build the portable firmware
+// sources (codecs, crypto, credential records, channel jobs) on the host for
+// the native tests. Serial collects its output in memory so tests can check
+// what was printed; the thread that includes this first plays core 0.
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <ctype.h>
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#define HEX 16
+#define DEC 10
+
+using std::min;
+using std::max;
+
+typedef uint8_t byte;
+
+inline unsigned long micros() {
+    static const auto start = std::chrono::steady_clock::now();
+    return (unsigned long)std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+inline unsigned long millis() {
+    return micros() / 1000;
+}
+
+inline void delay(unsigned long ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+inline void tight_loop_contents() {
+    std::this_thread::yield();
+}
+
+class String {
+public:
+    String() {}
+    String(const char* text) : s_(text ? text : "") {}
+    String(const std::string& text) : s_(text) {}
+    
+    unsigned int length() const { return s_.size(); }
+    const char* c_str() const { return s_.c_str(); }
+    bool reserve(unsigned int size) { s_.reserve(size); return true; }
+    char charAt(unsigned int i) const { return i < s_.size() ? s_[i] : 0; }
+    char operator[](unsigned int i) const { return charAt(i); }
+    bool concat(char c) { s_ += c; return true; }
+    bool concat(const char* text) { s_ += text; return true; }
+    bool concat(const char* text, unsigned int len) { s_.append(text, len); return true; }
+    String& operator+=(char c) { s_ += c; return *this; }
+    String& operator+=(const char* text) { s_ += text; return *this; }
+    String& operator+=(const String& other) { s_ += other.s_; return *this; }
+    bool operator==(const char* text) const { return s_ == text; }
+    bool operator==(const String& other) const { return s_ == other.s_; }
+    void toUpperCase() { for (char& c : s_) c = toupper((unsigned char)c); }
+    void toLowerCase() { for (char& c : s_) c = tolower((unsigned char)c); }
+    
+private:
+    std::string s_;
+};
+
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* data, size_t len) {
+        for (size_t i = 0; i < len; i++) {
+            write(data[i]);
+        }
+        return len;
+    }
+    size_t write(const char* text) { return write((const uint8_t*)text, strlen(text)); }
+    size_t write(const char* text, size_t len) { return write((const uint8_t*)text, len); }
+    virtual void flush() {}
+    
+    size_t print(const char* text) { return write(text); }
+    size_t print(const String& text) { return write(text.c_str()); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(unsigned char value, int base = DEC) { return print((unsigned long)value, base); }
+    size_t print(int value, int base = DEC) { return print((long)value, base); }
+    size_t print(unsigned int value, int base = DEC) { return print((unsigned long)value, base); }
+    size_t print(long value, int base = DEC) {
+        if (base == DEC && value < 0) {
+            return print('-') + print((unsigned long)-value, base);
+        }
+        return print((unsigned long)value, base);
+    }
+    size_t print(unsigned long value, int base = DEC) {
+        // Digits built backwards, uppercase like the Arduino core
+        char digits[8 * sizeof(long) + 1];
+        char* p = &digits[sizeof(digits) - 1];
+        *p = '\0';
+        do {
+            unsigned digit = value % base;
+            *--p = digit < 10 ? '0' + digit : 'A' + digit - 10;
+            value /= base;
+        } while (value);
+        return write(p);
+    }
+    size_t print(double value, int decimals = 2) {
+        char text[32];
+        snprintf(text, sizeof(text), "%.*f", decimals, value);
+        return write(text);
+    }
+    
+    size_t println() { return write("\r\n"); }
+    template <typename T> size_t println(const T& value) { return print(value) + println(); }
+    template <typename T> size_t println(const T& value, int base) { return print(value, base) + println(); }
+};
+
+// Serial keeps everything written to it; tests take() it to inspect or discard.
+// writeCalls() counts write() calls, each a USB transfer on the real board.
+class HostSerial : public Print {
+public:
+    using Print::write;
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t* data, size_t len) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        output_.append((const char*)data, len);
+        write_calls_++;
+        return len;
+    }
+    std::string take() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::string out;
+        out.swap(output_);
+        return out;
+    }
+    size_t writeCalls() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return write_calls_;
+    }
+    
+private:
+    std::mutex mutex_;
+    std::string output_;
+    size_t write_calls_ = 0;
+};
+
+inline HostSerial Serial;
+
+class HostRP2040 {
+public:
+    HostRP2040() : core0_(std::this_thread::get_id()) {}
+    int cpuid() const { return std::this_thread::get_id() == core0_ ? 0 : 1; }
+    
+private:
+    std::thread::id core0_;
+};
+
+inline HostRP2040 rp2040;
+
+#endif // HOST_ARDUINO_H
@@ -0,0 +1,16 @@
+#ifndef HOST_PICO_RAND_H
+#define HOST_PICO_RAND_H
+
+// pico_rand stand-in: callable from either core, like the SDK version
+#include <stdint.h>
+#include <mutex>
+#include <random>
+
+inline uint32_t get_rand_32() {
+    static std::mutex mutex;
+    static std::mt19937 generator(std::random_device{}());
+    std::lock_guard<std::mutex> lock(mutex);
+    return generator();
+}
+
+#endif // HOST_PICO_RAND_H
@@ -0,0 +1,86 @@
+#ifndef GOLDEN_RECORDS_H
+#define GOLDEN_RECORDS_H
+
+// Credential records exactly as the programmer stored them at FRAM 0x0018,
+// cut from `backup` images (v1: the 512 bytes a reader needs; v2: header and
+// entries). They pin the on-chip format: a firmware change that stops these
+// from parsing and decrypting breaks every board already in the field.
+#include <stdint.h>
+
+// v1, written by the 1.0.0 firmware's `config` (fixed layout, unsalted)
+//   DOLEWKA_001 / MyNetwork / MyPassword / admin123 / sha256:abc123
+static const uint8_t kGoldenV1[512] = {
+    0x44, 0x45, 0x52, 0x43, 0x01, 0x00, 0x00, 0x00, 0x44, 0x4F, 0x4C, 0x45, 0x57, 0x4B, 0x41, 0x5F,
+    0x30, 0x30, 0x31, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x2D, 0x15, 0x9B, 0xAC, 0x3B, 0x9F, 0xDA, 0xF1,
+    0x3C, 0x6A, 0x7E, 0x9A, 0xC3, 0x44, 0x4C, 0x05, 0x9A, 0xC7, 0xCF, 0x75, 0x67, 0xF1, 0x06, 0x69,
+    0xBA, 0x10, 0xD1, 0x68, 0x2E, 0x77, 0x1B, 0x02, 0x4F, 0xF4, 0xD7, 0x18, 0x7F, 0x03, 0x59, 0x10,
+    0xBC, 0x31, 0xF1, 0x8F, 0x5E, 0x6E, 0x9E, 0xAD, 0x14, 0x01, 0xEE, 0x81, 0x33, 0xC6, 0x5E, 0xA7,
+    0x46, 0xA0, 0xE0, 0xF1, 0xF4, 0x92, 0x1B, 0x0D, 0x3E, 0x49, 0x2D, 0x01, 0x91, 0x10, 0x1D, 0x21,
+    0x53, 0x1E, 0x42, 0x48, 0x4D, 0xEC, 0xF7, 0x85, 0x1A, 0xD5, 0x5A, 0xE0, 0xDB, 0x98, 0x26, 0xCB,
+    0xAB, 0x3B, 0xFD, 0x5F, 0xD6, 0x4B, 0xB2, 0xED, 0x6A, 0x17, 0x8A, 0xE4, 0xE7, 0x81, 0x26, 0xA4,
+    0xEF, 0xEC, 0x89, 0x0C, 0x03, 0x27, 0x47, 0xF8, 0x42, 0x06, 0x8F, 0x95, 0xE2, 0xE2, 0x13, 0x48,
+    0x46, 0xD9, 0x58, 0x99, 0x3F, 0x34, 0x26, 0x5B, 0xF4, 0xD8, 0x1D, 0xED, 0x48, 0x28, 0x91, 0x25,
+    0xC6, 0x2E, 0x8A, 0xB1, 0x90, 0x45, 0x10, 0x73, 0x8D, 0x06, 0x51, 0x15, 0x4A, 0x4F, 0x3E, 0x80,
+    0x29, 0xF4, 0x6D, 0xBA, 0x9D, 0xDA, 0xCB, 0x47, 0x23, 0x03, 0x8C, 0xF9, 0xEE, 0x64, 0x85, 0x18,
+    0xE9, 0xFF, 0xA4, 0xC8, 0x6F, 0x0C, 0x35, 0xC1, 0x90, 0x2C, 0x5E, 0xE4, 0xEB, 0x12, 0xD5, 0x1A,
+    0xA7, 0xF8, 0x9E, 0x39, 0xC2, 0xE5, 0x70, 0xFF, 0x2B, 0x57, 0xA8, 0xA5, 0x1B, 0x92, 0xB0, 0x7E,
+    0x6C, 0xC7, 0x38, 0x66, 0xBE, 0xD6, 0x04, 0xD5, 0x05, 0xE7, 0xD8, 0xCC, 0x39, 0x7D, 0xF0, 0xCB,
+    0x16, 0x72, 0xB0, 0x0D, 0x13, 0x20, 0x76, 0x4B, 0x2D, 0x84, 0x31, 0x67, 0xDF, 0x18, 0x7E, 0x9A,
+    0xEC, 0xA8, 0xF3, 0x29, 0xAE, 0xAC, 0x68, 0x33, 0x95, 0xC4, 0xD9, 0x10, 0x0F, 0xBC, 0xE4, 0x4B,
+    0x06, 0xA6, 0x8E, 0xC1, 0xCC, 0xF8, 0x7D, 0xEB, 0xE2, 0xE2, 0x11, 0xBE, 0xBE, 0x80, 0x88, 0xC4,
+    0x86, 0x19, 0x97, 0x78, 0xEA, 0x50, 0x17, 0x73, 0xA1, 0x38, 0x16, 0x8A, 0x9E, 0xFD, 0x5C, 0x75,
+    0x3E, 0x8E, 0x3A, 0xEF, 0x06, 0x78, 0x08, 0x81, 0xA3, 0x49, 0xA8, 0xFD, 0x16, 0xB3, 0xDA, 0x29,
+    0x32, 0x1E, 0xE4, 0x62, 0x90, 0x87, 0x80, 0xA9, 0x3E, 0x36, 0x0A, 0x24, 0xF0, 0x6D, 0x6D, 0xD7,
+    0xA3, 0x62, 0x4A, 0x00, 0x23, 0xC0, 0xEC, 0x98, 0xF5, 0x12, 0x3D, 0xF8, 0xD5, 0xC3, 0x03, 0xE4,
+    0x3A, 0xF2, 0x2D, 0xDF, 0x15, 0x04, 0x11, 0x12, 0xB0, 0xB7, 0x8F, 0xC4, 0x80, 0x7B, 0x5E, 0xCB,
+    0x44, 0xC0, 0xD8, 0x6C, 0x74, 0xB2, 0xF8, 0xF2, 0xB9, 0x56, 0x56, 0xD2, 0x7C, 0x3D, 0x5F, 0x42,
+    0x0D, 0xA1, 0x86, 0x9C, 0x62, 0x6B, 0xB5, 0x95, 0x4E, 0xD8, 0xF8, 0xA0, 0x8F, 0x0B, 0xD7, 0xEF,
+    0xB4, 0x58, 0xA2, 0x05, 0x21, 0x72, 0xDB, 0x8C, 0x69, 0x69, 0xB4, 0x6D, 0x8F, 0xDA, 0xA0, 0xCF,
+    0xF1, 0xAC, 0x46, 0xDE, 0x57, 0x3A, 0xE4, 0xD3, 0x50, 0x06, 0x9B, 0xAC, 0xDC, 0x7C, 0x08, 0x0D,
+    0x5A, 0x6F, 0x8E, 0x04, 0xB6, 0x5F, 0xCE, 0xF4, 0xC8, 0x27, 0xC1, 0x9C, 0x6E, 0x6A, 0x93, 0xA3,
+    0x2F, 0x37, 0x09, 0x9C, 0x46, 0xBB, 0x04, 0x0C, 0xD5, 0x63, 0xDB, 0xF6, 0x26, 0xFA, 0x32, 0x04,
+    0x0F, 0xBB, 0x17, 0x4C, 0x15, 0x3C, 0x21, 0x20, 0x75, 0x51, 0x92, 0xE0, 0x4B, 0x5E, 0xA2, 0x8D,
+    0x5E, 0xE2, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+};
+
+// v2, written by `dual program` on channel 0
+//   DOLEWKA_002 / MyHomeNetwork / MySecurePassword123 / admin123 / sha256:7b4f...7f8a
+static const uint8_t kGoldenV2[225] = {
+    0x44, 0x45, 0x52, 0x43, 0x02, 0x00, 0xD5, 0x00, 0x25, 0x39, 0xB3, 0x26, 0x01, 0x0B, 0x00, 0x44,
+    0x4F, 0x4C, 0x45, 0x57, 0x4B, 0x41, 0x5F, 0x30, 0x30, 0x32, 0x02, 0x08, 0x00, 0x96, 0xC4, 0x23,
+    0xD6, 0x3A, 0x4A, 0x5A, 0x3D, 0x03, 0x10, 0x00, 0xA7, 0xDB, 0x2B, 0x89, 0xC1, 0x61, 0x09, 0x52,
+    0x3B, 0x0D, 0xA1, 0x77, 0x71, 0x36, 0xC9, 0xD6, 0x04, 0x20, 0x00, 0xFD, 0xC0, 0xAE, 0x28, 0x5A,
+    0x4C, 0xF8, 0x89, 0xAD, 0xDE, 0x81, 0x28, 0x96, 0xDF, 0x43, 0x31, 0x84, 0x41, 0x67, 0x03, 0xD3,
+    0x01, 0x26, 0x04, 0x33, 0x75, 0x6B, 0x05, 0xA8, 0x00, 0x83, 0x66, 0x05, 0x30, 0x00, 0x40, 0x88,
+    0x62, 0x2B, 0xAF, 0x01, 0x41, 0x2F, 0xEB, 0xD2, 0x49, 0x37, 0xC2, 0xDA, 0x52, 0x8C, 0xFF, 0x72,
+    0xCD, 0x83, 0x63, 0x20, 0xC0, 0x06, 0xD8, 0x50, 0xAB, 0xE2, 0xA3, 0xED, 0x85, 0xBC, 0xAD, 0xDB,
+    0x88, 0x74, 0x42, 0x59, 0x63, 0xBF, 0x44, 0x91, 0x7E, 0x2C, 0x4D, 0x4F, 0x1B, 0xF2, 0x06, 0x50,
+    0x00, 0x8B, 0x59, 0x04, 0xB4, 0x0A, 0x68, 0xFF, 0xC7, 0xEC, 0x51, 0xEF, 0x14, 0x3A, 0xB7, 0x67,
+    0x47, 0x11, 0x73, 0xD7, 0xD5, 0xB4, 0x2E, 0x94, 0xBA, 0x4B, 0x6B, 0x7B, 0x02, 0xFA, 0x19, 0xEE,
+    0x2B, 0x9F, 0xD1, 0x08, 0xD8, 0xF5, 0x49, 0x97, 0x57, 0x21, 0xC2, 0x1E, 0x46, 0xC5, 0x06, 0x47,
+    0x7E, 0x7B, 0x4C, 0x56, 0x71, 0x2F, 0x8F, 0x2E, 0x29, 0xAC, 0x79, 0xD3, 0x93, 0x28, 0xA3, 0xC9,
+    0xF6, 0x46, 0xEE, 0x38, 0x9B, 0x57, 0x85, 0x66, 0x80, 0xC5, 0x27, 0xEF, 0xC7, 0xB5, 0xCD, 0x0C,
+    0xC7
+};
+
+// The same chip after `rekey salt`: new IV and a KDF salt entry (0x08)
+static const uint8_t kGoldenSalted[236] = {
+    0x44, 0x45, 0x52, 0x43, 0x02, 0x00, 0xE0, 0x00, 0xB5, 0xA9, 0xEC, 0x50, 0x01, 0x0B, 0x00, 0x44,
+    0x4F, 0x4C, 0x45, 0x57, 0x4B, 0x41, 0x5F, 0x30, 0x30, 0x32, 0x02, 0x08, 0x00, 0x6B, 0xEA, 0xFF,
+    0x77, 0xD9, 0x05, 0x5D, 0x39, 0x03, 0x10, 0x00, 0xF1, 0x6B, 0x32, 0xC1, 0x9A, 0x89, 0x93, 0xEF,
+    0xAD, 0xA6, 0xEB, 0x4A, 0x53, 0x0F, 0xC3, 0xD8, 0x04, 0x20, 0x00, 0x1C, 0x50, 0x2A, 0x69, 0x8B,
+    0x6F, 0x2C, 0x53, 0xC8, 0xCE, 0x15, 0x5D, 0x5A, 0x87, 0xE8, 0xAF, 0xD2, 0xF1, 0xEE, 0x33, 0xC6,
+    0x54, 0xC1, 0x84, 0x25, 0x8F, 0x9C, 0xB6, 0xBB, 0xD8, 0xE0, 0xDF, 0x05, 0x30, 0x00, 0xE6, 0xCB,
+    0x9C, 0x0F, 0x3B, 0xA8, 0xE4, 0x2F, 0xAD, 0x98, 0x54, 0x10, 0xE8, 0xEA, 0x5B, 0x75, 0x06, 0x5D,
+    0xA9, 0xB0, 0x27, 0xD1, 0x71, 0xEF, 0x47, 0xB6, 0x3A, 0x45, 0xA5, 0xC7, 0x52, 0x2C, 0x25, 0xB4,
+    0x96, 0x5B, 0x87, 0xA6, 0x0F, 0xF0, 0x89, 0x89, 0x54, 0x26, 0x98, 0x4D, 0x69, 0xA7, 0x06, 0x50,
+    0x00, 0xA3, 0x8D, 0xE7, 0x6C, 0x6D, 0x33, 0xDB, 0x3E, 0xB8, 0x9F, 0xB7, 0x4A, 0x4A, 0x98, 0x5E,
+    0xE7, 0x98, 0x04, 0xA6, 0x26, 0xE2, 0xD6, 0xF0, 0x6A, 0x2E, 0x3C, 0x0C, 0x24, 0x94, 0xA8, 0x86,
+    0xA5, 0xA0, 0xAF, 0xC9, 0x35, 0xE3, 0x86, 0xC3, 0x09, 0xAC, 0xCB, 0x7D, 0xF0, 0xE6, 0x84, 0x86,
+    0x49, 0x2F, 0x50, 0x10, 0x5C, 0x8B, 0xCB, 0x07, 0x2E, 0x9F, 0x9A, 0x78, 0xFB, 0xB8, 0x69, 0xB1,
+    0x27, 0x7E, 0xCB, 0x50, 0x20, 0xD1, 0x07, 0x3E, 0x23, 0x27, 0x0D, 0x2D, 0x20, 0x2C, 0xD9, 0x07,
+    0x87, 0x08, 0x08, 0x00, 0x00, 0xAF, 0x12, 0x98, 0x87, 0x63, 0xDA, 0x8B
+};
+
+#endif // GOLDEN_RECORDS_H
@@ -0,0 +1,460 @@
+// lib/fram_cred_reader on the host: known-answer crypto, the golden records
+// the firmware wrote, broken buffers, and the boot path timed step by step.
+// The library itself needs only C++11 (g++ -std=c++11 -Wall -Wextra).
+#include <unity.h>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fram_cred_reader.h>
+#include "golden_records.h"
+
+using namespace fram_cred;
+
+static const char kAdminHashHex[] = "240be518fabd2724ddb6f04eeb1da5967448d7e831c08c8fa822809f74c720a9";
+static const char kV2Token[] = "sha256:7b4f8a9c2d1e3f4a5b6c7d8e9f0a1b2c3d4e5f6a7b8c9d0e1f2a3b4c5d6e7f8a";
+
+static void fromHex(const char* hex, uint8_t* out) {
+    for (size_t i = 0; hex[2 * i]; i++) {
+        unsigned value;
+        sscanf(&hex[2 * i], "%2x", &value);
+        out[i] = (uint8_t)value;
+    }
+}
+
+static void sha256Of(const uint8_t* data, uint32_t len, uint8_t* hash) {
+    detail::Sha256 sha;
+    sha.update(data, len);
+    sha.final(hash);
+}
+
+static void assertSha256(const char* message, const char* expected_hex) {
+    uint8_t expected[32], hash[32];
+    fromHex(expected_hex, expected);
+    sha256Of((const uint8_t*)message, strlen(message), hash);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, hash, 32);
+}
+
+// Decrypt a text field and compare it with the expected plaintext
+static void assertField(const Decryptor& dec, Field id, const char* expected) {
+    char out[256];
+    uint32_t len = sizeof(out) - 1;
+    TEST_ASSERT_TRUE(dec.field(id, (uint8_t*)out, &len));
+    out[len] = '\0';
+    TEST_ASSERT_EQUAL_STRING(expected, out);
+}
+
+static bool spanInside(const Span& span, const uint8_t* data, uint32_t len) {
+    return span.len == 0 || (span.data >= data && span.data + span.len <= data + len);
+}
+
+static void storeLe32(uint8_t* p, uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        p[i] = (uint8_t)(value >> (8 * i));
+    }
+}
+
+// Recompute the v2 CRC so a test reaches the check it means to exercise
+static void resealV2(uint8_t* data, uint32_t size) {
+    uint32_t crc = detail::crc32Update(0, data, 8);
+    crc = detail::crc32Update(crc, data + kV2HeaderSize, size - kV2HeaderSize);
+    storeLe32(data + 8, crc);
+}
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+// FIPS 180-2 appendix B and the usual long-message vector
+void test_sha256_known_answers() {
+    assertSha256("", "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+    assertSha256("abc", "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+    assertSha256("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq",
+                 "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1");
+    
+    static uint8_t million[1000000];
+    memset(million, 'a', sizeof(million));
+    uint8_t expected[32], hash[32];
+    fromHex("cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0", expected);
+    sha256Of(million, sizeof(million), hash);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, hash, 32);
+}
+
+// FIPS 197 appendix C.3 and SP 800-38A F.1.6 (ECB-AES256.Decrypt)
+void test_aes256_known_answers() {
+    uint8_t key[32], in[16], expected[16], out[16];
+    detail::Aes256Decrypt aes;
+    
+    fromHex("000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f", key);
+    aes.setKey(key);
+    fromHex("8ea2b7ca516745bfeafc49904b496089", in);
+    fromHex("00112233445566778899aabbccddeeff", expected);
+    aes.decryptBlock(in, out);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, out, 16);
+    
+    static const char* const blocks[4][2] = {
+        { "f3eed1bdb5d2a03c064b5a7e3db181f8", "6bc1bee22e409f96e93d7e117393172a" },
+        { "591ccb10d410ed26dc5ba74a31362870", "ae2d8a571e03ac9c9eb76fac45af8e51" },
+        { "b6ed21b99ca6f4f9f153e7b1beafed1d", "30c81c46a35ce411e5fbc1191a0a52ef" },
+        { "23304b7a39f9f3ff067d8d8f9e24ecc7", "f69f2445df4f9b17ad2b417be66c3710" }
+    };
+    fromHex("603deb1015ca71be2b73aef0857d77811f352c073b6108d72d9810a30914dff4", key);
+    aes.setKey(key);
+    for (int i = 0; i < 4; i++) {
+        fromHex(blocks[i][0], in);
+        fromHex(blocks[i][1], expected);
+        aes.decryptBlock(in, out);
+        TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, out, 16);
+    }
+}
+
+void test_crc32_check_value() {
+    TEST_ASSERT_EQUAL_HEX32(0xCBF43926, detail::crc32Update(0, (const uint8_t*)"123456789", 9));
+    
+    // Updating in pieces gives the same result as one pass
+    uint32_t crc = detail::crc32Update(0, (const uint8_t*)"1234", 4);
+    TEST_ASSERT_EQUAL_HEX32(0xCBF43926, detail::crc32Update(crc, (const uint8_t*)"56789", 5));
+}
+
+void test_golden_v1() {
+    Record rec;
+    TEST_ASSERT_TRUE(parse(kGoldenV1, sizeof(kGoldenV1), rec));
+    TEST_ASSERT_EQUAL_UINT16(kVersion1, rec.version);
+    TEST_ASSERT_EQUAL_UINT16(kV1Size, rec.size);
+    TEST_ASSERT_EQUAL_UINT16(11, rec.name.len);
+    TEST_ASSERT_EQUAL_MEMORY("DOLEWKA_001", rec.name.data, 11);
+    TEST_ASSERT_EQUAL_UINT16(0, rec.salt.len);
+    TEST_ASSERT_TRUE(rec.admin_hash_hex);
+    TEST_ASSERT_TRUE(check(rec));
+    
+    Decryptor dec(rec);
+    TEST_ASSERT_TRUE(dec.verifyKey());
+    assertField(dec, kWifiSsid, "MyNetwork");
+    assertField(dec, kWifiPassword, "MyPassword");
+    assertField(dec, kAdminHash, kAdminHashHex);
+    assertField(dec, kVpsToken, "sha256:abc123");
+}
+
+void test_golden_v2() {
+    Record rec;
+    TEST_ASSERT_TRUE(parse(kGoldenV2, sizeof(kGoldenV2), rec));
+    TEST_ASSERT_EQUAL_UINT16(kVersion2, rec.version);
+    TEST_ASSERT_EQUAL_UINT16(sizeof(kGoldenV2), rec.size);
+    TEST_ASSERT_EQUAL_UINT16(11, rec.name.len);
+    TEST_ASSERT_EQUAL_MEMORY("DOLEWKA_002", rec.name.data, 11);
+    TEST_ASSERT_EQUAL_UINT16(0, rec.salt.len);
+    TEST_ASSERT_FALSE(rec.admin_hash_hex);
+    TEST_ASSERT_TRUE(check(rec));
+    
+    Decryptor dec(rec);
+    TEST_ASSERT_TRUE(dec.verifyKey());
+    assertField(dec, kWifiSsid, "MyHomeNetwork");
+    assertField(dec, kWifiPassword, "MySecurePassword123");
+    assertField(dec, kVpsToken, kV2Token);
+    
+    // v2 keeps the admin hash as the raw digest
+    uint8_t expected[32], hash[32];
+    uint32_t len = sizeof(hash);
+    fromHex(kAdminHashHex, expected);
+    TEST_ASSERT_TRUE(dec.field(kAdminHash, hash, &len));
+    TEST_ASSERT_EQUAL_UINT32(32, len);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, hash, 32);
+}
+
+void test_golden_salted() {
+    Record rec;
+    TEST_ASSERT_TRUE(parse(kGoldenSalted, sizeof(kGoldenSalted), rec));
+    TEST_ASSERT_EQUAL_UINT16(kVersion2, rec.version);
+    TEST_ASSERT_EQUAL_UINT16(kSaltSize, rec.salt.len);
+    TEST_ASSERT_TRUE(check(rec));
+    
+    Decryptor dec(rec);
+    TEST_ASSERT_TRUE(dec.verifyKey());
+    assertField(dec, kWifiSsid, "MyHomeNetwork");
+    assertField(dec, kWifiPassword, "MySecurePassword123");
+    assertField(dec, kVpsToken, kV2Token);
+    
+    // The salt is part of the key: without it the key check fails
+    Record unsalted = rec;
+    unsalted.salt.len = 0;
+    uint8_t salted_key[kKeySize], unsalted_key[kKeySize];
+    deriveKey(rec, salted_key);
+    deriveKey(unsalted, unsalted_key);
+    TEST_ASSERT_FALSE(memcmp(salted_key, unsalted_key, kKeySize) == 0);
+    TEST_ASSERT_FALSE(Decryptor(unsalted).verifyKey());
+}
+
+// Same credentials, same name: rekey changed the IV, so the ciphertexts differ
+void test_golden_rekey_changed_ciphertext() {
+    Record plain, salted;
+    TEST_ASSERT_TRUE(parse(kGoldenV2, sizeof(kGoldenV2), plain));
+    TEST_ASSERT_TRUE(parse(kGoldenSalted, sizeof(kGoldenSalted), salted));
+    TEST_ASSERT_FALSE(memcmp(plain.iv.data, salted.iv.data, kIvSize) == 0);
+    TEST_ASSERT_EQUAL_UINT16(plain.fields[kWifiSsid].len, salted.fields[kWifiSsid].len);
+    TEST_ASSERT_FALSE(memcmp(plain.fields[kWifiSsid].data, salted.fields[kWifiSsid].data,
+                             plain.fields[kWifiSsid].len) == 0);
+}
+
+void test_check_catches_any_flipped_bit() {
+    static const uint8_t* const records[] = { kGoldenV1, kGoldenV2, kGoldenSalted };
+    static const uint32_t sizes[] = { sizeof(kGoldenV1), sizeof(kGoldenV2), sizeof(kGoldenSalted) };
+    
+    for (int r = 0; r < 3; r++) {
+        uint8_t copy[kMaxRecordSize];
+        memcpy(copy, records[r], sizes[r]);
+        
+        // Past the version field, so the record still parses and check() decides.
+        // v1 bytes after the checksum (496..511) are not covered
+        uint32_t covered = sizes[r] == kV1Size ? 498 : sizes[r];
+        for (uint32_t i = 8; i < covered; i++) {
+            copy[i] ^= 0x01;
+            Record rec;
+            if (parse(copy, sizes[r], rec)) {
+                TEST_ASSERT_FALSE(check(rec));
+            }
+            copy[i] ^= 0x01;
+        }
+    }
+}
+
+void test_truncated_buffers_are_rejected() {
+    Record rec;
+    for (uint32_t len = 0; len < sizeof(kGoldenV1); len++) {
+        TEST_ASSERT_FALSE(parse(kGoldenV1, len, rec));
+        TEST_ASSERT_EQUAL_UINT16(0, rec.version);
+    }
+    for (uint32_t len = 0; len < sizeof(kGoldenV2); len++) {
+        TEST_ASSERT_FALSE(parse(kGoldenV2, len, rec));
+    }
+    for (uint32_t len = 0; len < sizeof(kGoldenSalted); len++) {
+        TEST_ASSERT_FALSE(parse(kGoldenSalted, len, rec));
+    }
+    
+    // A longer buffer (the whole section) is fine; the record knows its size
+    static uint8_t section[kMaxRecordSize];
+    memcpy(section, kGoldenV2, sizeof(kGoldenV2));
+    TEST_ASSERT_TRUE(parse(section, sizeof(section), rec));
+    TEST_ASSERT_EQUAL_UINT16(sizeof(kGoldenV2), rec.size);
+}
+
+void test_malformed_headers_are_rejected() {
+    uint8_t copy[kMaxRecordSize];
+    Record rec;
+    
+    memcpy(copy, kGoldenV2, sizeof(kGoldenV2));
+    copy[0] ^= 0xFF;                            // Magic
+    TEST_ASSERT_FALSE(parse(copy, sizeof(kGoldenV2), rec));
+    
+    memcpy(copy, kGoldenV2, sizeof(kGoldenV2));
+    copy[4] = 3;                                // Unknown version
+    TEST_ASSERT_FALSE(parse(copy, sizeof(kGoldenV2), rec));
+    
+    memcpy(copy, kGoldenV2, sizeof(kGoldenV2));
+    copy[6] = 0xF8;                             // Entries longer than the section
+    copy[7] = 0x03;
+    TEST_ASSERT_FALSE(parse(copy, sizeof(copy), rec));
+    
+    memcpy(copy, kGoldenV1, sizeof(kGoldenV1));
+    copy[8] = 0;                                // Empty v1 device name
+    TEST_ASSERT_FALSE(parse(copy, sizeof(kGoldenV1), rec));
+    
+    memcpy(copy, kGoldenV1, sizeof(kGoldenV1));
+    memset(&copy[8], 'A', 32);                  // v1 name fills its field, no terminator
+    TEST_ASSERT_FALSE(parse(copy, sizeof(kGoldenV1), rec));
+}
+
+// Walk the v2 entries of copy[0, size) and return the offset of the first of 'type'
+static uint32_t findEntry(const uint8_t* data, uint32_t size, uint8_t type) {
+    for (uint32_t pos = kV2HeaderSize; pos + 3 <= size; pos += 3 + detail::le16(data + pos + 1)) {
+        if (data[pos] == type) {
+            return pos;
+        }
+    }
+    return 0;
+}
+
+void test_malformed_entries_are_rejected() {
+    uint8_t copy[kMaxRecordSize];
+    Record rec;
+    
+    // An entry length that runs past the end of the record
+    memcpy(copy, kGoldenV2, sizeof(kGoldenV2));
+    uint32_t ssid = findEntry(copy, sizeof(kGoldenV2), 0x03);
+    TEST_ASSERT_NOT_EQUAL(0, ssid);
+    copy[ssid + 1] = 0xFF;
+    resealV2(copy, sizeof(kGoldenV2));
+    TEST_ASSERT_FALSE(parse(copy, sizeof(kGoldenV2), rec));
+    
+    // A ciphertext that is not a whole number of blocks
+    memcpy(copy, kGoldenV2, sizeof(kGoldenV2));
+    copy[ssid] = 0x7F;                          // Hide the real SSID entry...
+    uint32_t size = sizeof(kGoldenV2);
+    const uint8_t odd[] = { 0x03, 15, 0 };      // ...and add a 15-byte one
+    memcpy(&copy[size], odd, sizeof(odd));
+    memset(&copy[size + 3], 0xAA, 15);
+    size += 3 + 15;
+    copy[6] = (uint8_t)(size - kV2HeaderSize);
+    copy[7] = (uint8_t)((size - kV2HeaderSize) >> 8);
+    resealV2(copy, size);
+    TEST_ASSERT_FALSE(parse(copy, size, rec));
+    
+    // A KDF salt of the wrong size
+    memcpy(copy, kGoldenSalted, sizeof(kGoldenSalted));
+    uint32_t salt = findEntry(copy, sizeof(kGoldenSalted), 0x08);
+    TEST_ASSERT_NOT_EQUAL(0, salt);
+    copy[salt + 1] = kSaltSize - 1;
+    TEST_ASSERT_FALSE(parse(copy, sizeof(kGoldenSalted), rec));
+    
+    // Unknown entry types are skipped
+    memcpy(copy, kGoldenV2, sizeof(kGoldenV2));
+    const uint8_t future[] = { 0x42, 2, 0, 0xDE, 0xAD };
+    memcpy(&copy[sizeof(kGoldenV2)], future, sizeof(future));
+    size = sizeof(kGoldenV2) + sizeof(future);
+    copy[6] = (uint8_t)(size - kV2HeaderSize);
+    copy[7] = (uint8_t)((size - kV2HeaderSize) >> 8);
+    resealV2(copy, size);
+    TEST_ASSERT_TRUE(parse(copy, size, rec));
+    TEST_ASSERT_TRUE(check(rec));
+    assertField(Decryptor(rec), kWifiSsid, "MyHomeNetwork");
+}
+
+// Random bytes behind a valid magic and version must never parse to spans
+// outside the buffer
+void test_garbage_buffers_stay_in_bounds() {
+    uint32_t seed = 12345;
+    static uint8_t buffer[kMaxRecordSize];
+    
+    for (int round = 0; round < 20000; round++) {
+        for (uint32_t i = 0; i < sizeof(buffer); i++) {
+            seed = seed * 1664525u + 1013904223u;
+            buffer[i] = (uint8_t)(seed >> 24);
+        }
+        storeLe32(buffer, kMagic);
+        buffer[4] = (round & 1) ? kVersion1 : kVersion2;
+        buffer[5] = 0;
+        if (!(round & 1)) {
+            buffer[7] &= 0x01;                  // Entry lengths that fit the section
+        }
+        uint32_t len = 8 + (seed % (sizeof(buffer) - 8));
+        
+        Record rec;
+        if (!parse(buffer, len, rec)) {
+            TEST_ASSERT_EQUAL_UINT16(0, rec.version);
+            continue;
+        }
+        
+        TEST_ASSERT_TRUE(rec.size <= len);
+        TEST_ASSERT_TRUE(spanInside(rec.name, buffer, rec.size));
+        TEST_ASSERT_TRUE(spanInside(rec.iv, buffer, rec.size));
+        TEST_ASSERT_TRUE(spanInside(rec.salt, buffer, rec.size));
+        for (uint32_t f = 0; f < kFieldCount; f++) {
+            TEST_ASSERT_TRUE(spanInside(rec.fields[f], buffer, rec.size));
+        }
+        
+        // Decrypting garbage fails or stays within the output buffer
+        uint8_t out[kMaxRecordSize];
+        uint32_t out_len = sizeof(out);
+        Decryptor dec(rec);
+        if (dec.field(kWifiSsid, out, &out_len)) {
+            TEST_ASSERT_TRUE(out_len <= sizeof(out));
+        }
+    }
+}
+
+void test_field_respects_output_capacity() {
+    Record rec;
+    TEST_ASSERT_TRUE(parse(kGoldenV2, sizeof(kGoldenV2), rec));
+    Decryptor dec(rec);
+    
+    uint8_t out[19];
+    uint32_t len = 18;                          // One short of MySecurePassword123
+    TEST_ASSERT_FALSE(dec.field(kWifiPassword, out, &len));
+    
+    len = 19;
+    TEST_ASSERT_TRUE(dec.field(kWifiPassword, out, &len));
+    TEST_ASSERT_EQUAL_UINT32(19, len);
+    TEST_ASSERT_EQUAL_MEMORY("MySecurePassword123", out, 19);
+    
+    TEST_ASSERT_FALSE(dec.field(kFieldCount, out, &len));
+}
+
+void test_wrong_name_fails_key_check() {
+    uint8_t copy[kMaxRecordSize];
+    memcpy(copy, kGoldenV2, sizeof(kGoldenV2));
+    uint32_t name = findEntry(copy, sizeof(kGoldenV2), 0x01);
+    copy[name + 3 + 10] = '3';                  // DOLEWKA_003
+    resealV2(copy, sizeof(kGoldenV2));
+    
+    Record rec;
+    TEST_ASSERT_TRUE(parse(copy, sizeof(kGoldenV2), rec));
+    TEST_ASSERT_TRUE(check(rec));
+    TEST_ASSERT_FALSE(Decryptor(rec).verifyKey());
+}
+
+// Boot path on the host: parse, check, key (SHA-256 + AES key schedule), then
+// the SSID. Reported per step in microseconds; the numbers are for comparing
+// changes to the reader, not a promise about ESP32 timings.
+template <typename Step>
+static double averageUs(int iterations, Step step) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        step();
+    }
+    std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / iterations;
+}
+
+static void benchRecord(const char* label, const uint8_t* data, uint32_t len) {
+    const int iterations = 2000;
+    volatile uint32_t sink = 0;
+    Record rec;
+    
+    double parse_us = averageUs(iterations, [&] { sink += parse(data, len, rec); });
+    double check_us = averageUs(iterations, [&] { sink += check(rec); });
+    double key_us = averageUs(iterations, [&] { Decryptor dec(rec); sink += dec.verifyKey(); });
+    Decryptor dec(rec);
+    double ssid_us = averageUs(iterations, [&] {
+        uint8_t ssid[64];
+        uint32_t ssid_len = sizeof(ssid);
+        sink += dec.field(kWifiSsid, ssid, &ssid_len);
+    });
+    double boot_us = averageUs(iterations, [&] {
+        Record boot;
+        uint8_t ssid[64];
+        uint32_t ssid_len = sizeof(ssid);
+        sink += parse(data, len, boot) && check(boot) && Decryptor(boot).field(kWifiSsid, ssid, &ssid_len);
+    });
+    TEST_ASSERT_EQUAL_UINT32(5 * iterations, sink);
+    
+    char line[160];
+    snprintf(line, sizeof(line), "%-7s parse %6.2f us  check %6.2f us  key %6.2f us  ssid %6.2f us  boot %6.2f us",
+             label, parse_us, check_us, key_us, ssid_us, boot_us);
+    TEST_MESSAGE(line);
+}
+
+void test_benchmark_boot_path() {
+    benchRecord("v1", kGoldenV1, sizeof(kGoldenV1));
+    benchRecord("v2", kGoldenV2, sizeof(kGoldenV2));
+    benchRecord("salted", kGoldenSalted, sizeof(kGoldenSalted));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_sha256_known_answers);
+    RUN_TEST(test_aes256_known_answers);
+    RUN_TEST(test_crc32_check_value);
+    RUN_TEST(test_golden_v1);
+    RUN_TEST(test_golden_v2);
+    RUN_TEST(test_golden_salted);
+    RUN_TEST(test_golden_rekey_changed_ciphertext);
+    RUN_TEST(test_check_catches_any_flipped_bit);
+    RUN_TEST(test_truncated_buffers_are_rejected);
+    RUN_TEST(test_malformed_headers_are_rejected);
+    RUN_TEST(test_malformed_entries_are_rejected);
+    RUN_TEST(test_garbage_buffers_stay_in_bounds);
+    RUN_TEST(test_field_respects_output_capacity);
+    RUN_TEST(test_wrong_name_fails_key_check);
+    RUN_TEST(test_benchmark_boot_path);
+    return UNITY_END();
+}
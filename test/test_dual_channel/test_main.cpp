@@ -0,0 +1,207 @@
+// Dual-channel jobs against two in-memory FRAMs, with a host thread as core 1
+#include <unity.h>
+#include <Arduino.h>
+#include <atomic>
+#include <set>
+#include <thread>
+#include "channel_job.h"
+#include "encryption.h"
+#include "crc32.h"
+
+void loop1();   // core1_worker.cpp
+
+// A chip as a RAM array; remembers which core last bound it
+class MemoryFramBus : public FramBus {
+public:
+    uint8_t mem[FRAM_SIZE];
+    bool present = true;
+    int core = -1;
+    
+    bool begin() override {
+        core = rp2040.cpuid();
+        return present;
+    }
+    
+    bool read(uint16_t addr, uint8_t* data, size_t len) override {
+        if (!present || addr + len > FRAM_SIZE) {
+            return false;
+        }
+        memcpy(data, &mem[addr], len);
+        return true;
+    }
+    
+    bool write(uint16_t addr, const uint8_t* data, size_t len) override {
+        if (!present || addr + len > FRAM_SIZE) {
+            return false;
+        }
+        memcpy(&mem[addr], data, len);
+        return true;
+    }
+};
+
+static MemoryFramBus buses[DUAL_CHANNEL_COUNT];
+static CredentialRecord staging[DUAL_CHANNEL_COUNT];
+static uint8_t images[DUAL_CHANNEL_COUNT][FRAM_SIZE];
+static DeviceCredentials records[DUAL_CHANNEL_COUNT];
+static ChannelResult results[DUAL_CHANNEL_COUNT];
+
+static std::atomic<bool> core1_running(false);
+static std::thread core1;
+
+static unsigned long runPair(DualOperation op) {
+    ChannelJob jobs[DUAL_CHANNEL_COUNT];
+    for (uint8_t ch = 0; ch < DUAL_CHANNEL_COUNT; ch++) {
+        jobs[ch].bus = &buses[ch];
+        jobs[ch].op = op;
+        jobs[ch].record = &records[ch];
+        jobs[ch].staging = &staging[ch];
+        jobs[ch].image = images[ch];
+        jobs[ch].result = &results[ch];
+    }
+    return runChannelPair(jobs);
+}
+
+// The record as stored on a channel's chip
+static bool storedRecord(uint8_t ch, CredentialRecord& rec) {
+    CredentialRecordHeader header;
+    memcpy(&header, &buses[ch].mem[FRAM_CREDENTIALS_ADDR], sizeof(header));
+    rec.size = credentialRecordReadSize(header);
+    memcpy(rec.raw, &buses[ch].mem[FRAM_CREDENTIALS_ADDR], rec.size);
+    return parseCredentialRecord(rec);
+}
+
+void setUp() {
+    for (uint8_t ch = 0; ch < DUAL_CHANNEL_COUNT; ch++) {
+        memset(buses[ch].mem, 0, FRAM_SIZE);
+        buses[ch].present = true;
+        buses[ch].core = -1;
+    }
+    
+    records[0].device_name = "line_a_0001";
+    records[0].wifi_ssid = "factory-a";
+    records[0].wifi_password = "password-a";
+    records[0].admin_password = "admin-a-pass";
+    records[0].vps_token = "token-a";
+    records[1].device_name = "line_b_0001";
+    records[1].wifi_ssid = "factory-b";
+    records[1].wifi_password = "password-b";
+    records[1].admin_password = "admin-b-pass";
+    records[1].vps_token = "token-b";
+}
+
+void tearDown() {
+    Serial.take();
+}
+
+void test_program_runs_each_channel_on_its_core() {
+    runPair(DUAL_PROGRAM);
+    
+    for (uint8_t ch = 0; ch < DUAL_CHANNEL_COUNT; ch++) {
+        TEST_ASSERT_TRUE(results[ch].present);
+        TEST_ASSERT_TRUE(results[ch].ok);
+        TEST_ASSERT_EQUAL_INT(ch, buses[ch].core);
+    }
+}
+
+void test_program_stores_each_channels_record() {
+    runPair(DUAL_PROGRAM);
+    
+    for (uint8_t ch = 0; ch < DUAL_CHANNEL_COUNT; ch++) {
+        static CredentialRecord rec;
+        TEST_ASSERT_TRUE(storedRecord(ch, rec));
+        TEST_ASSERT_EQUAL_UINT16(FRAM_DATA_VERSION_V2, rec.version);
+        
+        DeviceCredentials creds;
+        TEST_ASSERT_TRUE(decryptCredentials(rec, creds));
+        TEST_ASSERT_EQUAL_STRING(records[ch].device_name.c_str(), creds.device_name.c_str());
+        TEST_ASSERT_EQUAL_STRING(records[ch].wifi_ssid.c_str(), creds.wifi_ssid.c_str());
+        TEST_ASSERT_EQUAL_STRING(records[ch].vps_token.c_str(), creds.vps_token.c_str());
+    }
+}
+
+// Both cores encrypt at the same moment; every IV must still be fresh
+void test_concurrent_ivs_never_repeat() {
+    std::set<uint64_t> ivs;
+    const int rounds = 200;
+    
+    for (int i = 0; i < rounds; i++) {
+        runPair(DUAL_PROGRAM);
+        for (uint8_t ch = 0; ch < DUAL_CHANNEL_COUNT; ch++) {
+            static CredentialRecord rec;
+            TEST_ASSERT_TRUE(results[ch].ok);
+            TEST_ASSERT_TRUE(storedRecord(ch, rec));
+            
+            uint64_t iv;
+            memcpy(&iv, credentialField(rec, rec.iv), sizeof(iv));
+            ivs.insert(iv);
+        }
+    }
+    
+    TEST_ASSERT_EQUAL_size_t(rounds * DUAL_CHANNEL_COUNT, ivs.size());
+}
+
+void test_verify_flags_only_the_corrupt_channel() {
+    runPair(DUAL_PROGRAM);
+    buses[1].mem[FRAM_CREDENTIALS_ADDR + 40] ^= 0x01;
+    
+    runPair(DUAL_VERIFY);
+    TEST_ASSERT_TRUE(results[0].ok);
+    TEST_ASSERT_TRUE(results[1].present);
+    TEST_ASSERT_FALSE(results[1].ok);
+}
+
+void test_verify_fails_on_blank_chip() {
+    runPair(DUAL_VERIFY);
+    TEST_ASSERT_FALSE(results[0].ok);
+    TEST_ASSERT_FALSE(results[1].ok);
+}
+
+void test_backup_copies_whole_chip() {
+    for (size_t i = 0; i < FRAM_SIZE; i++) {
+        buses[0].mem[i] = (uint8_t)i;
+        buses[1].mem[i] = (uint8_t)(i * 7 + 3);
+    }
+    
+    runPair(DUAL_BACKUP);
+    
+    for (uint8_t ch = 0; ch < DUAL_CHANNEL_COUNT; ch++) {
+        TEST_ASSERT_TRUE(results[ch].ok);
+        TEST_ASSERT_EQUAL_MEMORY(buses[ch].mem, images[ch], FRAM_SIZE);
+        TEST_ASSERT_EQUAL_HEX32(crc32(buses[ch].mem, FRAM_SIZE), results[ch].crc);
+    }
+    TEST_ASSERT_NOT_EQUAL(results[0].crc, results[1].crc);
+}
+
+void test_missing_chip_leaves_other_channel_working() {
+    buses[1].present = false;
+    
+    runPair(DUAL_PROGRAM);
+    TEST_ASSERT_TRUE(results[0].present);
+    TEST_ASSERT_TRUE(results[0].ok);
+    TEST_ASSERT_FALSE(results[1].present);
+    TEST_ASSERT_FALSE(results[1].ok);
+}
+
+int main() {
+    // Core 1 polls for jobs like arduino-pico's loop1()
+    core1_running = true;
+    core1 = std::thread([] {
+        while (core1_running) {
+            loop1();
+        }
+    });
+    
+    UNITY_BEGIN();
+    RUN_TEST(test_program_runs_each_channel_on_its_core);
+    RUN_TEST(test_program_stores_each_channels_record);
+    RUN_TEST(test_concurrent_ivs_never_repeat);
+    RUN_TEST(test_verify_flags_only_the_corrupt_channel);
+    RUN_TEST(test_verify_fails_on_blank_chip);
+    RUN_TEST(test_backup_copies_whole_chip);
+    RUN_TEST(test_missing_chip_leaves_other_channel_working);
+    int failures = UNITY_END();
+    
+    core1_running = false;
+    core1.join();
+    return failures;
+}
@@ -0,0 +1,256 @@
+// hex_codec on the host: round trips, error positions, number fields, and the
+// console helpers against the per-byte Serial.print path they replaced
+#include <unity.h>
+#include <Arduino.h>
+#include <chrono>
+#include <string>
+#include "hex_codec.h"
+#include "console_out.h"
+
+// The dump/backup code before hex_codec: up to two Serial calls per byte
+static void legacyPrintHex(const uint8_t* data, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        if (data[i] < 16) Serial.print("0");
+        Serial.print(data[i], HEX);
+    }
+}
+
+static void fillPattern(uint8_t* data, size_t len, uint32_t seed) {
+    for (size_t i = 0; i < len; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        data[i] = (uint8_t)(seed >> 24);
+    }
+}
+
+static std::string consoleOutput() {
+    Console.flush();
+    return Serial.take();
+}
+
+void setUp() {
+    consoleOutput();
+}
+
+void tearDown() {
+}
+
+void test_every_byte_round_trips() {
+    uint8_t bytes[256];
+    for (int i = 0; i < 256; i++) {
+        bytes[i] = i;
+    }
+    
+    static char text[2 * 256 + 1];
+    TEST_ASSERT_EQUAL_size_t(512, hexEncode(bytes, sizeof(bytes), text));
+    TEST_ASSERT_EQUAL_STRING_LEN("000102030405060708090A0B0C0D0E0F10", text, 34);
+    TEST_ASSERT_EQUAL_STRING("FCFDFEFF", &text[504]);
+    
+    uint8_t decoded[256];
+    size_t decoded_len = 0, error_pos = 0;
+    TEST_ASSERT_TRUE(hexDecode(text, 512, decoded, sizeof(decoded), &decoded_len, &error_pos));
+    TEST_ASSERT_EQUAL_size_t(256, decoded_len);
+    TEST_ASSERT_EQUAL_MEMORY(bytes, decoded, 256);
+}
+
+// Every length from 0 to 300 bytes, so both the eight-character steps and the
+// tail loop see every alignment
+void test_round_trip_all_lengths() {
+    static uint8_t data[300], decoded[300];
+    static char text[2 * 300 + 1];
+    fillPattern(data, sizeof(data), 7);
+    
+    for (size_t len = 0; len <= sizeof(data); len++) {
+        size_t text_len = hexEncode(data, len, text);
+        TEST_ASSERT_EQUAL_size_t(2 * len, text_len);
+        TEST_ASSERT_EQUAL_size_t(text_len, strlen(text));
+        
+        size_t decoded_len = 1234, error_pos = 0;
+        TEST_ASSERT_TRUE(hexDecode(text, text_len, decoded, len, &decoded_len, &error_pos));
+        TEST_ASSERT_EQUAL_size_t(len, decoded_len);
+        TEST_ASSERT_EQUAL_MEMORY(data, decoded, len);
+    }
+}
+
+void test_separator() {
+    const uint8_t data[] = { 0x00, 0x7F, 0xA5 };
+    char text[3 * sizeof(data) + 1];
+    TEST_ASSERT_EQUAL_size_t(9, hexEncode(data, sizeof(data), text, ' '));
+    TEST_ASSERT_EQUAL_STRING("00 7F A5 ", text);
+}
+
+void test_decode_accepts_either_case() {
+    uint8_t out[8];
+    size_t out_len = 0, error_pos = 0;
+    TEST_ASSERT_TRUE(hexDecode("deadBEEFcafeF00d", 16, out, sizeof(out), &out_len, &error_pos));
+    const uint8_t expected[] = { 0xDE, 0xAD, 0xBE, 0xEF, 0xCA, 0xFE, 0xF0, 0x0D };
+    TEST_ASSERT_EQUAL_size_t(8, out_len);
+    TEST_ASSERT_EQUAL_MEMORY(expected, out, 8);
+}
+
+// A bad character anywhere is reported at its own index, whether it falls in
+// an eight-character step or in the tail
+void test_error_position_of_every_character() {
+    const char valid[] = "00112233445566778899AABBCCDDEEFF0123456789";
+    const size_t len = strlen(valid);
+    // Neighbours of the digit and letter ranges, a control character and a high byte
+    const char bad[] = { 'G', 'g', '/', ':', '@', '`', ' ', '\0', (char)0xC3 };
+    
+    char text[64];
+    uint8_t out[32];
+    for (size_t pos = 0; pos < len; pos++) {
+        for (size_t b = 0; b < sizeof(bad); b++) {
+            memcpy(text, valid, len);
+            text[pos] = bad[b];
+            size_t out_len = 0, error_pos = 1234;
+            TEST_ASSERT_FALSE(hexDecode(text, len, out, sizeof(out), &out_len, &error_pos));
+            TEST_ASSERT_EQUAL_size_t(pos, error_pos);
+        }
+    }
+}
+
+void test_first_bad_character_wins() {
+    uint8_t out[16];
+    size_t out_len = 0, error_pos = 0;
+    TEST_ASSERT_FALSE(hexDecode("0123zz67x9", 10, out, sizeof(out), &out_len, &error_pos));
+    TEST_ASSERT_EQUAL_size_t(4, error_pos);
+    TEST_ASSERT_FALSE(hexDecode("01234567xz", 10, out, sizeof(out), &out_len, &error_pos));
+    TEST_ASSERT_EQUAL_size_t(8, error_pos);
+}
+
+void test_length_errors() {
+    uint8_t out[4];
+    size_t out_len = 0, error_pos = 0;
+    
+    // Odd length: the dangling character's index is hex_len
+    TEST_ASSERT_FALSE(hexDecode("123", 3, out, sizeof(out), &out_len, &error_pos));
+    TEST_ASSERT_EQUAL_size_t(3, error_pos);
+    TEST_ASSERT_FALSE(hexDecode("0123456", 7, out, sizeof(out), &out_len, &error_pos));
+    TEST_ASSERT_EQUAL_size_t(7, error_pos);
+    
+    // More than fits: the first character past cap bytes
+    TEST_ASSERT_FALSE(hexDecode("112233", 6, out, 2, &out_len, &error_pos));
+    TEST_ASSERT_EQUAL_size_t(4, error_pos);
+    TEST_ASSERT_FALSE(hexDecode("00112233445566778899", 20, out, sizeof(out), &out_len, &error_pos));
+    TEST_ASSERT_EQUAL_size_t(8, error_pos);
+    TEST_ASSERT_FALSE(hexDecode("001122334", 9, out, sizeof(out), &out_len, &error_pos));
+    TEST_ASSERT_EQUAL_size_t(8, error_pos);         // Overflow is reported before odd length
+    
+    // Nothing at all is a valid, empty decode
+    TEST_ASSERT_TRUE(hexDecode("", 0, out, sizeof(out), &out_len, &error_pos));
+    TEST_ASSERT_EQUAL_size_t(0, out_len);
+}
+
+void test_parse_number() {
+    uint32_t value = 0;
+    TEST_ASSERT_TRUE(hexParseNumber("0", 1, &value));
+    TEST_ASSERT_EQUAL_HEX32(0, value);
+    TEST_ASSERT_TRUE(hexParseNumber("7e00", 4, &value));
+    TEST_ASSERT_EQUAL_HEX32(0x7E00, value);
+    TEST_ASSERT_TRUE(hexParseNumber("FFFFFFFF", 8, &value));
+    TEST_ASSERT_EQUAL_HEX32(0xFFFFFFFF, value);
+    
+    value = 0x1234;
+    TEST_ASSERT_FALSE(hexParseNumber("", 0, &value));
+    TEST_ASSERT_FALSE(hexParseNumber("zz", 2, &value));
+    TEST_ASSERT_FALSE(hexParseNumber("12 ", 3, &value));
+    TEST_ASSERT_FALSE(hexParseNumber("0x10", 4, &value));
+    TEST_ASSERT_FALSE(hexParseNumber("100000000", 9, &value));
+    TEST_ASSERT_EQUAL_HEX32(0x1234, value);     // Untouched on failure
+}
+
+// The console helpers and a plain encode give exactly what the per-byte path printed
+void test_console_helpers_match_legacy_output() {
+    static uint8_t data[1000];
+    static char text[2 * sizeof(data) + 1];
+    fillPattern(data, sizeof(data), 99);
+    data[0] = 0x00;
+    data[1] = 0x0F;
+    
+    for (size_t len : { (size_t)0, (size_t)1, (size_t)31, (size_t)32, (size_t)64, (size_t)129, sizeof(data) }) {
+        legacyPrintHex(data, len);
+        std::string legacy = Serial.take();
+        
+        printHex(data, len);
+        TEST_ASSERT_EQUAL_STRING(legacy.c_str(), consoleOutput().c_str());
+        
+        printHexLine("DATA:", data, len);
+        TEST_ASSERT_EQUAL_STRING(("DATA:" + legacy + "\r\n").c_str(), consoleOutput().c_str());
+        
+        hexEncode(data, len, text);
+        TEST_ASSERT_EQUAL_STRING(legacy.c_str(), text);
+    }
+}
+
+// Host timings; Serial calls are what costs on the board (one USB transfer each)
+void test_benchmark_against_legacy_print() {
+    static uint8_t data[1024];
+    static char text[2 * sizeof(data) + 1];
+    static uint8_t decoded[sizeof(data)];
+    fillPattern(data, sizeof(data), 3);
+    
+    const int rounds = 200;
+    size_t decoded_len = 0, error_pos = 0;
+    auto now = [] { return std::chrono::steady_clock::now(); };
+    auto usPerRound = [&](std::chrono::steady_clock::time_point start) {
+        std::chrono::duration<double, std::micro> elapsed = now() - start;
+        return elapsed.count() / rounds;
+    };
+    
+    size_t calls = Serial.writeCalls();
+    auto start = now();
+    for (int r = 0; r < rounds; r++) {
+        legacyPrintHex(data, sizeof(data));
+    }
+    double legacy_us = usPerRound(start);
+    size_t legacy_calls = (Serial.writeCalls() - calls) / rounds;
+    Serial.take();
+    
+    calls = Serial.writeCalls();
+    start = now();
+    for (int r = 0; r < rounds; r++) {
+        printHex(data, sizeof(data));
+        Console.flush();
+    }
+    double console_us = usPerRound(start);
+    size_t console_calls = (Serial.writeCalls() - calls) / rounds;
+    Serial.take();
+    
+    start = now();
+    for (int r = 0; r < rounds; r++) {
+        hexEncode(data, sizeof(data), text);
+    }
+    double encode_us = usPerRound(start);
+    
+    start = now();
+    for (int r = 0; r < rounds; r++) {
+        hexDecode(text, 2 * sizeof(data), decoded, sizeof(decoded), &decoded_len, &error_pos);
+    }
+    double decode_us = usPerRound(start);
+    TEST_ASSERT_EQUAL_MEMORY(data, decoded, sizeof(data));
+    
+    // Calls are deterministic: legacy makes 1-2 per byte, printHex one per full buffer
+    TEST_ASSERT_TRUE(legacy_calls >= sizeof(data));
+    TEST_ASSERT_TRUE(console_calls <= (2 * sizeof(data)) / CONSOLE_BUFFER_SIZE + 1);
+    
+    char line[160];
+    snprintf(line, sizeof(line), "1 KB: Serial.print per byte %.1f us in %u calls, printHex %.1f us in %u calls",
+             legacy_us, (unsigned)legacy_calls, console_us, (unsigned)console_calls);
+    TEST_MESSAGE(line);
+    snprintf(line, sizeof(line), "1 KB: hexEncode %.2f us, hexDecode %.2f us", encode_us, decode_us);
+    TEST_MESSAGE(line);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_every_byte_round_trips);
+    RUN_TEST(test_round_trip_all_lengths);
+    RUN_TEST(test_separator);
+    RUN_TEST(test_decode_accepts_either_case);
+    RUN_TEST(test_error_position_of_every_character);
+    RUN_TEST(test_first_bad_character_wins);
+    RUN_TEST(test_length_errors);
+    RUN_TEST(test_parse_number);
+    RUN_TEST(test_console_helpers_match_legacy_output);
+    RUN_TEST(test_benchmark_against_legacy_print);
+    return UNITY_END();
+}
@@ -0,0 +1,186 @@
+// The partition table against chips swapped in the socket between commands:
+// what reloadPartitions() and partitionRanges() hand to backup and wipe
+#include <unity.h>
+#include <Arduino.h>
+#include <Adafruit_FRAM_I2C.h>
+#include "crc32.h"
+
+// Built into this suite rather than listed in env:native: it needs the FRAM
+// driver object, the scrub write hook and the range CRC, which fram_programmer.cpp
+// and fram_scrub.cpp provide over the I2C bus and the other suites do without
+#include "../../src/partition_table.cpp"
+
+Adafruit_FRAM_I2C fram;
+
+void scrubNoteWrite(uint16_t addr, size_t len) {
+    (void)addr;
+    (void)len;
+}
+
+bool crcFRAM(uint16_t addr, size_t len, uint32_t* crc) {
+    if ((size_t)addr + len > fram.chip_size) {
+        return false;
+    }
+    *crc = crc32(&fram.chip[addr], len);
+    return true;
+}
+
+static uint8_t chip_a[FRAM_SIZE];   // Default table
+static uint8_t chip_b[FRAM_SIZE];   // Blank
+static uint8_t chip_c[FRAM_SIZE];   // Another table
+
+static void insert(uint8_t* chip) {
+    fram.chip = chip;
+    fram.chip_size = chip ? FRAM_SIZE : 0;
+}
+
+static void assertRange(const ByteRange& range, uint16_t addr, uint16_t len) {
+    TEST_ASSERT_EQUAL_HEX16(addr, range.addr);
+    TEST_ASSERT_EQUAL_HEX16(len, range.len);
+}
+
+static void assertWholeChip(uint8_t flags) {
+    ByteRange ranges[PART_MAX];
+    TEST_ASSERT_EQUAL_UINT8(1, partitionRanges(flags, ranges, PART_MAX));
+    TEST_ASSERT_EQUAL_HEX16(0, ranges[0].addr);
+    TEST_ASSERT_EQUAL_UINT32(FRAM_SIZE, ranges[0].len);
+}
+
+// The default map, as the firmware's 'part init' writes it
+static void assertDefaultRanges() {
+    ByteRange ranges[PART_MAX];
+    TEST_ASSERT_EQUAL_UINT8(2, partitionRanges(PART_FLAG_BACKUP, ranges, PART_MAX));
+    assertRange(ranges[0], 0x0000, 0x0418);         // boot and creds merged
+    assertRange(ranges[1], 0x0420, 0x61E0);         // profile
+    TEST_ASSERT_EQUAL_UINT8(3, partitionRanges(PART_FLAG_WIPE, ranges, PART_MAX));
+    assertRange(ranges[0], 0x0018, 0x0400);         // creds
+    assertRange(ranges[1], 0x0420, 0x61E0);         // profile
+    assertRange(ranges[2], 0x7000, 0x0C00);         // scratch
+}
+
+// A table with one backup partition and two wipe partitions apart
+static void writeOtherTable(uint8_t* chip) {
+    Superblock sb;
+    memset(&sb, 0, sizeof(sb));
+    sb.magic = PART_TABLE_MAGIC;
+    sb.version = PART_TABLE_VERSION;
+    sb.count = 3;
+    sb.entries[0] = { "keys",  0x0100, 0x0200, PART_TYPE_CREDENTIALS, PART_FLAG_BACKUP | PART_FLAG_WIPE, 0, 0 };
+    sb.entries[1] = { "log",   0x4000, 0x1000, PART_TYPE_DATA,        PART_FLAG_WIPE,                    0, 0 };
+    sb.entries[2] = { "super", 0x7E00, 0x0100, PART_TYPE_SYSTEM,      0,                                 0, 0 };
+    sb.table_crc = crc32((const uint8_t*)sb.entries, sb.count * sizeof(PartitionEntry));
+    memcpy(&chip[PART_TABLE_ADDR], &sb, sizeof(sb));
+}
+
+void setUp() {
+    memset(chip_a, 0, sizeof(chip_a));
+    memset(chip_b, 0, sizeof(chip_b));
+    memset(chip_c, 0, sizeof(chip_c));
+    
+    insert(chip_a);
+    TEST_ASSERT_TRUE(writeDefaultPartitions());
+    writeOtherTable(chip_c);
+}
+
+void tearDown() {
+    insert(nullptr);
+    reloadPartitions();
+}
+
+void test_reload_reads_table_of_chip_present() {
+    TEST_ASSERT_TRUE(reloadPartitions());
+    TEST_ASSERT_TRUE(partitionsLoaded());
+    TEST_ASSERT_EQUAL_UINT8(7, partitionTable().count);
+    assertDefaultRanges();
+}
+
+// The bug behind the fix: the table cached from the boot chip was used for a
+// swapped-in blank chip, so 'wipe all' stopped at the boot chip's ranges
+void test_blank_chip_after_table_chip_is_whole_fram() {
+    TEST_ASSERT_TRUE(reloadPartitions());
+    
+    insert(chip_b);
+    TEST_ASSERT_FALSE(reloadPartitions());
+    TEST_ASSERT_FALSE(partitionsLoaded());
+    TEST_ASSERT_NULL(findPartition("creds"));
+    TEST_ASSERT_NULL(findPartitionByType(PART_TYPE_SCRATCH));
+    assertWholeChip(PART_FLAG_WIPE);
+    assertWholeChip(PART_FLAG_BACKUP);
+}
+
+void test_chip_with_other_table_gets_its_own_ranges() {
+    TEST_ASSERT_TRUE(reloadPartitions());
+    
+    insert(chip_c);
+    TEST_ASSERT_TRUE(reloadPartitions());
+    TEST_ASSERT_EQUAL_UINT8(3, partitionTable().count);
+    TEST_ASSERT_NULL(findPartition("creds"));
+    TEST_ASSERT_NOT_NULL(findPartition("keys"));
+    
+    ByteRange ranges[PART_MAX];
+    TEST_ASSERT_EQUAL_UINT8(1, partitionRanges(PART_FLAG_BACKUP, ranges, PART_MAX));
+    assertRange(ranges[0], 0x0100, 0x0200);
+    TEST_ASSERT_EQUAL_UINT8(2, partitionRanges(PART_FLAG_WIPE, ranges, PART_MAX));
+    assertRange(ranges[0], 0x0100, 0x0200);
+    assertRange(ranges[1], 0x4000, 0x1000);
+    
+    // And back: the first chip's map returns with it
+    insert(chip_a);
+    TEST_ASSERT_TRUE(reloadPartitions());
+    assertDefaultRanges();
+}
+
+// A superblock that fails its CRC or overlaps itself is no table at all
+void test_damaged_superblock_is_whole_fram() {
+    chip_a[PART_TABLE_ADDR + offsetof(Superblock, entries) + 9] ^= 0x01;
+    TEST_ASSERT_FALSE(reloadPartitions());
+    assertWholeChip(PART_FLAG_WIPE);
+    
+    writeOtherTable(chip_c);
+    Superblock sb;
+    memcpy(&sb, &chip_c[PART_TABLE_ADDR], sizeof(sb));
+    sb.entries[1].offset = 0x0200;                  // Now overlaps "keys"
+    sb.table_crc = crc32((const uint8_t*)sb.entries, sb.count * sizeof(PartitionEntry));
+    memcpy(&chip_c[PART_TABLE_ADDR], &sb, sizeof(sb));
+    insert(chip_c);
+    TEST_ASSERT_FALSE(reloadPartitions());
+    assertWholeChip(PART_FLAG_BACKUP);
+}
+
+// An empty socket reads as no table rather than keeping the last one
+void test_empty_socket_drops_table() {
+    TEST_ASSERT_TRUE(reloadPartitions());
+    insert(nullptr);
+    TEST_ASSERT_FALSE(reloadPartitions());
+    TEST_ASSERT_FALSE(partitionsLoaded());
+}
+
+// Seals are checked against the chip present, not the one sealed
+void test_seal_follows_chip() {
+    memset(&chip_a[0x0018], 0x5A, 0x0400);
+    TEST_ASSERT_TRUE(sealPartitions("creds"));
+    TEST_ASSERT_TRUE(verifyPartitions());
+    
+    // Same table, different contents: the seal comes with the table
+    memcpy(chip_b, chip_a, FRAM_SIZE);
+    chip_b[0x0100] ^= 0xFF;
+    insert(chip_b);
+    TEST_ASSERT_TRUE(reloadPartitions());
+    TEST_ASSERT_FALSE(verifyPartitions());
+    
+    // A chip without seals has nothing to check
+    insert(chip_c);
+    TEST_ASSERT_TRUE(reloadPartitions());
+    TEST_ASSERT_TRUE(verifyPartitions());
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_reload_reads_table_of_chip_present);
+    RUN_TEST(test_blank_chip_after_table_chip_is_whole_fram);
+    RUN_TEST(test_chip_with_other_table_gets_its_own_ranges);
+    RUN_TEST(test_damaged_superblock_is_whole_fram);
+    RUN_TEST(test_empty_socket_drops_table);
+    RUN_TEST(test_seal_follows_chip);
+    return UNITY_END();
+}